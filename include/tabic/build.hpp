@@ -18,15 +18,44 @@ limitations under the License.
 
 #include"tabic/model/model.hpp"
 
+#include<functional>
+
 namespace tabic
 {
     /** @brief Builds the given Bundle.
      *
      * To build a Bundle, is to construct all of the LLVM Modules which correspond to it.
      *
+     * The functions are built a Slab at a time. Once they are, nothing more is added to the Slab's Module. 
+     *
+     * @param bundle The Bundle to be built.
+     * @param slabBuilt If given, called with each Slab once its Module is complete, so that it may be written while the next is built.
+     */
+    void buildBundle(Bundle* bundle, std::function<void(Slab*)> slabBuilt = nullptr);
+
+    /** @brief Builds the given Bundle on several threads, given `-j N`. 
+     *
+     * LLVM types and modules belong to the LLVMContext of the thread building them, and so does each model's build state. 
+     * So each thread builds a copy of the Bundle of its own: the globals of the whole Bundle, 
+     * then the functions of whichever Slab no thread has taken yet. The calling thread is one of them, building \p bundle. 
+     *
      * @param bundle The Bundle to be built.
+     * @param numThreads The number of threads to build with, counting the calling thread.
+     * @param copyBundle Creates and parses a copy of \p bundle, on the thread which is to build it, or returns `nullptr` if it could not. 
+     * @param slabBuilt If given, called (on the thread which built it) with each Slab whose Module is complete.
      */
-    void buildBundle(Bundle* bundle);
+    void buildBundleInParallel(Bundle* bundle, int numThreads, std::function<Bundle*()> copyBundle, std::function<void(Slab*)> slabBuilt = nullptr);
+
+    /** @brief Builds everything of the given Bundle but the bodies of its functions.
+     *
+     * That is, the LLVM Module of each Slab, the Types, Context and Dump, `_tabi_init` and `_tabi_destroy`, 
+     * and the declaration of every function. The functions of each Slab may then be built, in any order, by buildSlabFunctions.
+     */
+    void buildBundleGlobals(Bundle* bundle);
+
+    /** @brief Builds the functions of the given Slab, after which nothing more is added to its Module.
+     */
+    void buildSlabFunctions(Slab* slab);
 
     /** @brief Build the given CollectionType.
      *
@@ -68,6 +97,162 @@ namespace tabic
      */
     llvm::Value* allocateStackVectorElements(Type* vecType, TabithaFunction* hostFunction);
 
+    /** @brief Widens a count (of rows or elements) to Size, so that the byte sizes computed from it cannot overflow. 
+     *
+     * Counts are Int (or any integer type the user gives), while allocations and copies take Size. 
+     */
+    llvm::Value* buildSizeCast(llvm::Value* count);
+
+    /** @brief Builds the number of elements to be allocated for a field of a table, as a Size. 
+     *
+     * This is the number of rows, except for the `#use` bitmap and the `#index` field (which also holds the runtime's free id stack). 
+     *
+     * @param tableType The TableType to which the field belongs. 
+     * @param fieldIndex The index of the field within `tableType->table.parse.fields`. 
+     */
+    llvm::Value* buildTableFieldLength(Type* tableType, int fieldIndex); 
+
+    /** @brief Builds the current number of rows of a table. 
+     *
+     * This is the constant given in the TableType, unless the table is growable, in which case 
+     * it is read from the header of the table's `#index` field. 
+     *
+     * @param tableType The TableType of the table. 
+     * @param tableStore The LLVM Value storing the table. 
+     */
+    llvm::Value* buildTableNumRows(Type* tableType, llvm::Value* tableStore); 
+
+    /** @brief Builds an array holding the size of each of a table's user fields, as expected by tabi_core. 
+     *
+     * The array is a private constant of the slab's module, so no stack is used where it is built. 
+     * For a `row major` table this is the size of a record, which tabi_core treats as the only field. 
+     *
+     * @param tableType The TableType of the table. 
+     * @param hostSlab The Slab in which the array is built. 
+     */
+    llvm::Value* buildTableFieldSizes(Type* tableType, Slab* hostSlab);
+
+    /** @brief Returns the number of arrays holding a table's user fields, i.e. the number of sizes built by buildTableFieldSizes. 
+     *
+     * @param tableType The TableType of the table. 
+     */
+    int getTableNumArrays(Type* tableType); 
+
+    /** @brief Returns the most rows a growable table grows to, which is less for a table with a hash index. 
+     *
+     * @param tableType The TableType of the table. 
+     */
+    int getTableMaxRows(Type* tableType); 
+
+    /** @brief Returns the LLVM type of the elements of the array a table keeps in place of a given field. 
+     *
+     * This is the field's own type, except for the first user field of a `row major` table, whose array holds the records. 
+     *
+     * @param tableType The TableType of the table. 
+     * @param fieldIndex The index of the field. 
+     */
+    llvm::Type* getTableArrayElemType(Type* tableType, int fieldIndex); 
+
+    /** @brief Builds a pointer to the element of a field in a given row, whatever the table's layout. 
+     *
+     * @param tableType The TableType of the table. 
+     * @param tableStore The LLVM Value storing the table. 
+     * @param fieldIndex The index of the field. 
+     * @param row The row (not the id) of the element. 
+     */
+    llvm::Value* buildTableElementStore(Type* tableType, llvm::Value* tableStore, int fieldIndex, llvm::Value* row); 
+
+    /** @brief Builds a pointer to where a table keeps the pointer to one of its hash indexes.
+     *
+     * @param tableType The TableType of the table.
+     * @param tableStore The LLVM Value storing the table.
+     * @param hashIndex The position of the `indexed` field in tableType->parse.indexedFields.
+     */
+    llvm::Value* buildTableHashStore(Type* tableType, llvm::Value* tableStore, int hashIndex);
+
+    /** @brief Loads the index, the field (as a `Char` pointer) and the key size, and optionally the `#use` field,
+     * which are the leading arguments of the core_hash functions.
+     *
+     * @param tableType The TableType of the table.
+     * @param tableStore The LLVM Value storing the table.
+     * @param hostSlab The Slab in which the arguments are built.
+     * @param hashIndex The position of the `indexed` field in tableType->parse.indexedFields.
+     * @param useField Whether the `#use` field is needed.
+     */
+    std::vector<llvm::Value*> buildTableHashArgs(Type* tableType, llvm::Value* tableStore, Slab* hostSlab, int hashIndex, bool useField);
+
+    /** @brief Builds a pointer to where a table keeps the pointer to one of its ordered indexes.
+     *
+     * @param tableType The TableType of the table.
+     * @param tableStore The LLVM Value storing the table.
+     * @param treeIndex The position of the `ordered` field in tableType->parse.orderedFields.
+     */
+    llvm::Value* buildTableTreeStore(Type* tableType, llvm::Value* tableStore, int treeIndex);
+
+    /** @brief Loads the index and the field (as a `Char` pointer), and optionally the `#use` field,
+     * which are the leading arguments of the core_btree functions.
+     *
+     * @param tableType The TableType of the table.
+     * @param tableStore The LLVM Value storing the table.
+     * @param treeIndex The position of the `ordered` field in tableType->parse.orderedFields.
+     * @param useField Whether the `#use` field is needed.
+     */
+    std::vector<llvm::Value*> buildTableTreeArgs(Type* tableType, llvm::Value* tableStore, int treeIndex, bool useField);
+
+    /** @brief Allocates and initialises a hash index for each `indexed` field, and an ordered index for each `ordered` field, of a table.
+     *
+     * @param tableType The TableType of the table.
+     * @param tableStore The LLVM Value storing the table.
+     * @param hostSlab The Slab in which the allocation is built.
+     * @param stacked Whether the indexes go on the stack, rather than being allocated by tabi_core.
+     * @param arena The store of the Arena the indexes are allocated in, if any. 
+     */
+    void allocateTableKeyIndexes(Type* tableType, llvm::Value* tableStore, Slab* hostSlab, bool stacked, llvm::Value* arena = nullptr);
+
+    /** @brief Inserts a row into, or removes it from, the hash and ordered indexes of a table.
+     *
+     * A row must be removed before the value of an `indexed` or `ordered` field changes, and inserted again afterwards.
+     *
+     * @param tableType The TableType of the table.
+     * @param tableStore The LLVM Value storing the table.
+     * @param hostSlab The Slab in which the update is built.
+     * @param row The row (not the ID) to be inserted or removed.
+     * @param insert Whether to insert, rather than remove, the row.
+     * @param fieldIndex If not `-1`, only the index of this field is updated.
+     */
+    void buildTableKeyIndexUpdate(Type* tableType, llvm::Value* tableStore, Slab* hostSlab, llvm::Value* row, bool insert, int fieldIndex = -1);
+
+    /** @brief Rebuilds the hash and ordered indexes of a table from its used rows, as is needed once rows have moved.
+     *
+     * @param tableType The TableType of the table.
+     * @param tableStore The LLVM Value storing the table.
+     * @param hostSlab The Slab in which the rebuild is built.
+     */
+    void buildTableKeyIndexRebuild(Type* tableType, llvm::Value* tableStore, Slab* hostSlab);
+
+    /** @brief Returns the store of the profile counters (see TableType::PROFILE_INSERTS) of a context table, as seen from \p hostSlab.
+     *
+     * The counters are a global `[TableType::PROFILE_NUM_COUNTERS x Long]`, defined by buildContext when tabic is given `--profile-tables`. 
+     */
+    llvm::Value* buildTableProfileStore(ContextVariable* variable, Slab* hostSlab);
+
+    /** @brief Adds to one of the profile counters of a table, if tables are being profiled and the table is a context variable. 
+     *
+     * @param tableRef The (built) ValueRef of the table.
+     * @param counter The counter, e.g. TableType::PROFILE_INSERTS.
+     * @param amount The Long to be added, or null to add one.
+     */
+    void buildTableProfileCount(ValueRef* tableRef, int counter, llvm::Value* amount = nullptr);
+
+    /** @brief Grows the hash and ordered indexes of a growable table to suit its (new) number of rows.
+     *
+     * @param tableType The TableType of the table.
+     * @param tableStore The LLVM Value storing the table.
+     * @param hostSlab The Slab in which the calls are built.
+     * @param numRows The number of rows the table now has.
+     */
+    void buildTableKeyIndexReserve(Type* tableType, llvm::Value* tableStore, Slab* hostSlab, llvm::Value* numRows);
+
     /** @brief Allocates the memory taken up by stack table fields. 
      *
      * @param tableType - The TableType of the variable to which the fields belong. 
@@ -89,8 +274,21 @@ namespace tabic
      * @param type The Type according to which the memory is to be structured. 
      * @param hostFunction The TabithaFunction in which the data is declared.
      * @param name The name of the variable (empty if it is a sub object). 
+     * @param arena The store of the Arena to allocate in, or null to allocate each part on its own. 
+     */
+    llvm::Value* allocateHeapType(Type* type, TabithaFunction* hostFunction, std::string name = "", llvm::Value* arena = nullptr); 
+
+    /** @brief Returns whether the (built) \p type is `Arena`, or an alias of it. 
+     */
+    bool isArenaType(Type* type); 
+
+    /** @brief Builds a call allocating \p numBytes (a Size) on the heap, and returns the address. 
+     *
+     * @param hostSlab The Slab in which the allocation is built.
+     * @param aligned Whether the memory must be aligned to TabiCore::ALIGNMENT, as element arrays are. 
+     * @param arena The store of the Arena to allocate in, or null to allocate with `core_alloc`. 
      */
-    llvm::Value* allocateHeapType(Type* type, TabithaFunction* hostFunction, std::string name = ""); 
+    llvm::Value* buildHeapAlloc(Slab* hostSlab, llvm::Value* numBytes, bool aligned, llvm::Value* arena); 
 
     void allocateContextType(Type* type, Slab* hostSlab, llvm::Value* store, std::string name = ""); 
 
@@ -107,8 +305,9 @@ namespace tabic
      * @param collectionType The CollectionType whose members we scan for vectors (and other collection types). 
      * @param store The `llvmStore` associated with the data of Type \p collectionType
      * @param hostFunction The TabithaFunction which hosts the data. 
+     * @param arena The store of the Arena to allocate in, if any. 
      */
-    void allocateHeapSubvectors(CollectionType* collection, llvm::Value* store, TabithaFunction* hostFunction); 
+    void allocateHeapSubvectors(CollectionType* collection, llvm::Value* store, TabithaFunction* hostFunction, llvm::Value* arena = nullptr); 
 
     void allocateContextSubvectors(CollectionType* collection, llvm::Value* store, Slab* hostSlab);
 
@@ -155,6 +354,47 @@ namespace tabic
      */
     void buildExpression(Expression* expression);
 
+    /** @brief Builds the given Aggregate.
+     *
+     * The `sum`, `min`, `max` and `mean` are computed by the tabi_core kernel for the field's Type,
+     * e.g. `core_aggregate_sumInt`, which only takes used rows into account. 
+     * The `mean` kernels sum in a wider type than the field's, so e.g. the mean of an Int field cannot overflow. 
+     *
+     * @param aggregate The Aggregate to be built.
+     */
+    void buildAggregate(Aggregate* aggregate);
+
+    /** @brief Builds the bits of a key, as a Long, in the form expected by core_hash and core_btree. 
+     *
+     * Integers are zero-extended, floating point numbers reinterpreted as integers and addresses converted to integers. 
+     *
+     * @param key The LLVM Value of the key. 
+     */
+    llvm::Value* buildKeyBits(llvm::Value* key);
+
+    /** @brief Build the given Lookup.
+     *
+     * The row is found through the field's hash index by `core_hash_find`, and its ID read from the `id` field.
+     *
+     * @param lookup The Lookup to be built.
+     */
+    void buildLookup(Lookup* lookup);
+
+    /** @brief Reorders a BinaryExpression whose right hand side is also a BinaryExpression, according to the order of operations.
+     *
+     * @param expression The BinaryExpression to be reordered. 
+     */
+    void orderBinaryExpression(Expression* expression);
+
+    /** @brief Builds the result of applying \p op to two values which are the same primitive, or vectors of it. 
+     *
+     * @param op The operator to be applied. 
+     * @param ep The primitive which the values are treated as. 
+     * @param lhs The left hand side. 
+     * @param rhs The right hand side. 
+     */
+    llvm::Value* buildBinaryOperation(BinaryOperator op, EquivalentPrimitive ep, llvm::Value* lhs, llvm::Value* rhs);
+
     /** @brief Build the given Block.
      *
      * @param block THe Block the be built.
@@ -194,6 +434,8 @@ namespace tabic
     void buildVectorSet(VectorSet* vectorSet);
 
     /** @brief Build the given TableInsert.
+     *
+     * Nothing is stored when the table is full, and only the failed insert is counted. 
      *
      * @param tableInsert The TableInsert to be built.
      */
@@ -217,6 +459,61 @@ namespace tabic
      */
     void buildTableCrunch(TableCrunch* tableCrunch); 
 
+    /** @brief Build the given TableScan. 
+     *
+     * The scan is lowered to a plain loop over the rows, which tests each row's bit in the
+     * `#use` field and reads the ID field directly, so no core functions are called per row. 
+     * A scan by an `ordered` field instead takes each row from `core_btree_next`. 
+     *
+     * @param tableScan The TableScan to be built.
+     */
+    void buildTableScan(TableScan* tableScan); 
+
+    /** @brief Build the given TableSelect. 
+     *
+     * The rows are visited a word of `#use` (32 rows) at a time, skipping empty words. 
+     * For each other word the predicate is evaluated over 32-element LLVM vectors loaded straight 
+     * from the fields, giving a bitmask which is combined with the word. 
+     * The IDs of the rows left in the mask are then written out in order, 
+     * up to the length of the vector; any beyond it are counted but not written. 
+     *
+     * @param tableSelect The TableSelect to be built.
+     */
+    void buildTableSelect(TableSelect* tableSelect); 
+
+    /** @brief Builds the parts of a TableSelect predicate which do not depend on the row, ahead of the loop over rows. 
+     *
+     * @param expression The (part of the) predicate to be built. 
+     * @param tableSelect The TableSelect to which the predicate belongs. 
+     */
+    void buildSelectInvariants(Expression* expression, TableSelect* tableSelect); 
+
+    /** @brief Builds the predicate of a TableSelect for the 32 rows starting at \p base, returning a vector of Truth. 
+     *
+     * @param expression The (part of the) predicate to be built. 
+     * @param tableSelect The TableSelect to which the predicate belongs. 
+     * @param base The first row to be tested. 
+     * @param rowMask If not `nullptr`, the rows which exist, so that no field is read beyond its last row. 
+     */
+    llvm::Value* buildSelectPredicate(Expression* expression, TableSelect* tableSelect, llvm::Value* base, llvm::Value* rowMask); 
+
+    /** @brief Build the given TableJoin. 
+     *
+     * The join itself is made by `core_join_hash`, after which any key indexes of the output table are rebuilt. 
+     *
+     * @param tableJoin The TableJoin to be built.
+     */
+    void buildTableJoin(TableJoin* tableJoin); 
+
+    /** @brief Build the given TableGroup. 
+     *
+     * `core_group_hash` gives the group (output row) of each row, after which one loop over the rows 
+     * folds each aggregated field into its group, with code specific to the field's Type. 
+     *
+     * @param tableGroup The TableGroup to be built.
+     */
+    void buildTableGroup(TableGroup* tableGroup); 
+
     /** @brief Builds the given Label.
      *
      * @param label The Label to be built. 
@@ -229,6 +526,12 @@ namespace tabic
      */
     void buildUnheap(Unheap* unheap);
 
+    /** @brief Builds the given UnheapArena, freeing everything allocated in the Arena. 
+     *
+     * @param unheapArena The UnheapArena to be built.
+     */
+    void buildUnheapArena(UnheapArena* unheapArena);
+
     /** @brief Deallocate the memory corresponding to the given Type. 
      *
      * @param type - The type according to which the data should be deallocated.
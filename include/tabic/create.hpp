@@ -18,6 +18,7 @@ limitations under the License.
 
 #include"tabic/model/model.hpp"
 
+#include<map>
 #include<stdexcept>
 
 namespace tabic
@@ -48,8 +49,10 @@ namespace tabic
      *
      * @param rootSlabFilename The name of the root slab,
      * i.e. the slab which contains the `main` function. 
+     * @param sources If given, the preprocessed source of each Slab by ID, used instead of reading and preprocessing its file. 
+     * This is how a Bundle already created is copied, e.g. for each thread building it given `-j N`. 
      */
-    CreateStatus createBundle(std::string rootSlabFilename, std::string cwd, Bundle** bundle); 
+    CreateStatus createBundle(std::string rootSlabFilename, std::string cwd, Bundle** bundle, const std::map<std::string, std::string>* sources = nullptr); 
 
     /** @brief Creates the Slab corresponding to the given \p filename,
      * or returns the slab if one with the corresponding filename
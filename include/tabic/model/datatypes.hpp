@@ -91,9 +91,14 @@ namespace tabic
         STATEMENT_TABLE_DELETE,             ///< Corresponds to TableDelete.
         STATEMENT_TABLE_MEASURE,            ///< Corresponds to TableMeasure. 
         STATEMENT_TABLE_CRUNCH,             ///< Corresponds to TableCrunch. 
+        STATEMENT_TABLE_SCAN,               ///< Corresponds to TableScan.
+        STATEMENT_TABLE_SELECT,             ///< Corresponds to TableSelect.
+        STATEMENT_TABLE_JOIN,               ///< Corresponds to TableJoin.
+        STATEMENT_TABLE_GROUP,              ///< Corresponds to TableGroup.
         STATEMENT_VECTOR_SET,               ///< Corresponds to VectorSet. 
         STATEMENT_LABEL,                    ///< Corresponds to Label.
-        STATEMENT_UNHEAP                    ///< Corresponds to Unheap.
+        STATEMENT_UNHEAP,                   ///< Corresponds to Unheap.
+        STATEMENT_UNHEAP_ARENA              ///< Corresponds to UnheapArena.
     } StatementClass; 
     typedef struct Block Block; 
     typedef struct Return Return; 
@@ -110,8 +115,14 @@ namespace tabic
     typedef struct TableDelete TableDelete;
     typedef struct TableMeasure TableMeasure; 
     typedef struct TableCrunch TableCrunch; 
+    typedef struct TableScan TableScan;
+    typedef struct TableSelect TableSelect;
+    typedef struct TableJoin TableJoin;
+    typedef struct GroupAggregate GroupAggregate;
+    typedef struct TableGroup TableGroup;
     typedef struct Label Label; 
     typedef struct Unheap Unheap;  
+    typedef struct UnheapArena UnheapArena; 
     typedef union Statement Statement;
 
     typedef struct ExpressionCommon ExpressionCommon; 
@@ -132,7 +143,9 @@ namespace tabic
         EXPRESSION_VARIABLE_VALUE,  ///< Corresponds to VariableValue.
         EXPRESSION_FUNCTION_CALL,   ///< Corresponds to FunctionCall.   
         EXPRESSION_BRACKETED,       ///< Corresponds to BracketedExpression.
-        EXPRESSION_BINARY           ///< Corresponds to BinaryExpression.
+        EXPRESSION_BINARY,          ///< Corresponds to BinaryExpression.
+        EXPRESSION_AGGREGATE,       ///< Corresponds to Aggregate.
+        EXPRESSION_LOOKUP           ///< Corresponds to Lookup.
     } ExpressionStatement; 
     typedef struct NullValue NullValue; 
     typedef struct IntLiteral IntLiteral;
@@ -167,6 +180,17 @@ namespace tabic
         BINARY_OP_NOT_EQUAL ///< Corresponds to `!=`. 
     } BinaryOperator;
     typedef struct BinaryExpression BinaryExpression;
+    typedef enum AggregateOperation
+    {
+        AGGREGATE_NONE,     ///< Default value.
+        AGGREGATE_SUM,      ///< Corresponds to `sum`.
+        AGGREGATE_MIN,      ///< Corresponds to `min`.
+        AGGREGATE_MAX,      ///< Corresponds to `max`.
+        AGGREGATE_MEAN,     ///< Corresponds to `mean`.
+        AGGREGATE_COUNT     ///< Corresponds to `count`.
+    } AggregateOperation;
+    typedef struct Aggregate Aggregate;
+    typedef struct Lookup Lookup;
     typedef union Expression Expression;
 
     typedef struct VariableCommon VariableCommon; 
@@ -356,6 +356,65 @@ struct tabic::BinaryExpression
     ~BinaryExpression(){}
 };
 
+/** @brief An Expression which combines the values of one field over all used rows of a table.
+ *
+ * e.g. `sum of price in orders`. 
+ * The `sum`, `min` and `max` of a field have the field's Type, the `mean` is a Double and the `count` is an Int. 
+ */
+struct tabic::Aggregate
+{
+    ExpressionCommon common; 
+
+    struct
+    {
+        AggregateOperation op = AGGREGATE_NONE;     ///< The way in which the field's values are combined.
+        ValueRef* tableRef = nullptr;               ///< The table whose field is aggregated.
+        std::string fieldName = "";                 ///< The name of the aggregated field.
+        int fieldIndex = -1;                        ///< The index of the aggregated field.
+        std::string elemName = "";                  ///< The name of the field's primitive Type, which picks the tabi_core kernel.
+    } parse;
+
+    Aggregate(ASTNode node, Block* hostBlock, Slab* hostSlab)
+    {
+        common.expressionClass = EXPRESSION_AGGREGATE;
+        common.parse.node = node; 
+        common.parse.hostBlock = hostBlock;
+        if(hostBlock) hostSlab = hostBlock->common.parse.hostFunction->create.hostSlab;
+        common.parse.hostSlab = hostSlab;
+    }
+
+    ~Aggregate(){}
+};
+
+/** @brief An Expression which gives the ID of a used row holding a given value in an `indexed` field, or `-1` if there is none. 
+ *
+ * e.g. `lookup code = 42 in orders`
+ */
+struct tabic::Lookup
+{
+    ExpressionCommon common; 
+
+    struct
+    {
+        ValueRef* tableRef = nullptr;       ///< The table in which the row is looked up.
+        std::string fieldName = "";         ///< The name of the `indexed` field.
+        int fieldIndex = -1;                ///< The index of the `indexed` field.
+        Expression* key = nullptr;          ///< The value to look up. 
+    } parse;
+
+    Lookup(ASTNode node, Block* hostBlock, Slab* hostSlab)
+    {
+        common.expressionClass = EXPRESSION_LOOKUP;
+        common.parse.node = node; 
+        common.parse.hostBlock = hostBlock;
+        if(hostBlock) hostSlab = hostBlock->common.parse.hostFunction->create.hostSlab;
+        common.parse.hostSlab = hostSlab;
+        common.parse.type = (Type*) &SupportedPrimitives::INT; 
+    }
+
+    ~Lookup(){}
+};
+
 struct tabic::NullValue
 {
     ExpressionCommon common;
@@ -399,6 +458,8 @@ union tabic::Expression
     FunctionCall functionCall;
     BracketedExpression bracketed;
     BinaryExpression binary;
+    Aggregate aggregate;
+    Lookup lookup;
 
     void destroy()
     {
@@ -425,6 +486,12 @@ union tabic::Expression
             case EXPRESSION_BINARY:
                 delete (BinaryExpression*) this;
                 break;
+            case EXPRESSION_AGGREGATE:
+                delete (Aggregate*) this;
+                break;
+            case EXPRESSION_LOOKUP:
+                delete (Lookup*) this;
+                break;
             default:
                 break;
         }
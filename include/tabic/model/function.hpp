@@ -193,19 +193,49 @@ union tabic::Function
 
 namespace tabic
 {
+    /** @brief The functions of tabi_core which built code calls. 
+     *
+     * Like SupportedPrimitives, these are per thread, as their function types belong to the LLVMContext of the thread building them. 
+     */
     class TabiCore
     {
         public:
-            static CoreFunction TABLE_INIT;         ///< Corresponds to `core_table_init`.
-            static CoreFunction TABLE_INSERT;       ///< Corresponds to `core_table_insert`.
-            static CoreFunction TABLE_GET_BY_ID;    ///< Corresponds to `core_table_getRowByID`.
-            static CoreFunction TABLE_DELETE_BY_ID; ///< Corresponds to `core_table_deleteRowByID`.
-            static CoreFunction TABLE_GET_NUM_USED; ///< Corresponds to `core_table_getNumUsed`.
-            static CoreFunction TABLE_CRUNCH;       ///< Corresponds to `core_table_crunch`.
-            static CoreFunction ALLOC;              ///< Corresponds to `core_alloc`.
-            static CoreFunction DEALLOC;            ///< Corresponds to `core_dealloc`.
-            static CoreFunction MEMCPY;             ///< Corresponds to `core_memcpy`. 
-            static CoreFunction SUBVECTOR_COPY;     ///< Corresponds to `core_subvector_copy`
+            static thread_local CoreFunction TABLE_INIT;         ///< Corresponds to `core_table_init`.
+            static thread_local CoreFunction TABLE_INSERT;       ///< Corresponds to `core_table_insert`.
+            static thread_local CoreFunction TABLE_GET_BY_ID;    ///< Corresponds to `core_table_getRowByID`.
+            static thread_local CoreFunction TABLE_DELETE_BY_ID; ///< Corresponds to `core_table_deleteRowByID`.
+            static thread_local CoreFunction TABLE_GET_NUM_USED; ///< Corresponds to `core_table_getNumUsed`.
+            static thread_local CoreFunction TABLE_CRUNCH;       ///< Corresponds to `core_table_crunch`.
+            static thread_local CoreFunction TABLE_RESERVE;      ///< Corresponds to `core_table_reserve`.
+            static thread_local CoreFunction TABLE_FIND_BY_ID;   ///< Corresponds to `core_table_findRowByID`.
+            static thread_local CoreFunction HASH_GET_SIZE;      ///< Corresponds to `core_hash_getSize`.
+            static thread_local CoreFunction HASH_INIT;          ///< Corresponds to `core_hash_init`.
+            static thread_local CoreFunction HASH_INSERT;        ///< Corresponds to `core_hash_insert`.
+            static thread_local CoreFunction HASH_REMOVE;        ///< Corresponds to `core_hash_remove`.
+            static thread_local CoreFunction HASH_FIND;          ///< Corresponds to `core_hash_find`.
+            static thread_local CoreFunction HASH_REBUILD;       ///< Corresponds to `core_hash_rebuild`.
+            static thread_local CoreFunction HASH_RESERVE;       ///< Corresponds to `core_hash_reserve`.
+            static thread_local CoreFunction BTREE_GET_SIZE;     ///< Corresponds to `core_btree_getSize`.
+            static thread_local CoreFunction BTREE_INIT;         ///< Corresponds to `core_btree_init`.
+            static thread_local CoreFunction BTREE_INSERT;       ///< Corresponds to `core_btree_insert`.
+            static thread_local CoreFunction BTREE_REMOVE;       ///< Corresponds to `core_btree_remove`.
+            static thread_local CoreFunction BTREE_REBUILD;      ///< Corresponds to `core_btree_rebuild`.
+            static thread_local CoreFunction BTREE_RESERVE;      ///< Corresponds to `core_btree_reserve`.
+            static thread_local CoreFunction BTREE_SEEK;         ///< Corresponds to `core_btree_seek`.
+            static thread_local CoreFunction BTREE_NEXT;         ///< Corresponds to `core_btree_next`.
+            static thread_local CoreFunction JOIN_HASH;          ///< Corresponds to `core_join_hash`.
+            static thread_local CoreFunction GROUP_HASH;         ///< Corresponds to `core_group_hash`.
+            static thread_local CoreFunction ALLOC;              ///< Corresponds to `core_alloc`.
+            static thread_local CoreFunction ALLOC_ALIGNED;      ///< Corresponds to `core_alloc_aligned`.
+            static thread_local CoreFunction DEALLOC;            ///< Corresponds to `core_dealloc`.
+            static thread_local CoreFunction ARENA_ALLOC;        ///< Corresponds to `core_arena_alloc`.
+            static thread_local CoreFunction ARENA_RELEASE;      ///< Corresponds to `core_arena_release`.
+            static thread_local CoreFunction STATS_REPORT;       ///< Corresponds to `core_stats_report`.
+            static thread_local CoreFunction STATS_REPORT_TABLE; ///< Corresponds to `core_stats_reportTable`.
+            static thread_local CoreFunction MEMCPY;             ///< Corresponds to `core_memcpy`. 
+            static thread_local CoreFunction SUBVECTOR_COPY;     ///< Corresponds to `core_subvector_copy`
+            static const int HEAP_ALIGNMENT = 16;   ///< The alignment of memory from `core_alloc`, which allocations from an arena share. 
+            static const int ALIGNMENT = 64;        ///< The alignment of memory from `core_alloc_aligned`, which stack allocated table fields share. 
     }; 
 
     class LLVMIntrinsic
@@ -18,7 +18,10 @@ limitations under the License.
 
 #include"datatypes.hpp"
 
+#include"llvm/IR/Value.h"
+
 #include<vector>
+#include<cstdint>
 
 /** @brief Data common all all elements of the union Statement. 
  */
@@ -46,6 +49,8 @@ struct tabic::Block
     {
         std::vector<Statement*> statements = {};
         std::map<std::string, Variable*> variables; 
+        TableScan* scan = nullptr;          ///< The TableScan whose row variable this Block holds, if any.
+        TableSelect* select = nullptr;      ///< The TableSelect whose field variables this Block holds, if any.
     } parse;
 
     Block(ASTNode node, Block* parentBlock, TabithaFunction* hostFunction)
@@ -109,6 +114,7 @@ struct tabic::HeapedDeclaration
     {
         HeapedVariable* variable = nullptr;     ///< The HeapedVariable this HeapedVariable declares. 
         Expression* initialiser = nullptr;      ///< The Expression which is first assigned to the HeapedVariable. 
+        ValueRef* arenaRef = nullptr;           ///< The Arena the HeapedVariable is allocated in, if any. 
     } parse;
 
     HeapedDeclaration(ASTNode node, Block* hostBlock)
@@ -321,6 +327,161 @@ struct tabic::TableCrunch
     }
 };
 
+/** @brief A Statement which executes a Block once for each used row of a table. 
+ *
+ * Rows are visited in storage order, or with e.g. `for each row r in t by time from a to b`, 
+ * in order of the `ordered` field `time`, visiting only rows with `a <= time <= b` (either bound may be left out). 
+ * The directions of such a scan may not assign to `time` in any row of `t`, as a row moved forward would be visited again. 
+ * The current row's ID is held by a read-only Int variable,
+ * and row references through that variable index the current row directly, rather than
+ * looking it up by ID. 
+ */
+struct tabic::TableScan
+{
+    static const int CURSOR_SIZE = 3;   ///< The size of `core_btree_cursor`, in Long. 
+
+    StatementCommon common; 
+    struct
+    {
+        ValueRef* tableRef = nullptr;               ///< The table whose rows are visited.
+        StackedVariable* rowVariable = nullptr;     ///< The variable holding the ID of the current row.
+        Block* scope = nullptr;                     ///< The Block declaring rowVariable, which contains only directions.
+        Block* directions = nullptr;                ///< The Block executed for each used row.
+        int orderFieldIndex = -1;                   ///< The index of the `ordered` field giving the order of the rows, if any.
+        Expression* from = nullptr;                 ///< The least value of the ordered field to be visited, if any.
+        Expression* to = nullptr;                   ///< The greatest value of the ordered field to be visited, if any.
+    } parse;
+
+    struct
+    {
+        llvm::Value* rowStore = nullptr;            ///< The LLVM Value storing the index of the current row. 
+        llvm::Value* cursorStore = nullptr;         ///< The LLVM Value storing the cursor into the ordered index, if any. 
+    } build;
+
+    TableScan(ASTNode node, Block* hostBlock)
+    {
+        common.statementClass = STATEMENT_TABLE_SCAN; 
+        common.parse.hostBlock = hostBlock; 
+        common.parse.hostFunction = hostBlock->common.parse.hostFunction; 
+        common.parse.node = node; 
+    }
+};
+
+/** @brief A Statement which collects the IDs of the used rows of a table for which a predicate holds. 
+ *
+ * e.g. `select from t where x > 5 into v > n`, which writes the IDs into the `Vec[Int, _]` `v`, 
+ * and their number into `n`. IDs beyond the length of the vector are not written, but are still counted in `n`. 
+ * A vector shorter than a fixed-size table is rejected when parsed. 
+ * Within the predicate, the names of the table's primitive fields refer to the values of the row being tested. 
+ * The predicate is evaluated a column at a time, for all rows covered by one word of `#use` at once.
+ */
+struct tabic::TableSelect
+{
+    static const int LANES = 32;    ///< The number of rows tested at once, i.e. the number covered by one word of `#use`.
+
+    StatementCommon common; 
+    struct
+    {
+        ValueRef* tableRef = nullptr;                       ///< The table whose rows are tested.
+        Expression* predicate = nullptr;                    ///< The Truth Expression which selects a row.
+        ValueRef* intoRef = nullptr;                        ///< The vector into which the selected IDs are written.
+        ValueRef* countRef = nullptr;                       ///< The Int into which the number of selected IDs is written, if any.
+        Block* scope = nullptr;                             ///< The Block declaring the field variables, in which the predicate is parsed.
+        std::vector<StackedVariable*> fieldVariables = {};  ///< The variable standing for each field, or `nullptr` for non-primitive fields.
+    } parse;
+
+    struct
+    {
+        llvm::Value* wordStore = nullptr;                   ///< The LLVM Value storing the index of the current `#use` word.
+        llvm::Value* countStore = nullptr;                  ///< The LLVM Value storing the number of IDs selected so far.
+        llvm::Value* bitsStore = nullptr;                   ///< The LLVM Value storing the rows of the current word still to be written out.
+        std::vector<llvm::Value*> fields = {};              ///< The pointer to each field's elements, loaded ahead of the loop.
+    } build;
+
+    TableSelect(ASTNode node, Block* hostBlock)
+    {
+        common.statementClass = STATEMENT_TABLE_SELECT; 
+        common.parse.hostBlock = hostBlock; 
+        common.parse.hostFunction = hostBlock->common.parse.hostFunction; 
+        common.parse.node = node; 
+    }
+};
+
+/** @brief A Statement which pairs up the rows of two tables whose key fields are equal. 
+ *
+ * e.g. `join a on key with b on aKey into pairs > n`, which inserts a row into `pairs` for each used row of `a` 
+ * and used row of `b` with equal keys, holding their IDs in its first two fields (which must be Int), 
+ * and writes the number of pairs into `n`. 
+ * The join is made by tabi_core, which hashes the table with fewer used rows and probes it with the other. 
+ * If `pairs` is not growable, the join stops once it is full. 
+ */
+struct tabic::TableJoin
+{
+    StatementCommon common; 
+    struct
+    {
+        ValueRef* leftRef = nullptr;        ///< The table whose IDs go into the first field of the output. 
+        int leftFieldIndex = -1;            ///< The index (in TableType::parse.fields) of the key field of the left table. 
+        ValueRef* rightRef = nullptr;       ///< The table whose IDs go into the second field of the output. 
+        int rightFieldIndex = -1;           ///< The index of the key field of the right table. 
+        ValueRef* intoRef = nullptr;        ///< The table into which the pairs are inserted. 
+        ValueRef* countRef = nullptr;       ///< The Int into which the number of pairs is written, if any. 
+    } parse;
+
+    TableJoin(ASTNode node, Block* hostBlock)
+    {
+        common.statementClass = STATEMENT_TABLE_JOIN; 
+        common.parse.hostBlock = hostBlock; 
+        common.parse.hostFunction = hostBlock->common.parse.hostFunction; 
+        common.parse.node = node; 
+    }
+};
+
+/** @brief One of the aggregates computed for each group by a TableGroup. 
+ */
+struct tabic::GroupAggregate
+{
+    AggregateOperation op = AGGREGATE_NONE;     ///< One of `count`, `sum`, `min` or `max`.
+    int fieldIndex = -1;                        ///< The index of the aggregated field, or `-1` for `count`.
+};
+
+/** @brief A Statement which groups the used rows of a table by a field, and computes aggregates for each group. 
+ *
+ * e.g. `group orders by customer into totals (count, sum of price, max of price) > n`, which inserts a row into `totals` 
+ * for each distinct `customer`, holding the key in its first field and the aggregates in the rest, in order, 
+ * and writes the number of groups into `n`. 
+ * The `count` field is an Int, and every other aggregate has the Type of its field. 
+ * The rows are grouped by tabi_core with a hash table, then each aggregated field is folded into its groups in one loop. 
+ * If `totals` is not growable, the groups which do not fit are left out. 
+ */
+struct tabic::TableGroup
+{
+    static const int SKIP = INT32_MIN;  ///< Corresponds to `CORE_GROUP_SKIP`, the group of a row which is left out.
+
+    StatementCommon common; 
+    struct
+    {
+        ValueRef* tableRef = nullptr;                   ///< The table whose rows are grouped. 
+        int keyFieldIndex = -1;                         ///< The index of the field by which the rows are grouped. 
+        ValueRef* intoRef = nullptr;                    ///< The table into which the groups are inserted. 
+        std::vector<GroupAggregate> aggregates = {};    ///< The aggregates, one for each field of the output after the key. 
+        ValueRef* countRef = nullptr;                   ///< The Int into which the number of groups is written, if any. 
+    } parse;
+
+    struct
+    {
+        llvm::Value* rowStore = nullptr;                ///< The LLVM Value storing the row being folded into its group. 
+    } build;
+
+    TableGroup(ASTNode node, Block* hostBlock)
+    {
+        common.statementClass = STATEMENT_TABLE_GROUP; 
+        common.parse.hostBlock = hostBlock; 
+        common.parse.hostFunction = hostBlock->common.parse.hostFunction; 
+        common.parse.node = node; 
+    }
+};
+
 /** @brief A Statement which sets a subset of some vector's elements. 
  */
 struct tabic::VectorSet
@@ -385,6 +546,26 @@ struct tabic::Unheap
     }
 }; 
 
+/** @brief A Statement which frees everything allocated in an Arena, all at once. 
+ */
+struct tabic::UnheapArena
+{
+    StatementCommon common; 
+
+    struct
+    {
+        ValueRef* arenaRef = nullptr;       ///< The Arena to release. 
+    } parse; 
+
+    UnheapArena(ASTNode node, Block* hostBlock)
+    {
+        common.statementClass = STATEMENT_UNHEAP_ARENA; 
+        common.parse.node = node; 
+        common.parse.hostBlock = hostBlock; 
+        common.parse.hostFunction = hostBlock->common.parse.hostFunction;
+    }
+}; 
+
 /** @brief Acts as a superstruct for all forms of Statement.
  */
 union tabic::Statement
@@ -404,8 +585,13 @@ union tabic::Statement
     TableDelete tableDelete; 
     TableMeasure tableMeasure; 
     TableCrunch tableCrunch; 
+    TableScan tableScan; 
+    TableSelect tableSelect; 
+    TableJoin tableJoin; 
+    TableGroup tableGroup; 
     Label label; 
     Unheap unheap; 
+    UnheapArena unheapArena; 
 
     void destroy()
     {
@@ -20,6 +20,7 @@ limitations under the License.
 
 #include"llvm/IR/LLVMContext.h"
 #include"llvm/IR/Type.h"
+#include"llvm/IR/DerivedTypes.h"
 
 #include<map>
 
@@ -172,22 +173,58 @@ struct tabic::TableField
 {
     Type* type = nullptr;         ///< The Type of the field. 
     std::string name = "";   ///< The name of the field. 
+    bool indexed = false;         ///< Whether the field was declared `indexed`, and so has a hash index. 
+    bool ordered = false;         ///< Whether the field was declared `ordered`, and so has an ordered (B+-tree) index. 
 }; 
 
 /** @brief A type representing a Codd table with columns of given types. 
  *
  * e.g. `Table[Int, Float, Addr[Char], 10]` is a TableType with three columns of types `Int`, `Float`, `Addr[Char]`, and with `10` rows. 
+ * A table declared with `growable 10` instead starts with `10` rows, and doubles its rows whenever an insert finds it full. 
+ * A field declared as e.g. `indexed Int key` has a hash index, kept by tabi_core, through which rows can be looked up by key. 
+ * A field declared as e.g. `ordered Long time` has an ordered index instead, through which rows can be visited in order of the field. 
+ * The pointer to each hash index follows the pointers to the fields, and the pointer to each ordered index follows those. 
+ *
+ * A table declared with e.g. `row major 10` keeps the user's fields together, one record per row, in the array 
+ * pointed to by the first user field. The pointers for the other user fields are left unused. 
+ * tabi_core sees the records as a single field, whose elements are the size of a record. 
+ * The `id`, `#use` and `#index` fields are kept apart either way. 
  */
 struct tabic::TableType
 {
+    static const int NUM_META_FIELDS = 3;      ///< The number of fields (`id`, `#use` and `#index`) which precede the user's fields. 
+    static const int INDEX_HEADER_SIZE = 4;    ///< The number of Int which tabi_core keeps ahead of the id index in the `#index` field. 
+    static const int INDEX_NUM_ROWS = 3;       ///< The slot of the `#index` header which holds the current number of rows. 
+    static const int MAX_ROWS = 0x7FFFFFE0;    ///< The most rows a growable table grows to (`CORE_TABLE_MAX_ROWS` in tabi_core). 
+    static const int MAX_INDEXED_ROWS = 1 << 29;   ///< The most rows a growable table with a hash index grows to (`CORE_TABLE_MAX_INDEXED_ROWS` in tabi_core). 
+
+    //The counters kept for each context table when tabic is given `--profile-tables`, in the order `core_stats_reportTable` prints them. 
+    static const int PROFILE_INSERTS = 0; 
+    static const int PROFILE_FAILED_INSERTS = 1; 
+    static const int PROFILE_LOOKUPS = 2;       ///< Rows found by ID (outside of a scan) or by key. 
+    static const int PROFILE_DELETES = 3; 
+    static const int PROFILE_MEASURES = 4; 
+    static const int PROFILE_CRUNCHES = 5; 
+    static const int PROFILE_SCANNED_ROWS = 6;  ///< Rows visited by `scan`. 
+    static const int PROFILE_NUM_COUNTERS = 7; 
+
     TypeCommon common; 
     
     struct
     {
-        std::vector<TableField> fields = {};    ///< The Type belonging to each field (including the `id` and `use` fields).
-        Expression* numRows;                    ///< The Expression representing the number of rows the table has. 
+        std::vector<TableField> fields = {};    ///< The Type belonging to each field (including the `id`, `#use` and `#index` fields).
+        Expression* numRows;                    ///< The Expression representing the number of rows the table has (initially, if growable). 
+        bool growable = false;                  ///< Whether the table grows when full. 
+        bool rowMajor = false;                  ///< Whether the user's fields are kept together in records, rather than in an array each. 
+        std::vector<int> indexedFields = {};    ///< The index of each `indexed` field, in the order their hash indexes follow the fields. 
+        std::vector<int> orderedFields = {};    ///< The index of each `ordered` field, in the order their ordered indexes follow the hash indexes. 
     } parse;
 
+    struct
+    {
+        llvm::StructType* recordType = nullptr; ///< The LLVM type of one row of the user's fields, for a `row major` table. 
+    } build;
+
     TableType()
     {
         common.typeClass = TYPE_TABLE; 
@@ -260,19 +297,21 @@ namespace tabic
      *
      * These are defined to be static for the reason that 
      * primitive types are the same (at least in the in-memory model) no matter what. 
+     * They are per thread, as their LLVM types belong to the LLVMContext of the thread building them. 
      */
     class SupportedPrimitives
     {
         public:
-            static PrimitiveType SIZE;      ///< The Size Type `Size`.
-            static PrimitiveType INT;       ///< The Integer Type `Int`.
-            static PrimitiveType LONG;      ///< The Long Integer Type `Long` 
-            static PrimitiveType SHORT;     ///< The Short Integer Type `Short`
-            static PrimitiveType DOUBLE;    ///< The Double Precision Float Type `Double`
-            static PrimitiveType FLOAT;     ///< The Floating Point Type `Float`.
-            static PrimitiveType CHAR;      ///< The Character Type `Char`.
-            static PrimitiveType TRUTH;     ///< The Truth Type `Truth`. 
-            static PrimitiveType NONE;      ///< The None Type `None`. 
+            static thread_local PrimitiveType SIZE;      ///< The Size Type `Size`.
+            static thread_local PrimitiveType INT;       ///< The Integer Type `Int`.
+            static thread_local PrimitiveType LONG;      ///< The Long Integer Type `Long` 
+            static thread_local PrimitiveType SHORT;     ///< The Short Integer Type `Short`
+            static thread_local PrimitiveType DOUBLE;    ///< The Double Precision Float Type `Double`
+            static thread_local PrimitiveType FLOAT;     ///< The Floating Point Type `Float`.
+            static thread_local PrimitiveType CHAR;      ///< The Character Type `Char`.
+            static thread_local PrimitiveType TRUTH;     ///< The Truth Type `Truth`. 
+            static thread_local PrimitiveType NONE;      ///< The None Type `None`. 
+            static thread_local PrimitiveType ARENA;     ///< The Arena Type `Arena`, a handle on an arena for heaped variables.
     };
 }
 
@@ -237,8 +237,14 @@ struct tabic::RowRef
         std::string fieldName = "";         ///< Name of the table field. 
         Expression* id = nullptr;           ///< Expression representing the ID of the referenced row. 
         int fieldIndex = -1;                ///< Index for the referenced field. 
+        TableScan* scan = nullptr;          ///< The TableScan whose current row is referenced, if any.
     } parse; 
 
+    struct
+    {
+        llvm::Value* row = nullptr;         ///< The LLVM Value holding the referenced row (not its ID). 
+    } build; 
+
     RowRef(ValueRef* parent)
     {
         common.valueRefClass = VALUE_REF_ROW; 
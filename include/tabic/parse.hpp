@@ -96,6 +96,46 @@ namespace tabic
             }
     };
 
+    /** @brief The exception thrown when the arena of a HeapedDeclaration or UnheapArena is not of type `Arena`. 
+     */
+    class ArenaRefNotArena : std::exception
+    {
+        public:
+            int lineNum = 0;
+            int colNum = 0; 
+
+            ArenaRefNotArena(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum)
+            {
+            }
+
+            const char* what() const throw()
+            {
+                return "Arena reference is not of type Arena.";
+            }
+    };
+
+    /** @brief The exception thrown when a growable table would be allocated in an arena. 
+     *
+     * A growable table frees its fields as it grows, which memory from an arena cannot be. 
+     */
+    class ArenaTableGrowable : std::exception
+    {
+        public:
+            int lineNum = 0;
+            int colNum = 0; 
+
+            ArenaTableGrowable(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum)
+            {
+            }
+
+            const char* what() const throw()
+            {
+                return "Growable tables cannot be allocated in an arena.";
+            }
+    };
+
     /** @brief The exception thrown when a row reference uses an unrecognised field.  
      */
     class FieldNotFound : std::exception
@@ -472,6 +512,380 @@ namespace tabic
             }
     }; 
 
+    /** @brief The exception thrown when an Aggregate is taken over a field which is not of a numeric primitive Type. 
+     */
+    class AggregateFieldNotNumeric : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            AggregateFieldNotNumeric(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "Only fields of type Int, Long, Short, Float, Double or Size can be aggregated."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a field whose Type cannot be hashed is declared `indexed`. 
+     */
+    class IndexedFieldNotHashable : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            IndexedFieldNotHashable(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "Only fields of type Int, Long, Short, Size, Char, Truth or Addr[...] can be indexed."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a Lookup is made on a field which is not `indexed`. 
+     */
+    class LookupFieldNotIndexed : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            LookupFieldNotIndexed(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "Rows can only be looked up by an indexed field."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when the key of a Lookup does not have the Type of the field. 
+     */
+    class LookupKeyMismatch : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            LookupKeyMismatch(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "The key of a lookup must have the type of the indexed field."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a field whose Type has no order is declared `ordered`. 
+     */
+    class OrderedFieldNotOrderable : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            OrderedFieldNotOrderable(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "Only fields of type Int, Long, Short, Size, Char, Truth, Float or Double can be ordered."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a TableScan is made by a field which is not `ordered`. 
+     */
+    class ScanFieldNotOrdered : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            ScanFieldNotOrdered(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "Rows can only be visited in the order of an ordered field."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a bound of a TableScan does not have the Type of the ordered field. 
+     */
+    class ScanBoundMismatch : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            ScanBoundMismatch(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "The bounds of a scan must have the type of the ordered field."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a growable table, or a type containing one, is declared as a StackedVariable. 
+     */
+    class GrowableTableStacked : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            GrowableTableStacked(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "A growable table must be heaped or belong to a context."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a table is crunched inside a TableScan over it. 
+     */
+    class ScanTableCrunched : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            ScanTableCrunched(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "A table cannot be crunched while its rows are being scanned."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when the ordering field of a table is assigned to inside a TableScan over it `by` that field. 
+     */
+    class ScanOrderAssigned : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            ScanOrderAssigned(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "A field cannot be assigned to while a table's rows are being scanned in its order."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when the row variable of a TableScan is assigned to. 
+     */
+    class ScanRowAssigned : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            ScanRowAssigned(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "The row variable of a table scan cannot be assigned to."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when the predicate of a TableSelect is not a Truth. 
+     */
+    class SelectPredicateNotTruth : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            SelectPredicateNotTruth(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "The predicate of a select must be a Truth."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when the predicate of a TableSelect cannot be evaluated a column at a time. 
+     */
+    class SelectPredicateNotColumnar : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            SelectPredicateNotColumnar(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "The predicate of a select may not call functions or locate fields."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a TableSelect writes into something other than a vector of Int. 
+     */
+    class SelectIntoNotIdVector : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            SelectIntoNotIdVector(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "A select must write its IDs into a Vec[Int, _]."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a TableSelect writes into a vector shorter than its (fixed-size) table. 
+     */
+    class SelectIntoTooShort : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            SelectIntoTooShort(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "A select must write its IDs into a vector with at least as many elements as the table has rows."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when the key fields of a TableJoin differ in Type, or cannot be hashed. 
+     */
+    class JoinKeyMismatch : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            JoinKeyMismatch(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "The key fields of a join must have the same type, one of Int, Long, Short, Size, Char, Truth or Addr[...]."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a TableJoin writes into a table whose first two fields are not Int. 
+     */
+    class JoinIntoNotPairTable : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            JoinIntoNotPairTable(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "A join must write into a table whose first two fields are Int."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a TableJoin writes into one of the tables it joins. 
+     */
+    class JoinIntoInput : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            JoinIntoInput(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "A join cannot write into either of the tables it joins."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a TableGroup groups rows by a field which cannot be hashed. 
+     */
+    class GroupKeyNotHashable : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            GroupKeyNotHashable(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "Rows can only be grouped by a field of type Int, Long, Short, Size, Char, Truth or Addr[...]."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when the fields of the output of a TableGroup do not match its key and aggregates. 
+     */
+    class GroupIntoMismatch : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            GroupIntoMismatch(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "A group must write into a table with a field for the key, then one for each aggregate (Int for count)."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a TableGroup writes into the table it groups. 
+     */
+    class GroupIntoInput : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            GroupIntoInput(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "A group cannot write into the table it groups."; 
+            }
+    }; 
+
+    /** @brief The exception thrown when a `row major` table is used by an operation which reads or writes whole fields. 
+     */
+    class RowMajorUnsupported : std::exception
+    {
+        public:
+            int lineNum = 0; 
+            int colNum  = 0; 
+
+            RowMajorUnsupported(int lineNum, int colNum)
+                : lineNum(lineNum), colNum(colNum) {}
+
+            const char* what() const throw()
+            {
+                return "Row major tables cannot have indexed or ordered fields, nor be used by select, aggregates, group, or as the output or by the key of a join."; 
+            }
+    }; 
+
     /** @brief Parses the given Bundle and all of the Slab it owns.
      * 
      * To parse a Bundle, means to translate every element of the source code
@@ -583,6 +997,20 @@ namespace tabic
      */
     BinaryExpression* parseBinaryExpression(ASTNode node, Block* hostBlock, Slab* hostSlab);
 
+    /** @brief Parses and returns the Aggregate defined by \p node.
+     *
+     * @param node The PEG AST node which defines the Aggregate.
+     * @param hostBlock The Block which contains the Aggregate. 
+     */
+    Aggregate* parseAggregate(ASTNode node, Block* hostBlock);
+
+    /** @brief Parses and returns the Lookup defined by \p node.
+     *
+     * @param node The PEG AST node which defines the Lookup.
+     * @param hostBlock The Block which contains the Lookup. 
+     */
+    Lookup* parseLookup(ASTNode node, Block* hostBlock);
+
     /** @brief Parses and returns a StackedDeclaration defined by \p node. 
      *
      * @param node The PEG AST node which defines the StackedDeclaration.
@@ -692,6 +1120,65 @@ namespace tabic
      */
     TableCrunch* parseTableCrunch(ASTNode node, Block* hostBlock);
 
+    /** @brief Parses and returns the TableScan defined by \p node. 
+     *
+     * @param node The ASTNode which defines the TableScan. 
+     * @param hostBlock The Block in which the TableScan appears. 
+     */
+    TableScan* parseTableScan(ASTNode node, Block* hostBlock);
+
+    /** @brief Returns the TableScan whose row variable is \p variable, if it is visible from \p block. 
+     *
+     * @param block The Block from which to search. 
+     * @param variable The Variable which may hold the current row of a TableScan. 
+     */
+    TableScan* getTableScan(Block* block, Variable* variable);
+
+    /** @brief Parses and returns the TableSelect defined by \p node. 
+     *
+     * @param node The ASTNode which defines the TableSelect. 
+     * @param hostBlock The Block in which the TableSelect appears. 
+     */
+    TableSelect* parseTableSelect(ASTNode node, Block* hostBlock);
+
+    /** @brief Throws SelectPredicateNotColumnar if \p expression cannot be evaluated for many rows at once. 
+     *
+     * @param expression The (part of the) predicate to be checked. 
+     * @param select The TableSelect to which the predicate belongs. 
+     */
+    void checkSelectPredicate(Expression* expression, TableSelect* select);
+
+    /** @brief Parses and returns the TableJoin defined by \p node. 
+     *
+     * @param node The ASTNode which defines the TableJoin. 
+     * @param hostBlock The Block in which the TableJoin appears. 
+     */
+    TableJoin* parseTableJoin(ASTNode node, Block* hostBlock);
+
+    /** @brief Parses and returns the TableGroup defined by \p node. 
+     *
+     * @param node The ASTNode which defines the TableGroup. 
+     * @param hostBlock The Block in which the TableGroup appears. 
+     */
+    TableGroup* parseTableGroup(ASTNode node, Block* hostBlock);
+
+    /** @brief Parses one side (`t on key`) of a TableJoin, i.e. a table and the index of its key field. 
+     *
+     * Returns false if the table could not be parsed, and throws if it is not a table or has no such field. 
+     *
+     * @param node The JOIN_LEFT or JOIN_RIGHT node. 
+     * @param hostBlock The Block in which the TableJoin appears. 
+     * @param tableRef Set to the reference to the table. 
+     * @param fieldIndex Set to the index of the key field. 
+     */
+    bool parseJoinSide(ASTNode node, Block* hostBlock, ValueRef* &tableRef, int &fieldIndex);
+
+    /** @brief Returns whether the values of \p type can be used as hash keys. 
+     *
+     * Keys are hashed and compared by their bytes, which for floating point numbers does not agree with `==`. 
+     */
+    bool isHashable(Type* type);
+
     /** @brief Parses and returns the Conditional defined by \p node. 
      *
      * @param node The ASTNode which defines the Conditional.
@@ -727,11 +1214,39 @@ namespace tabic
      */
     Unheap* parseUnheap(ASTNode node, Block* hostBlock);
 
+    /** @brief Parses and returns the UnheapArena defined by \p node. 
+     *
+     * @param node The ASTNode which defines the UnheapArena. 
+     * @param hostBlock The Block in which the UnheapArena occurs. 
+     */
+    UnheapArena* parseUnheapArena(ASTNode node, Block* hostBlock);
+
+    /** @brief Parses the Arena referred to by \p node, throwing if it is not of type `Arena`. 
+     *
+     * @param node The VALUE_REF node. 
+     * @param hostBlock The Block in which the reference appears. 
+     */
+    ValueRef* parseArenaRef(ASTNode node, Block* hostBlock);
+
+    /** @brief Returns whether \p type is, or holds, a growable table.
+     */
+    bool hasGrowableTable(Type* type);
+
     /** @brief Decides whether the given Type are equivalent or not. 
      *
      * @param a The first Type. 
      * @param b The second Type.
      */
     bool typesMatch(Type* a, Type* b);
+
+    /** @brief Decides whether the given ValueRef certainly refer to the same value. 
+     *
+     * Only chains of variable and member references are compared, anything else is
+     * conservatively considered not to match. 
+     *
+     * @param a The first ValueRef. 
+     * @param b The second ValueRef. 
+     */
+    bool refsMatch(ValueRef* a, ValueRef* b);
 }
 
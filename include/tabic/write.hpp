@@ -18,6 +18,8 @@ limitations under the License.
 
 #include"model/model.hpp"
 
+#include"llvm/Target/TargetMachine.h"
+
 namespace tabic
 {
     /** @brief Writes the output associated with a Bundle.
@@ -26,11 +28,62 @@ namespace tabic
      */
     void writeBundle(Bundle* bundle);
 
+    /** @brief Sets up the targets and creates the output directory. 
+     *
+     * Slabs may then be written, with writeSlab, until endWrite is called. 
+     * Returns false (having reported it) if the CPU given with `-mcpu` or `-march` is not known to the target. 
+     */
+    bool beginWrite();
+
+    /** @brief Finishes writing, once every slab has been passed to writeSlab. 
+     *
+     * Given `--lto`, the slabs are then linked into one module, which is optimised and emitted as `lto.o`. 
+     */
+    void endWrite();
+
     /** @brief Writes the output associated with a Slab.
      *
      * This output is in the form of LLVM bytecode (`.bc`) files or C object files (`.o`). 
+     * Slabs in different LLVMContexts may be written from different threads at once, as given `-j N`. 
      */
     void writeSlab(Slab* slab);
+
+    /** @brief Does what is needed before a Slab's module is optimised: showing its IR if asked, and verifying it. 
+     */
+    void prepareSlab(Slab* slab);
+
+    /** @brief Returns the name (without extension) of the files written for a Slab. 
+     */
+    std::string getSlabFilename(Slab* slab);
+
+    /** @brief Optimises a module, and writes it as bitcode (`filename.bc`) and, unless given `--lto`, as an object file (`filename.o`). 
+     *
+     * This uses no state of the build, so may be called from several threads at once, for modules in different contexts. 
+     */
+    void writeModule(llvm::Module* module, std::string filename);
+
+    /** @brief Runs the optimisation pipeline for the level given to tabic (`-O0` to `-O3`, or `-Os`) on a module.
+     *
+     * Nothing is run at `-O0`. The module must already have the data layout and triple of \p targetMachine.
+     * Given `--lto`, a slab's module gets the pipeline which readies it for linking, and the linked module (\p linked) the whole program pipeline.
+     */
+    void optimiseModule(llvm::Module* module, llvm::TargetMachine* targetMachine, bool linked = false);
+
+    /** @brief Returns the CPU to generate code for, as given to tabic with `-mcpu` (`generic` by default). 
+     *
+     * `-mcpu=native` is resolved to the CPU of the host. 
+     */
+    std::string getTargetCPU();
+
+    /** @brief Returns the target features (e.g. `+avx2,-avx512f`) to generate code with. 
+     *
+     * These are the features of the host for `-mcpu=native`, followed by any given to tabic with `-mattr`. 
+     */
+    std::string getTargetFeatures();
+
+    /** @brief Returns the level at which the backend generates code, matching the level given to tabic. 
+     */
+    llvm::CodeGenOpt::Level getCodeGenOptLevel();
 }
 
 
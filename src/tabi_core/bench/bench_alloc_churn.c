@@ -0,0 +1,144 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+/*
+ * Compares the heap of the raw runtime (tabi_core_alloc.c) against malloc, which the cross runtime uses,
+ * and against a mapping per allocation, which the raw runtime used to make.
+ *
+ * A number of allocations are kept live, and each step frees one picked at random and allocates another
+ * in its place, mostly of a few dozen bytes (as heaped variables and strings are) and now and then larger.
+ * Each allocation is written to, so that the cost of first touching fresh memory is counted.
+ *
+ * This is not linked against tabi_core_raw, which has no libc to print with, but builds tabi_core_alloc.c
+ * (and tabi_core_stats.c, which it calls when recording) itself, with its system calls made through libc.
+ */
+#include<stdio.h>
+#include<stdlib.h>
+#include<time.h>
+#include<sys/mman.h>
+#include<unistd.h>
+
+void* core_alloc(long numBytes);
+void  core_dealloc(void* ptr);
+
+void* core_sys_mmap(long length)
+{
+    return mmap(0, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+}
+
+int core_sys_munmap(void* addr, long length)
+{
+    return munmap(addr, length);
+}
+
+int core_sys_madvise(void* addr, long length, int advice)
+{
+    return madvise(addr, length, advice);
+}
+
+long core_sys_write(int fd, void* buf, long length)
+{
+    return write(fd, buf, length);
+}
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1e-9*t.tv_nsec;
+}
+
+/** @brief A mapping per allocation, with its length kept ahead of it, as the raw runtime's core_alloc was.
+ */
+static void* mapAlloc(long numBytes)
+{
+    long* ptr = mmap(0, numBytes + 8, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    *ptr = numBytes + 8;
+    return ptr + 1;
+}
+
+static void mapDealloc(void* ptr)
+{
+    long* base = (long*)ptr - 1;
+    munmap(base, *base);
+}
+
+enum { HEAP_CORE, HEAP_MALLOC, HEAP_MAP };
+
+static void* heapAlloc(int heap, long numBytes)
+{
+    if(heap == HEAP_CORE) return core_alloc(numBytes);
+    if(heap == HEAP_MALLOC) return malloc(numBytes);
+    return mapAlloc(numBytes);
+}
+
+static void heapDealloc(int heap, void* ptr)
+{
+    if(heap == HEAP_CORE) core_dealloc(ptr);
+    else if(heap == HEAP_MALLOC) free(ptr);
+    else mapDealloc(ptr);
+}
+
+/** @brief Returns the size of the next allocation: mostly 8 to 128 bytes, one in 16 up to 4 KiB, and one in 1024 up to 64 KiB.
+ */
+static long nextSize(unsigned int* seed)
+{
+    *seed = *seed*1103515245u + 12345u;
+    unsigned int r = *seed >> 8;
+    if((r & 1023) == 0) return 8 + (r >> 10) % (64 << 10);
+    if((r & 15) == 0) return 8 + (r >> 4) % 4096;
+    return 8 + (r >> 4) % 120;
+}
+
+/** @brief Runs \p numSteps steps of churn over \p numLive live allocations, returning the time per step in ns.
+ */
+static double churn(int heap, int numLive, int numSteps)
+{
+    char** live = malloc(sizeof(char*)*numLive);
+    unsigned int seed = 1;
+    for(int i = 0; i < numLive; i++)
+    {
+        live[i] = heapAlloc(heap, nextSize(&seed));
+        live[i][0] = 1;
+    }
+    double t0 = now();
+    for(int i = 0; i < numSteps; i++)
+    {
+        seed = seed*1103515245u + 12345u;
+        int k = (seed >> 8) % numLive;
+        heapDealloc(heap, live[k]);
+        long numBytes = nextSize(&seed);
+        live[k] = heapAlloc(heap, numBytes);
+        live[k][0] = 1;
+        live[k][numBytes - 1] = 1;
+    }
+    double elapsed = now() - t0;
+    for(int i = 0; i < numLive; i++) heapDealloc(heap, live[i]);
+    free(live);
+    return 1e9*elapsed/numSteps;
+}
+
+int main()
+{
+    int numLive[] = { 100, 10000, 1000000 };
+    for(int i = 0; i < 3; i++)
+    {
+        printf("%8d live: core_alloc %7.2f ns/step, malloc %7.2f ns/step", numLive[i],
+                churn(HEAP_CORE, numLive[i], 10000000), churn(HEAP_MALLOC, numLive[i], 10000000));
+        //The system limits the number of mappings a process may have. 
+        if(numLive[i] <= 10000) printf(", mmap %8.2f ns/step", churn(HEAP_MAP, numLive[i], 200000));
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,106 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+/*
+ * Compares scratch data allocated in an arena (`heaped in arena A`, then `unheap arena A`) against the same
+ * data allocated and unheaped piece by piece, as tabic builds each.
+ *
+ * Each request allocates a number of collections of a few dozen bytes, each holding a vector of 16 Int,
+ * so that every heaped variable is two allocations (as allocateHeapType makes them), and then frees them all.
+ *
+ * As with bench_table_insert, this is linked against tabi_core_cross, which calls _tabi_main.
+ */
+#include<stdio.h>
+#include<time.h>
+
+void* core_alloc(long numBytes);
+void* core_alloc_aligned(long numBytes);
+void  core_dealloc(void* ptr);
+void* core_arena_alloc(void** arena, long numBytes, long alignment);
+void  core_arena_release(void** arena);
+
+#define NUM_ELEM 16
+
+/** @brief A collection with a vector member, as tabic lays out `collection type Item { Long key; Vec[Int, 16] values; }`.
+ */
+typedef struct Item
+{
+    long long key;
+    int* values;
+} Item;
+
+static double now()
+{
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + 1e-9*t.tv_nsec;
+}
+
+static Item* items[4096];
+
+static double heapRequests(int numRequests, int numItems)
+{
+    double t0 = now();
+    for(int r = 0; r < numRequests; r++)
+    {
+        for(int i = 0; i < numItems; i++)
+        {
+            Item* item = core_alloc(sizeof(Item));
+            item->values = core_alloc_aligned(NUM_ELEM*sizeof(int));
+            item->key = i;
+            item->values[0] = r;
+            items[i] = item;
+        }
+        for(int i = 0; i < numItems; i++)
+        {
+            core_dealloc(items[i]->values);
+            core_dealloc(items[i]);
+        }
+    }
+    return 1e9*(now() - t0)/((double)numRequests*numItems);
+}
+
+static double arenaRequests(int numRequests, int numItems)
+{
+    void* arena = 0;
+    double t0 = now();
+    for(int r = 0; r < numRequests; r++)
+    {
+        for(int i = 0; i < numItems; i++)
+        {
+            Item* item = core_arena_alloc(&arena, sizeof(Item), 16);
+            item->values = core_arena_alloc(&arena, NUM_ELEM*sizeof(int), 64);
+            item->key = i;
+            item->values[0] = r;
+            items[i] = item;
+        }
+        core_arena_release(&arena);
+    }
+    return 1e9*(now() - t0)/((double)numRequests*numItems);
+}
+
+void _tabi_init() {}
+void _tabi_destroy() {}
+
+int _tabi_main()
+{
+    int numItems[] = { 16, 256, 4096 };
+    for(int i = 0; i < 3; i++)
+    {
+        int numRequests = 20000000/numItems[i];
+        printf("%5d items/request: heap %6.2f ns/item, arena %6.2f ns/item\n", numItems[i],
+                heapRequests(numRequests, numItems[i]), arenaRequests(numRequests, numItems[i]));
+    }
+    return 0;
+}
@@ -0,0 +1,107 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0. 
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk 
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+/*
+ * Compares looking up a row by the value of an `indexed` field through core_hash_find,
+ * against the linear scan over used rows which a field without an index needs. 
+ *
+ * As with bench_table_insert, this is linked against tabi_core_cross, which calls _tabi_main. 
+ */
+#include<stdio.h>
+#include<time.h>
+
+void* core_alloc(long numBytes); 
+void  core_dealloc(void* ptr); 
+void  core_table_init(void** table, int numRows); 
+int   core_table_insertRow(void** table, int numRows, int* id); 
+int   core_hash_getSize(int numRows); 
+void  core_hash_init(int* hash, int numRows); 
+void  core_hash_insert(int* hash, void* field, int keySize, unsigned int* useField, int numRows, int row); 
+int   core_hash_find(int* hash, void* field, int keySize, unsigned int* useField, unsigned long long key); 
+
+static double now()
+{
+    struct timespec t; 
+    clock_gettime(CLOCK_MONOTONIC, &t); 
+    return t.tv_sec + 1e-9*t.tv_nsec; 
+}
+
+/** @brief Returns the first used row whose key is \p key, as a lookup on a field without an index would. 
+ */
+static int scanForKey(void** table, int numRows, int key)
+{
+    unsigned int* useField = table[1]; 
+    int* keys = table[3]; 
+    for(int row = 0; row < numRows; row++)
+    {
+        if((useField[row >> 5] >> (row & 31)) & 1u && keys[row] == key) return row; 
+    }
+    return -1; 
+}
+
+/** @brief Fills a table with distinct keys, then looks up \p numLookups of them (and as many absent keys) both ways. 
+ */
+static void benchLookup(int numRows, int numLookups)
+{
+    //id, #use, #index and a single indexed Int field
+    void* table[4]; 
+    table[0] = core_alloc(numRows*sizeof(int)); 
+    table[1] = core_alloc((numRows + 31)/32*sizeof(int)); 
+    table[2] = core_alloc((2*numRows + 4)*sizeof(int)); 
+    table[3] = core_alloc(numRows*sizeof(int)); 
+    int* hash = core_alloc(core_hash_getSize(numRows)*sizeof(int)); 
+    core_table_init(table, numRows); 
+    core_hash_init(hash, numRows); 
+    for(int i = 0; i < numRows; i++)
+    {
+        int row = core_table_insertRow(table, numRows, 0); 
+        //Odd keys, so that even keys are absent. 
+        ((int*)table[3])[row] = 2*(int)((i*2654435761u) % numRows) + 1; 
+        core_hash_insert(hash, table[3], sizeof(int), table[1], numRows, row); 
+    }
+    unsigned int seed = 1; 
+    int found = 0; 
+    double t0 = now(); 
+    for(int i = 0; i < numLookups; i++)
+    {
+        seed = seed*1103515245u + 12345u; 
+        int key = (int)(seed % (2u*numRows)); 
+        found += core_hash_find(hash, table[3], sizeof(int), table[1], (unsigned int)key) >= 0; 
+    }
+    double hashed = now() - t0; 
+    seed = 1; 
+    t0 = now(); 
+    for(int i = 0; i < numLookups; i++)
+    {
+        seed = seed*1103515245u + 12345u; 
+        int key = (int)(seed % (2u*numRows)); 
+        found -= scanForKey(table, numRows, key) >= 0; 
+    }
+    double scanned = now() - t0; 
+    printf("%10d rows: hash %8.2f ns/lookup, scan %12.2f ns/lookup (%s)\n", 
+            numRows, 1e9*hashed/numLookups, 1e9*scanned/numLookups, found ? "MISMATCH" : "agree"); 
+    for(int i = 0; i < 4; i++) core_dealloc(table[i]); 
+    core_dealloc(hash); 
+}
+
+void _tabi_init() {}
+void _tabi_destroy() {}
+
+int _tabi_main()
+{
+    benchLookup(1000, 100000); 
+    benchLookup(100000, 10000); 
+    benchLookup(10000000, 100); 
+    return 0; 
+}
@@ -0,0 +1,80 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0. 
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk 
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+/*
+ * Measures the throughput of core_table_insertRow. 
+ *
+ * The benchmark stands in for a compiled Tabitha program, so it is linked against tabi_core_cross
+ * which supplies main() and calls _tabi_main. 
+ */
+#include<stdio.h>
+#include<time.h>
+
+void* core_alloc(long numBytes); 
+void  core_dealloc(void* ptr); 
+void  core_table_init(void** table, int numRows); 
+int   core_table_insertRow(void** table, int numRows, int* id); 
+void  core_table_deleteRowByID(void** table, int numRows, int id); 
+
+static double now()
+{
+    struct timespec t; 
+    clock_gettime(CLOCK_MONOTONIC, &t); 
+    return t.tv_sec + 1e-9*t.tv_nsec; 
+}
+
+/** @brief Fills a table of the given size, then churns it by deleting and re-inserting rows. 
+ */
+static void benchInsert(int numRows)
+{
+    //id, #use, #index and a single Int field
+    void* table[4]; 
+    table[0] = core_alloc(numRows*sizeof(int)); 
+    table[1] = core_alloc((numRows + 31)/32*sizeof(int)); 
+    table[2] = core_alloc((2*numRows + 4)*sizeof(int)); 
+    table[3] = core_alloc(numRows*sizeof(int)); 
+    core_table_init(table, numRows); 
+    //Fill the table from empty.
+    double t0 = now(); 
+    for(int i = 0; i < numRows; i++) 
+    {
+        int id; 
+        int row = core_table_insertRow(table, numRows, &id); 
+        ((int*)table[3])[row] = id; 
+    }
+    double fill = now() - t0; 
+    //Delete and re-insert every other id.
+    t0 = now(); 
+    for(int i = 0; i < numRows; i += 2) 
+    {
+        core_table_deleteRowByID(table, numRows, i); 
+        core_table_insertRow(table, numRows, 0); 
+    }
+    double churn = now() - t0; 
+    int numChurned = (numRows + 1) / 2; 
+    printf("%10d rows: fill %8.2f ns/insert (%7.2f M/s), churn %8.2f ns/delete+insert\n", 
+            numRows, 1e9*fill/numRows, 1e-6*numRows/fill, 1e9*churn/numChurned); 
+    for(int i = 0; i < 4; i++) core_dealloc(table[i]); 
+}
+
+void _tabi_init() {}
+void _tabi_destroy() {}
+
+int _tabi_main()
+{
+    benchInsert(1000); 
+    benchInsert(100000); 
+    benchInsert(10000000); 
+    return 0; 
+}
@@ -0,0 +1,168 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0. 
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository, 
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at, 
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+/*
+ * Compares the two layouts of a table with eight user fields: an array per field (the default), 
+ * and a `row major` array of records. Both are laid out as tabic lays them out, with the `id`, `#use`
+ * and `#index` fields apart, and rows are found as compiled code finds them, through core_table_getRowByID. 
+ *
+ * The row workload reads every field of rows picked at random, as code working on one row at a time does. 
+ * The column workload sums one field over the used rows, as an aggregate does. 
+ *
+ * As with bench_table_insert, this is linked against tabi_core_cross, which calls _tabi_main. 
+ */
+#include<stdio.h>
+#include<time.h>
+
+void* core_alloc(long numBytes); 
+void  core_dealloc(void* ptr); 
+void  core_table_init(void** table, int numRows); 
+int   core_table_insertRow(void** table, int numRows, int* id); 
+int   core_table_getRowByID(void** table, int numRows, int id); 
+
+#define NUM_FIELDS 8
+
+/** @brief One row of the user's fields of a `row major` table, as the LLVM struct tabic gives it. 
+ */
+typedef struct Record
+{
+    int a; 
+    int b; 
+    long long c; 
+    long long d; 
+    double e; 
+    double f; 
+    float g; 
+    int h; 
+} Record; 
+
+static const int fieldSizes[NUM_FIELDS] = { sizeof(int), sizeof(int), sizeof(long long), sizeof(long long), sizeof(double), sizeof(double), sizeof(float), sizeof(int) }; 
+
+static double now()
+{
+    struct timespec t; 
+    clock_gettime(CLOCK_MONOTONIC, &t); 
+    return t.tv_sec + 1e-9*t.tv_nsec; 
+}
+
+/** @brief Allocates and fills a table of either layout, with every row used and row i holding id i. 
+ */
+static void makeTable(void** table, int numRows, int rowMajor)
+{
+    table[0] = core_alloc(numRows*sizeof(int)); 
+    table[1] = core_alloc((numRows + 31)/32*sizeof(int)); 
+    table[2] = core_alloc((2*numRows + 4)*sizeof(int)); 
+    if(rowMajor) table[3] = core_alloc(numRows*sizeof(Record)); 
+    else for(int k = 0; k < NUM_FIELDS; k++) table[3 + k] = core_alloc(numRows*fieldSizes[k]); 
+    core_table_init(table, numRows); 
+    for(int i = 0; i < numRows; i++)
+    {
+        int row = core_table_insertRow(table, numRows, 0); 
+        if(rowMajor)
+        {
+            Record* r = (Record*)table[3] + row; 
+            r->a = i; r->b = 2*i; r->c = 3*i; r->d = 4*i; r->e = 0.5*i; r->f = 0.25*i; r->g = i; r->h = -i; 
+        }
+        else
+        {
+            ((int*)table[3])[row] = i; ((int*)table[4])[row] = 2*i; 
+            ((long long*)table[5])[row] = 3*i; ((long long*)table[6])[row] = 4*i; 
+            ((double*)table[7])[row] = 0.5*i; ((double*)table[8])[row] = 0.25*i; 
+            ((float*)table[9])[row] = i; ((int*)table[10])[row] = -i; 
+        }
+    }
+}
+
+static void freeTable(void** table, int rowMajor)
+{
+    int numArrays = rowMajor ? 4 : 3 + NUM_FIELDS; 
+    for(int i = 0; i < numArrays; i++) core_dealloc(table[i]); 
+}
+
+/** @brief Reads every field of \p numReads rows picked at random, returning their total. 
+ */
+static double readRows(void** table, int numRows, int rowMajor, int numReads)
+{
+    double total = 0.0; 
+    unsigned int seed = 1; 
+    for(int i = 0; i < numReads; i++)
+    {
+        seed = seed*1103515245u + 12345u; 
+        int row = core_table_getRowByID(table, numRows, (int)(seed % (unsigned int)numRows)); 
+        if(rowMajor)
+        {
+            Record* r = (Record*)table[3] + row; 
+            total += r->a + r->b + r->c + r->d + r->e + r->f + r->g + r->h; 
+        }
+        else
+        {
+            total += ((int*)table[3])[row] + ((int*)table[4])[row]
+                + ((long long*)table[5])[row] + ((long long*)table[6])[row]
+                + ((double*)table[7])[row] + ((double*)table[8])[row]
+                + ((float*)table[9])[row] + ((int*)table[10])[row]; 
+        }
+    }
+    return total; 
+}
+
+/** @brief Sums the field `e` over the used rows. 
+ */
+static double sumColumn(void** table, int numRows, int rowMajor)
+{
+    unsigned int* useField = table[1]; 
+    double total = 0.0; 
+    for(int row = 0; row < numRows; row++)
+    {
+        if(!((useField[row >> 5] >> (row & 31)) & 1u)) continue; 
+        total += rowMajor ? ((Record*)table[3])[row].e : ((double*)table[7])[row]; 
+    }
+    return total; 
+}
+
+static void benchLayout(int numRows, int numReads, int numScans)
+{
+    void* columns[3 + NUM_FIELDS]; 
+    void* records[3 + NUM_FIELDS]; 
+    makeTable(columns, numRows, 0); 
+    makeTable(records, numRows, 1); 
+    double t0 = now(); 
+    double check = readRows(columns, numRows, 0, numReads); 
+    double columnRows = now() - t0; 
+    t0 = now(); 
+    check -= readRows(records, numRows, 1, numReads); 
+    double recordRows = now() - t0; 
+    t0 = now(); 
+    for(int i = 0; i < numScans; i++) check += sumColumn(columns, numRows, 0); 
+    double columnScan = now() - t0; 
+    t0 = now(); 
+    for(int i = 0; i < numScans; i++) check -= sumColumn(records, numRows, 1); 
+    double recordScan = now() - t0; 
+    printf("%10d rows: rows %7.2f/%7.2f ns/row, scan %6.3f/%6.3f ns/row (columns/records, %s)\n", 
+            numRows, 1e9*columnRows/numReads, 1e9*recordRows/numReads, 
+            1e9*columnScan/((double)numScans*numRows), 1e9*recordScan/((double)numScans*numRows), 
+            check == 0.0 ? "agree" : "MISMATCH"); 
+    freeTable(columns, 0); 
+    freeTable(records, 1); 
+}
+
+void _tabi_init() {}
+void _tabi_destroy() {}
+
+int _tabi_main()
+{
+    benchLayout(10000, 10000000, 1000); 
+    benchLayout(1000000, 10000000, 20); 
+    benchLayout(10000000, 10000000, 4); 
+    return 0; 
+}
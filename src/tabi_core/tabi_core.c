@@ -12,65 +12,234 @@ https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
 
 */
 
-void* core_alloc(long numBytes); 
-void  core_memcpy(void* dest, void* src, long numBytes); 
+#include"tabi_core_simd.h"
+#include"tabi_core_table.h"
 
-/** @brief Initialised an allocated table by setting all of the 'use' field to zero. 
+#ifdef CORE_SIMD_X86
+#include<cpuid.h>
+#endif
+
+void* core_alloc(long long numBytes); 
+void* core_alloc_aligned(long long numBytes); 
+void  core_dealloc(void* ptr); 
+void  core_memcpy(void* dest, void* src, long long numBytes); 
+void  core_memmove(void* dest, void* src, long long numBytes); 
+
+static unsigned int* core_table_use(void** table)
+{
+    return *((unsigned int**)table + 1); 
+}
+
+static int* core_table_header(void** table)
+{
+    return *((int**)table + 2); 
+}
+
+static int* core_table_index(void** table)
+{
+    return core_table_header(table) + CORE_TABLE_INDEX_HEADER; 
+}
+
+static int* core_table_freeIDs(void** table, int numRows)
+{
+    return core_table_index(table) + numRows; 
+}
+
+/** @brief Returns the first used row at or after \p row, or numRows if there is none. 
+ *
+ * Whole words of the `#use` bitmap are skipped at a time.
+ */
+static int core_table_nextUsed(unsigned int* useField, int numRows, int row)
+{
+    if(row >= numRows) return numRows; 
+    int w = row >> 5; 
+    int numWords = (numRows + 31) >> 5; 
+    unsigned int word = useField[w] & (~0u << (row & 31)); 
+    while(!word)
+    {
+        if(++w == numWords) return numRows; 
+        word = useField[w]; 
+    }
+    return (w << 5) + __builtin_ctz(word); 
+}
+
+/** @brief Returns the first unused row at or after \p row, or numRows if there is none. 
+ */
+static int core_table_nextUnused(unsigned int* useField, int numRows, int row)
+{
+    if(row >= numRows) return numRows; 
+    int w = row >> 5; 
+    int numWords = (numRows + 31) >> 5; 
+    unsigned int word = ~useField[w] & (~0u << (row & 31)); 
+    while(!word)
+    {
+        if(++w == numWords) return numRows; 
+        word = ~useField[w]; 
+    }
+    int next = (w << 5) + __builtin_ctz(word); 
+    return next < numRows ? next : numRows; 
+}
+
+/** @brief Takes the first row off the free row list and marks it as used, returning -1 if the table is full. 
+ */
+static int core_table_claimRow(void** table)
+{
+    int* idField  = *(int**)table; 
+    unsigned int* useField = core_table_use(table);
+    int* header = core_table_header(table); 
+    int row = header[CORE_TABLE_FREE_ROW]; 
+    if(row == -1) return row; 
+    header[CORE_TABLE_FREE_ROW] = idField[row]; 
+    header[CORE_TABLE_NUM_USED]++; 
+    useField[row >> 5] |= 1u << (row & 31); 
+    return row; 
+}
+
+/** @brief Marks a row as unused and puts it back on the free row list. 
+ */
+static void core_table_releaseRow(void** table, int row)
+{
+    int* idField  = *(int**)table; 
+    unsigned int* useField = core_table_use(table);
+    int* header = core_table_header(table); 
+    useField[row >> 5] &= ~(1u << (row & 31)); 
+    idField[row] = header[CORE_TABLE_FREE_ROW]; 
+    header[CORE_TABLE_FREE_ROW] = row; 
+    header[CORE_TABLE_NUM_USED]--; 
+}
+
+/** @brief Puts a free id at position \p k of the free id heap, and points the index at it. 
+ */
+static void core_table_placeID(int* index, int* freeIDs, int k, int id)
+{
+    freeIDs[k] = id; 
+    index[id] = -1 - k; 
+}
+
+/** @brief Moves the free id at position \p k of the free id heap up or down until the heap is ordered again. 
+ */
+static void core_table_siftID(int* index, int* freeIDs, int numFreeIDs, int k)
+{
+    int id = freeIDs[k]; 
+    while(k > 0 && freeIDs[(k - 1)/2] > id)
+    {
+        core_table_placeID(index, freeIDs, k, freeIDs[(k - 1)/2]); 
+        k = (k - 1)/2; 
+    }
+    while(2*k + 1 < numFreeIDs)
+    {
+        int child = 2*k + 1; 
+        if(child + 1 < numFreeIDs && freeIDs[child + 1] < freeIDs[child]) child++; 
+        if(freeIDs[child] > id) break; 
+        core_table_placeID(index, freeIDs, k, freeIDs[child]); 
+        k = child; 
+    }
+    core_table_placeID(index, freeIDs, k, id); 
+}
+
+/** @brief Removes a free id (in [0, numRows)) from the free id heap, by moving the last id of the heap into its place. 
+ */
+static void core_table_claimID(void** table, int numRows, int id)
+{
+    int* header = core_table_header(table); 
+    int* index = core_table_index(table); 
+    int* freeIDs = core_table_freeIDs(table, numRows); 
+    int k = -1 - index[id]; 
+    int numFreeIDs = --header[CORE_TABLE_NUM_FREE_IDS]; 
+    if(k == numFreeIDs) return; 
+    core_table_placeID(index, freeIDs, k, freeIDs[numFreeIDs]); 
+    core_table_siftID(index, freeIDs, numFreeIDs, k); 
+}
+
+/** @brief Adds an id (in [0, numRows)) to the free id heap. 
+ */
+static void core_table_releaseID(void** table, int numRows, int id)
+{
+    int* header = core_table_header(table); 
+    int* index = core_table_index(table); 
+    int* freeIDs = core_table_freeIDs(table, numRows); 
+    int k = header[CORE_TABLE_NUM_FREE_IDS]++; 
+    core_table_placeID(index, freeIDs, k, id); 
+    core_table_siftID(index, freeIDs, k + 1, k); 
+}
+
+/** @brief Initialised an allocated table by clearing the `#use` bitmap, and filling the free lists. 
+ *
+ * The free row list is filled so that a fresh table hands out rows in increasing order. 
+ * The ids in increasing order already form a heap. 
  */
 void core_table_init(void** table, int numRows)
 {
     int* idField = *(int**)table; 
-    int* useField = *((int**)table + 1);
-    for(int i = 0; i < numRows; i++) useField[i] = 0; 
+    unsigned int* useField = core_table_use(table);
+    int* header = core_table_header(table); 
+    int* index = core_table_index(table); 
+    int* freeIDs = core_table_freeIDs(table, numRows); 
+    for(int w = 0; w < (numRows + 31) >> 5; w++) useField[w] = 0; 
+    for(int i = 0; i < numRows; i++) 
+    {
+        idField[i] = i + 1 < numRows ? i + 1 : -1; 
+        freeIDs[i] = i; 
+        index[i] = -1 - i; 
+    }
+    header[CORE_TABLE_FREE_ROW] = numRows > 0 ? 0 : -1; 
+    header[CORE_TABLE_NUM_FREE_IDS] = numRows; 
+    header[CORE_TABLE_NUM_USED] = 0; 
+    header[CORE_TABLE_NUM_ROWS] = numRows; 
 }
 
-/** @brief Figures out the smallest unused id and inserts it into the first unused row. 
+/** @brief Takes the smallest unused id and inserts it into an unused row. 
  *
  * Returns the inserted row number, and stores the id in an argument. 
  */
 int core_table_insertRow(void** table, int numRows, int* id)
 {
     int* idField = *(int**)table; 
-    int* useField = *((int**)table + 1);
-    int newRow = -1; 
-    int count[numRows]; 
-    for(int i = 0; i < numRows; i++) count[i] = 0; 
-    for(int i = 0; i < numRows; i++)
-    {
-        if(newRow == -1 && useField[i] == 0) newRow = i; 
-        if(useField[i] == 1) count[idField[i]]++; 
-    }
+    int* index = core_table_index(table); 
+    int* freeIDs = core_table_freeIDs(table, numRows); 
+    int newRow = core_table_claimRow(table); 
     if(newRow == -1) return newRow;
-    int id0; 
-    for(int i = 0; i < numRows; i++)
-    {
-        if(count[i] == 0) 
-        {
-            id0 = i; 
-            break;
-        }
-    }
+    //Since there is a free row, at most numRows - 1 ids in [0, numRows) are in use, so the heap is not empty. 
+    int id0 = freeIDs[0]; 
+    core_table_claimID(table, numRows, id0); 
     if(id) *id = id0; 
     idField[newRow] = id0; 
-    useField[newRow] = 1; 
+    index[id0] = newRow; 
     return newRow;
 }
 
-/** @brief Returns the row associated with the given id, or returns the first free row (now with the correct id) if not found. 
+/** @brief Returns the row associated with the given id, or -1 if there is none. 
  */
-int core_table_getRowByID(void** table, int numRows, int id)
+int core_table_findRowByID(void** table, int numRows, int id)
 {
     int* idField  = *(int**)table; 
-    int* useField = *((int**)table + 1);
-    int newRow = -1; 
-    for(int i = 0; i < numRows; i++)
+    unsigned int* useField = core_table_use(table);
+    int* index = core_table_index(table); 
+    if(id >= 0 && id < numRows) return index[id] >= 0 ? index[id] : -1; 
+    for(int i = core_table_nextUsed(useField, numRows, 0); i < numRows; i = core_table_nextUsed(useField, numRows, i + 1))
     {
-        if(newRow == -1 && useField[i] == 0) newRow = i; 
-        if(useField[i] == 1 && idField[i] == id) return i; 
+        if(idField[i] == id) return i; 
     }
+    return -1; 
+}
+
+/** @brief Returns the row associated with the given id, or returns a free row (now with the correct id) if not found. 
+ */
+int core_table_getRowByID(void** table, int numRows, int id)
+{
+    int* idField  = *(int**)table; 
+    int* index = core_table_index(table); 
+    int indexed = id >= 0 && id < numRows; 
+    int row = core_table_findRowByID(table, numRows, id); 
+    if(row >= 0) return row; 
+    int newRow = core_table_claimRow(table); 
     if(newRow == -1) return newRow; 
     idField[newRow] = id; 
-    useField[newRow] = 1; 
+    if(indexed) 
+    {
+        core_table_claimID(table, numRows, id); 
+        index[id] = newRow; 
+    }
     return newRow; 
 }
 
@@ -81,63 +250,179 @@ int core_table_getRowByID(void** table, int numRows, int id)
 void core_table_deleteRowByID(void** table, int numRows, int id)
 {
     int* idField  = *(int**)table; 
-    int* useField = *((int**)table + 1);
-    for(int i = 0; i < numRows; i++)
+    unsigned int* useField = core_table_use(table);
+    int* index = core_table_index(table); 
+    if(id >= 0 && id < numRows)
     {
-        if(id == idField[i]) 
-        {
-            useField[i] = 0; 
-        }
+        if(index[id] < 0) return; 
+        core_table_releaseRow(table, index[id]); 
+        core_table_releaseID(table, numRows, id); 
+        return; 
+    }
+    for(int i = core_table_nextUsed(useField, numRows, 0); i < numRows; i = core_table_nextUsed(useField, numRows, i + 1))
+    {
+        if(id == idField[i]) core_table_releaseRow(table, i); 
     }
 }
 
-/** @brief Counts the number of used rows in a table. 
+/** @brief Returns the number of used rows in a table. 
+ *
+ * This is kept as a running count, so is constant-time. 
  */ 
-int core_table_getNumUsed(void** table, int numRows)
+int core_table_getNumUsed(void** table)
 {
-    int* useField = *((int**)table + 1);
-    int numUsed = 0; 
-    for(int i = 0; i < numRows; i++)
+    return core_table_header(table)[CORE_TABLE_NUM_USED];
+}
+
+/** @brief Moves the used elements of one field to the top of that field, keeping their order. 
+ *
+ * Each run of consecutive used rows is moved with a single core_memmove. 
+ */
+static void core_table_compactField(void* field, int fieldSize, unsigned int* useField, int numRows)
+{
+    int dest = 0; 
+    int start = core_table_nextUsed(useField, numRows, 0); 
+    while(start < numRows)
     {
-        if(useField[i] == 1) numUsed++;
+        int end = core_table_nextUnused(useField, numRows, start); 
+        if(start != dest) 
+        {
+            core_memmove((char*)field + (long long)fieldSize*dest, (char*)field + (long long)fieldSize*start, (long long)fieldSize*(end - start)); 
+        }
+        dest += end - start; 
+        start = core_table_nextUsed(useField, numRows, end); 
     }
-    return numUsed;
 }
 
-/** @brief Moves all used rows to the top of the table.
+/** @brief Moves all used rows to the top of the table, keeping their order.
+ *
+ * The table is compacted one field at a time in a single pass over the `#use` bitmap, 
+ * after which the id index, the bitmap and the free row list are rebuilt. 
+ * The id of the topmost row is stored in \p topmost (if given). 
  */
 void core_table_crunch(void** table, int numRows, int numFields, int* fieldSizes, int* topmost)
 {
-    int numUsed = core_table_getNumUsed(table, numRows);  
-    if(numUsed >= numRows) return;
+    int numUsed = core_table_getNumUsed(table);  
     int* idField  = *(int**)table; 
-    int* useField = *((int**)table + 1);
-    void* fields[numFields]; 
-    for(int i = 0; i < numFields; i++) 
+    unsigned int* useField = core_table_use(table);
+    int* index = core_table_index(table); 
+    if(numUsed < numRows)
+    {
+        for(int k = 0; k < numFields; k++) 
+        {
+            core_table_compactField(*(table + CORE_TABLE_META_FIELDS + k), fieldSizes[k], useField, numRows); 
+        }
+        core_table_compactField(idField, sizeof(int), useField, numRows); 
+        for(int i = 0; i < numUsed; i++) 
+        {
+            if(idField[i] >= 0 && idField[i] < numRows) index[idField[i]] = i; 
+        }
+        //The used rows are now exactly those before numUsed.
+        for(int w = 0; w < (numRows + 31) >> 5; w++)
+        {
+            if((w + 1) << 5 <= numUsed) useField[w] = ~0u; 
+            else if(w << 5 < numUsed) useField[w] = (1u << (numUsed & 31)) - 1; 
+            else useField[w] = 0; 
+        }
+        for(int i = numUsed; i < numRows; i++) idField[i] = i + 1 < numRows ? i + 1 : -1; 
+        core_table_header(table)[CORE_TABLE_FREE_ROW] = numUsed; 
+    }
+    if(topmost && numUsed > 0) *topmost = idField[0]; 
+}
+
+
+/** @brief Moves a field into a newly allocated array of \p newLength elements, keeping its first \p oldLength elements. 
+ *
+ * The new array is aligned as the compiled code aligns table fields. 
+ */
+static void* core_table_growField(void* field, int fieldSize, int oldLength, int newLength)
+{
+    void* grown = core_alloc_aligned((long long)fieldSize*newLength); 
+    core_memcpy(grown, field, (long long)fieldSize*oldLength); 
+    core_dealloc(field); 
+    return grown; 
+}
+
+/** @brief Makes sure a growable table has a free row, by doubling its number of rows if it is full. 
+ *
+ * Every field is moved into a larger array, with existing rows keeping their row number and id,
+ * so row handles (ids) remain valid. Addresses of individual elements do not.
+ * New rows are put at the front of the free row list, and the new ids are indexed, with any of them 
+ * already in use (having been made through core_table_getRowByID) being indexed to their rows. 
+ *
+ * A table is not grown past \p maxRows, in which case it stays full. This is CORE_TABLE_MAX_ROWS, 
+ * or CORE_TABLE_MAX_INDEXED_ROWS for a table with a hash index. 
+ *
+ * Returns the number of rows the table now has. 
+ */
+int core_table_reserve(void** table, int numRows, int maxRows, int numFields, int* fieldSizes)
+{
+    int* header = core_table_header(table); 
+    if(header[CORE_TABLE_FREE_ROW] != -1 || numRows >= maxRows) return numRows; 
+    int newRows = numRows < CORE_TABLE_MIN_GROWN_ROWS/2 ? CORE_TABLE_MIN_GROWN_ROWS 
+        : numRows < maxRows/2 ? 2*numRows : maxRows; 
+    for(int k = 0; k < numFields; k++)
+    {
+        table[CORE_TABLE_META_FIELDS + k] = core_table_growField(table[CORE_TABLE_META_FIELDS + k], fieldSizes[k], numRows, newRows); 
+    }
+    table[0] = core_table_growField(table[0], sizeof(int), numRows, newRows); 
+    int oldWords = (numRows + 31) >> 5; 
+    int newWords = (newRows + 31) >> 5; 
+    table[1] = core_table_growField(table[1], sizeof(int), oldWords, newWords); 
+    //The index and free id heap both move, so the `#index` field is rebuilt piecewise. 
+    int numFreeIDs = header[CORE_TABLE_NUM_FREE_IDS]; 
+    int* grownHeader = core_alloc(sizeof(int)*(CORE_TABLE_INDEX_HEADER + 2LL*newRows)); 
+    core_memcpy(grownHeader, header, sizeof(int)*(CORE_TABLE_INDEX_HEADER + (long long)numRows)); 
+    core_memcpy(grownHeader + CORE_TABLE_INDEX_HEADER + newRows, header + CORE_TABLE_INDEX_HEADER + numRows, sizeof(int)*(long long)numFreeIDs); 
+    core_dealloc(header); 
+    table[2] = grownHeader; 
+    header = grownHeader; 
+
+    int* idField = *(int**)table; 
+    unsigned int* useField = core_table_use(table); 
+    int* index = core_table_index(table); 
+    for(int w = oldWords; w < newWords; w++) useField[w] = 0; 
+    //Mark the new ids as unclaimed (no row is numbered newRows), then index those already in use. 
+    for(int id = numRows; id < newRows; id++) index[id] = newRows; 
+    for(int i = core_table_nextUsed(useField, numRows, 0); i < numRows; i = core_table_nextUsed(useField, numRows, i + 1))
     {
-        fields[i] = (void*)*((int**)table + 2 + i); 
+        if(idField[i] >= numRows && idField[i] < newRows) index[idField[i]] = i; 
     }
-    for(int i = 0; i < numUsed; i++)
+    //Each new id is larger than all of the heap, so adding them in increasing order takes constant time each. 
+    for(int id = numRows; id < newRows; id++)
     {
-        if(useField[i] == 0)
+        if(index[id] == newRows) core_table_releaseID(table, newRows, id); 
+    }
+    for(int i = numRows; i < newRows; i++) idField[i] = i + 1 < newRows ? i + 1 : -1; 
+    header[CORE_TABLE_FREE_ROW] = numRows; 
+    header[CORE_TABLE_NUM_ROWS] = newRows; 
+    return newRows; 
+}
+
+static int core_simd_level = -1; 
+
+int core_simd_getLevel(void)
+{
+    if(core_simd_level >= 0) return core_simd_level; 
+    int level = CORE_SIMD_NONE; 
+#ifdef CORE_SIMD_X86
+    unsigned int eax, ebx, ecx, edx; 
+    if(__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        if(edx & bit_SSE2) level = CORE_SIMD_SSE2; 
+        //AVX2 also needs the OS to save the upper halves of the ymm registers. 
+        if((ecx & bit_OSXSAVE) && (ecx & bit_AVX))
         {
-            for(int j = numUsed; j < numRows; j++)
-            {
-                if(useField[j] == 1)
-                {
-                    idField[i] = useField[j];
-                    useField[i] = useField[j];
-                    useField[j] = 0; 
-                    for(int k = 0; k < numFields; k++) core_memcpy(fields[k] + fieldSizes[k]*i, fields[k] + fieldSizes[k]*j, fieldSizes[k]); 
-                    break;
-                }
-            }
+            unsigned int xcr0Low, xcr0High; 
+            __asm__ volatile("xgetbv" : "=a"(xcr0Low), "=d"(xcr0High) : "c"(0)); 
+            if((xcr0Low & 6) == 6 && __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_AVX2)) level = CORE_SIMD_AVX2; 
         }
     }
-    if(topmost) *topmost = idField[0]; 
+#endif
+    core_simd_level = level; 
+    return level; 
 }
 
-
 /** @brief Makes copies of a vectors elements (which are themselves vectors) and replaces the original elements with the copies. 
  *
  * This is called when passing e.g. a variable of type Vec[Vec[Int, 5], 5] by values.
@@ -154,8 +439,8 @@ void core_subvector_copy(void*** vec, int ptrSize, int elemSize, int numPtr, int
     {
         void** subVecPtr = *(vec + i*ptrSize); 
         void*  subVec    = *subVecPtr;
-        void* subVecCopy = core_alloc(elemSize*numElem); 
-        core_memcpy(subVecCopy, subVec, elemSize*numElem); 
+        void* subVecCopy = core_alloc_aligned((long long)elemSize*numElem); 
+        core_memcpy(subVecCopy, subVec, (long long)elemSize*numElem); 
         *subVecPtr = subVecCopy; 
     }
 }
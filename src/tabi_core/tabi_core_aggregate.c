@@ -0,0 +1,207 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+#include"tabi_core_simd.h"
+
+#include<limits.h>
+#include<stddef.h>
+#include<stdint.h>
+
+/* Aggregates (sum, min and max) over a single field of a table.
+ *
+ * Each kernel is given the field, the table's `#use` bitmap and the number of rows, and only
+ * takes used rows into account. The bitmap is read a word (32 rows) at a time: empty words are skipped,
+ * and the rows of other words are loaded a vector at a time, with unused lanes replaced by the
+ * identity of the aggregate. Only the rows of a final, partial word are handled one by one.
+ *
+ * Every kernel is built for 128-bit vectors, and on x86 also for 256-bit AVX2 vectors,
+ * with the public function choosing between them at runtime. The vectors are written with
+ * the GCC vector extensions, so that the compiler picks the instructions for each width.
+ *
+ * The min and max of a table with no used rows are zero.
+ *
+ * The mean has kernels of its own, which sum into a wider type (so that e.g. the sum of an Int field cannot overflow)
+ * and divide by the number of used rows, giving a Double. The mean of a table with no used rows is zero.
+ */
+
+#define CORE_AGGREGATE_SUM(acc, x) ((acc) += (x))
+#define CORE_AGGREGATE_MIN(acc, x) ((acc) = (x) < (acc) ? (x) : (acc))
+#define CORE_AGGREGATE_MAX(acc, x) ((acc) = (x) > (acc) ? (x) : (acc))
+
+#define CORE_AGGREGATE_VSUM(vec, mask, acc, x) ((acc) += (x))
+#define CORE_AGGREGATE_VMIN(vec, mask, acc, x) ((acc) = (vec)(((mask)(x) & (mask)((x) < (acc))) | ((mask)(acc) & ~(mask)((x) < (acc)))))
+#define CORE_AGGREGATE_VMAX(vec, mask, acc, x) ((acc) = (vec)(((mask)(x) & (mask)((x) > (acc))) | ((mask)(acc) & ~(mask)((x) > (acc)))))
+
+/** @brief Defines the kernel core_aggregate_<op><NAME><WIDTH>, over vectors of BYTES bytes.
+ *
+ * COMBINE names the CORE_AGGREGATE_<COMBINE> and CORE_AGGREGATE_V<COMBINE> macros which fold an element, or vector, into the result.
+ * T is the element type, and I the signed integer type of the same size, used for lane masks.
+ */
+#define CORE_AGGREGATE_KERNEL(op, COMBINE, NAME, T, I, IDENTITY, WIDTH, BYTES, TARGET) \
+TARGET static T core_aggregate_##op##NAME##WIDTH(T* field, unsigned int* useField, int numRows) \
+{ \
+    typedef T vec __attribute__((vector_size(BYTES), aligned(sizeof(T)))); \
+    typedef I mask __attribute__((vector_size(BYTES))); \
+    enum { LANES = BYTES/sizeof(T) }; \
+    mask laneBits; \
+    vec identity; \
+    for(int i = 0; i < LANES; i++) \
+    { \
+        laneBits[i] = (I)1 << i; \
+        identity[i] = IDENTITY; \
+    } \
+    vec acc = identity; \
+    T result = IDENTITY; \
+    int any = 0; \
+    for(int w = 0; w < (numRows + 31) >> 5; w++) \
+    { \
+        unsigned int word = useField[w]; \
+        if(!word) continue; \
+        any = 1; \
+        int base = w << 5; \
+        if(base + 32 <= numRows) \
+        { \
+            for(int j = 0; j < 32; j += LANES) \
+            { \
+                mask used = (mask)((laneBits & (I)(word >> j)) == laneBits); \
+                vec x = (vec)(((mask)*(vec*)(field + base + j) & used) | ((mask)identity & ~used)); \
+                CORE_AGGREGATE_V##COMBINE(vec, mask, acc, x); \
+            } \
+        } \
+        else \
+        { \
+            for(int row = base; row < numRows; row++) \
+            { \
+                if((word >> (row & 31)) & 1) CORE_AGGREGATE_##COMBINE(result, field[row]); \
+            } \
+        } \
+    } \
+    for(int i = 0; i < LANES; i++) CORE_AGGREGATE_##COMBINE(result, acc[i]); \
+    return any ? result : 0; \
+}
+
+/** @brief Defines the kernel core_aggregate_mean<NAME><WIDTH>, over vectors of BYTES bytes.
+ *
+ * The elements, of type T, are summed as W, with each vector of them converted to a vector of W before it is added.
+ * I is the signed integer type of the same size as T, used for lane masks.
+ */
+#define CORE_AGGREGATE_MEAN_KERNEL(NAME, T, I, W, WIDTH, BYTES, TARGET) \
+TARGET static double core_aggregate_mean##NAME##WIDTH(T* field, unsigned int* useField, int numRows) \
+{ \
+    typedef T vec __attribute__((vector_size(BYTES), aligned(sizeof(T)))); \
+    typedef I mask __attribute__((vector_size(BYTES))); \
+    enum { LANES = BYTES/sizeof(T) }; \
+    typedef W wide __attribute__((vector_size(LANES*sizeof(W)))); \
+    mask laneBits; \
+    for(int i = 0; i < LANES; i++) laneBits[i] = (I)1 << i; \
+    wide acc = {0}; \
+    W result = 0; \
+    long long count = 0; \
+    for(int w = 0; w < (numRows + 31) >> 5; w++) \
+    { \
+        unsigned int word = useField[w]; \
+        if(!word) continue; \
+        count += __builtin_popcount(word); \
+        int base = w << 5; \
+        if(base + 32 <= numRows) \
+        { \
+            for(int j = 0; j < 32; j += LANES) \
+            { \
+                mask used = (mask)((laneBits & (I)(word >> j)) == laneBits); \
+                vec x = (vec)((mask)*(vec*)(field + base + j) & used); \
+                acc += __builtin_convertvector(x, wide); \
+            } \
+        } \
+        else \
+        { \
+            for(int row = base; row < numRows; row++) \
+            { \
+                if((word >> (row & 31)) & 1) result += field[row]; \
+            } \
+        } \
+    } \
+    for(int i = 0; i < LANES; i++) result += acc[i]; \
+    return count ? (double)result/count : 0.0; \
+}
+
+#ifdef CORE_SIMD_X86
+/** @brief Defines core_aggregate_<op><NAME>, choosing between the 128-bit and AVX2 kernels.
+ */
+#define CORE_AGGREGATE(op, COMBINE, NAME, T, I, IDENTITY) \
+CORE_AGGREGATE_KERNEL(op, COMBINE, NAME, T, I, IDENTITY, 128, 16, ) \
+CORE_AGGREGATE_KERNEL(op, COMBINE, NAME, T, I, IDENTITY, 256, 32, __attribute__((target("avx2")))) \
+T core_aggregate_##op##NAME(T* field, unsigned int* useField, int numRows) \
+{ \
+    if(core_simd_getLevel() >= CORE_SIMD_AVX2) return core_aggregate_##op##NAME##256(field, useField, numRows); \
+    return core_aggregate_##op##NAME##128(field, useField, numRows); \
+}
+#else
+#define CORE_AGGREGATE(op, COMBINE, NAME, T, I, IDENTITY) \
+CORE_AGGREGATE_KERNEL(op, COMBINE, NAME, T, I, IDENTITY, 128, 16, ) \
+T core_aggregate_##op##NAME(T* field, unsigned int* useField, int numRows) \
+{ \
+    return core_aggregate_##op##NAME##128(field, useField, numRows); \
+}
+#endif
+
+#ifdef CORE_SIMD_X86
+/** @brief Defines core_aggregate_mean<NAME>, choosing between the 128-bit and AVX2 kernels.
+ */
+#define CORE_AGGREGATE_MEAN(NAME, T, I, W) \
+CORE_AGGREGATE_MEAN_KERNEL(NAME, T, I, W, 128, 16, ) \
+CORE_AGGREGATE_MEAN_KERNEL(NAME, T, I, W, 256, 32, __attribute__((target("avx2")))) \
+double core_aggregate_mean##NAME(T* field, unsigned int* useField, int numRows) \
+{ \
+    if(core_simd_getLevel() >= CORE_SIMD_AVX2) return core_aggregate_mean##NAME##256(field, useField, numRows); \
+    return core_aggregate_mean##NAME##128(field, useField, numRows); \
+}
+#else
+#define CORE_AGGREGATE_MEAN(NAME, T, I, W) \
+CORE_AGGREGATE_MEAN_KERNEL(NAME, T, I, W, 128, 16, ) \
+double core_aggregate_mean##NAME(T* field, unsigned int* useField, int numRows) \
+{ \
+    return core_aggregate_mean##NAME##128(field, useField, numRows); \
+}
+#endif
+
+CORE_AGGREGATE(sum, SUM, Int, int, int, 0)
+CORE_AGGREGATE(min, MIN, Int, int, int, INT_MAX)
+CORE_AGGREGATE(max, MAX, Int, int, int, INT_MIN)
+
+CORE_AGGREGATE(sum, SUM, Long, long long, long long, 0)
+CORE_AGGREGATE(min, MIN, Long, long long, long long, LLONG_MAX)
+CORE_AGGREGATE(max, MAX, Long, long long, long long, LLONG_MIN)
+
+CORE_AGGREGATE(sum, SUM, Short, short, short, 0)
+CORE_AGGREGATE(min, MIN, Short, short, short, SHRT_MAX)
+CORE_AGGREGATE(max, MAX, Short, short, short, SHRT_MIN)
+
+CORE_AGGREGATE(sum, SUM, Float, float, int, 0)
+CORE_AGGREGATE(min, MIN, Float, float, int, __builtin_inff())
+CORE_AGGREGATE(max, MAX, Float, float, int, -__builtin_inff())
+
+CORE_AGGREGATE(sum, SUM, Double, double, long long, 0)
+CORE_AGGREGATE(min, MIN, Double, double, long long, __builtin_inf())
+CORE_AGGREGATE(max, MAX, Double, double, long long, -__builtin_inf())
+
+CORE_AGGREGATE(sum, SUM, Size, size_t, ptrdiff_t, 0)
+CORE_AGGREGATE(min, MIN, Size, size_t, ptrdiff_t, SIZE_MAX)
+CORE_AGGREGATE(max, MAX, Size, size_t, ptrdiff_t, 0)
+
+CORE_AGGREGATE_MEAN(Int, int, int, long long)
+CORE_AGGREGATE_MEAN(Long, long long, long long, long long)
+CORE_AGGREGATE_MEAN(Short, short, short, long long)
+CORE_AGGREGATE_MEAN(Float, float, int, double)
+CORE_AGGREGATE_MEAN(Double, double, long long, double)
+CORE_AGGREGATE_MEAN(Size, size_t, ptrdiff_t, size_t)
@@ -0,0 +1,281 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+/* The heap of the raw (libc-free) runtime, which gets its memory from the system through tabi_core_raw.asm.
+ *
+ * Small allocations are rounded up to one of a few size classes, and served from slabs: CORE_ALLOC_SLAB bytes,
+ * aligned to their size, holding a header followed by objects of a single class. Slabs are carved from chunks
+ * mapped CORE_ALLOC_CHUNK bytes at a time, so a small allocation rarely costs a system call. Each slab hands out
+ * objects from its free list, and otherwise from the part of it never handed out. The slabs of each class
+ * with free objects are kept in a list, and a slab which becomes empty is kept for any class to reuse.
+ *
+ * Freed objects go first to a cache per class (as in a thread cache), from which allocations of that class
+ * are taken without touching any slab. Once a cache holds CORE_ALLOC_CACHE_BYTES, half of it is given back to
+ * the slabs. Programs built with the raw runtime are single threaded, and have no thread local storage
+ * (tabi_start.asm does not set any up), so there is just the one cache.
+ *
+ * Larger allocations are mapped on their own, with the same header, so that core_dealloc can tell them apart.
+ * Memory from core_alloc_aligned is aligned to CORE_ALIGNMENT, as it is in tabi_core_cross.
+ */
+
+#include"tabi_core_stats.h"
+
+void* core_sys_mmap(long long length);
+int   core_sys_munmap(void* addr, long long length);
+int   core_sys_madvise(void* addr, long long length, int advice);
+long long core_sys_write(int fd, void* buf, long long length);
+
+#define CORE_ALIGNMENT 64                   ///< The alignment of memory from core_alloc_aligned.
+#define CORE_HUGE_PAGE_THRESHOLD (2LL << 20) ///< Large allocations of at least this many bytes are backed by huge pages.
+#define CORE_MADV_HUGEPAGE 14
+
+#define CORE_ALLOC_PAGE 4096LL
+#define CORE_ALLOC_SLAB (64LL << 10)        ///< The size (and alignment) of a slab, and the alignment of a large allocation.
+#define CORE_ALLOC_CHUNK (2LL << 20)        ///< The size of the mappings from which slabs are carved.
+#define CORE_ALLOC_HEADER 64                ///< The bytes taken by the header of a slab or large allocation.
+#define CORE_ALLOC_CACHE_BYTES (256LL << 10) ///< The most memory held by the cache of one size class.
+
+#define CORE_ALLOC_NUM_CLASSES 17
+#define CORE_ALLOC_MAX_SMALL 8192
+
+/** @brief The object sizes of the size classes.
+ *
+ * From 64 on, each is a multiple of CORE_ALIGNMENT, so that the objects of those classes are all aligned.
+ */
+static const int core_alloc_classSizes[CORE_ALLOC_NUM_CLASSES] = {
+    16, 32, 48, 64, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192
+};
+
+/** @brief The header at the start of each slab, and of each large allocation.
+ */
+typedef struct core_alloc_slab
+{
+    long long length;               ///< The length of the mapping of a large allocation, or 0 for a slab.
+    struct core_alloc_slab* next;   ///< The next slab in its list (of slabs with free objects, or of empty slabs).
+    struct core_alloc_slab* prev;   ///< The previous slab with free objects of the same class.
+    void* freeList;                 ///< Objects given back to this slab, linked through their first word.
+    char* uncarved;                 ///< The first object never handed out.
+    int sizeClass;
+    int numUsed;                    ///< The number of objects handed out, including those in the cache.
+    int isPartial;                  ///< Whether the slab is in the list of its class's slabs with free objects.
+} core_alloc_slab;
+
+typedef struct core_alloc_cache
+{
+    void* head;                     ///< Freed objects, linked through their first word.
+    int count;
+} core_alloc_cache;
+
+static core_alloc_cache core_alloc_caches[CORE_ALLOC_NUM_CLASSES];
+static core_alloc_slab* core_alloc_partial[CORE_ALLOC_NUM_CLASSES];
+static core_alloc_slab* core_alloc_emptySlabs;
+static char* core_alloc_chunkNext;
+static char* core_alloc_chunkEnd;
+
+static core_alloc_slab* core_alloc_slabOf(void* ptr)
+{
+    return (core_alloc_slab*)((unsigned long long)ptr & ~(CORE_ALLOC_SLAB - 1));
+}
+
+/** @brief Maps \p length bytes (a whole number of pages), aligned to CORE_ALLOC_SLAB. Returns 0 on failure.
+ */
+static char* core_alloc_map(long long length)
+{
+    long long slack = CORE_ALLOC_SLAB - CORE_ALLOC_PAGE;
+    char* mapped = core_sys_mmap(length + slack);
+    //The system call returns -errno on failure.
+    if((unsigned long long)mapped > -4096ULL) return 0;
+    char* base = (char*)core_alloc_slabOf(mapped + CORE_ALLOC_SLAB - 1);
+    if(base > mapped) core_sys_munmap(mapped, base - mapped);
+    if(base + length < mapped + length + slack) core_sys_munmap(base + length, mapped + slack - base);
+    return base;
+}
+
+/** @brief Returns the smallest size class whose objects are at least \p numBytes.
+ */
+static int core_alloc_class(long long numBytes)
+{
+    if(numBytes <= 64) return numBytes <= 16 ? 0 : (int)((numBytes - 1) >> 4);
+    int sizeClass = 4;
+    while(core_alloc_classSizes[sizeClass] < numBytes) sizeClass++;
+    return sizeClass;
+}
+
+static void core_alloc_linkPartial(core_alloc_slab* slab)
+{
+    core_alloc_slab** head = &core_alloc_partial[slab->sizeClass];
+    slab->prev = 0;
+    slab->next = *head;
+    if(*head) (*head)->prev = slab;
+    *head = slab;
+    slab->isPartial = 1;
+}
+
+static void core_alloc_unlinkPartial(core_alloc_slab* slab)
+{
+    if(slab->prev) slab->prev->next = slab->next;
+    else core_alloc_partial[slab->sizeClass] = slab->next;
+    if(slab->next) slab->next->prev = slab->prev;
+    slab->isPartial = 0;
+}
+
+/** @brief Sets up a slab for \p sizeClass, reusing an empty slab if there is one, and adds it to the class's list.
+ */
+static core_alloc_slab* core_alloc_newSlab(int sizeClass)
+{
+    core_alloc_slab* slab = core_alloc_emptySlabs;
+    if(slab) core_alloc_emptySlabs = slab->next;
+    else
+    {
+        if(core_alloc_chunkNext == core_alloc_chunkEnd)
+        {
+            char* chunk = core_alloc_map(CORE_ALLOC_CHUNK);
+            if(!chunk) return 0;
+            core_alloc_chunkNext = chunk;
+            core_alloc_chunkEnd = chunk + CORE_ALLOC_CHUNK;
+        }
+        slab = (core_alloc_slab*)core_alloc_chunkNext;
+        core_alloc_chunkNext += CORE_ALLOC_SLAB;
+    }
+    slab->length = 0;
+    slab->freeList = 0;
+    slab->uncarved = (char*)slab + CORE_ALLOC_HEADER;
+    slab->sizeClass = sizeClass;
+    slab->numUsed = 0;
+    core_alloc_linkPartial(slab);
+    return slab;
+}
+
+static void* core_alloc_small(int sizeClass)
+{
+    core_alloc_cache* cache = &core_alloc_caches[sizeClass];
+    if(cache->count)
+    {
+        void* obj = cache->head;
+        cache->head = *(void**)obj;
+        cache->count--;
+        return obj;
+    }
+    core_alloc_slab* slab = core_alloc_partial[sizeClass];
+    if(!slab) slab = core_alloc_newSlab(sizeClass);
+    if(!slab) return 0;
+    int size = core_alloc_classSizes[sizeClass];
+    void* obj;
+    if(slab->freeList)
+    {
+        obj = slab->freeList;
+        slab->freeList = *(void**)obj;
+    }
+    else
+    {
+        obj = slab->uncarved;
+        slab->uncarved += size;
+    }
+    slab->numUsed++;
+    if(!slab->freeList && slab->uncarved + size > (char*)slab + CORE_ALLOC_SLAB) core_alloc_unlinkPartial(slab);
+    return obj;
+}
+
+/** @brief Gives an object back to its slab, and the slab back for reuse if it is then empty.
+ *
+ * The first slab of each class's list is kept, so that a class which repeatedly takes and gives back
+ * a single slab's worth of objects does not move the slab back and forth.
+ */
+static void core_alloc_release(void* obj)
+{
+    core_alloc_slab* slab = core_alloc_slabOf(obj);
+    *(void**)obj = slab->freeList;
+    slab->freeList = obj;
+    slab->numUsed--;
+    if(!slab->isPartial) core_alloc_linkPartial(slab);
+    if(slab->numUsed == 0 && (slab->prev || slab->next))
+    {
+        core_alloc_unlinkPartial(slab);
+        slab->next = core_alloc_emptySlabs;
+        core_alloc_emptySlabs = slab;
+    }
+}
+
+static void* core_alloc_large(long long numBytes)
+{
+    long long length = (CORE_ALLOC_HEADER + numBytes + CORE_ALLOC_PAGE - 1) & ~(CORE_ALLOC_PAGE - 1);
+    char* base = core_alloc_map(length);
+    if(!base) return 0;
+    if(length >= CORE_HUGE_PAGE_THRESHOLD) core_sys_madvise(base, length, CORE_MADV_HUGEPAGE);
+    ((core_alloc_slab*)base)->length = length;
+    return base + CORE_ALLOC_HEADER;
+}
+
+/** @brief Allocates memory on the heap.
+ *
+ * @param numBytes The size (in bytes) of the memory to be allocated.
+ */
+void* core_alloc(long long numBytes)
+{
+    void* ptr = numBytes <= CORE_ALLOC_MAX_SMALL ? core_alloc_small(core_alloc_class(numBytes)) : core_alloc_large(numBytes);
+    if(core_stats_enabled) core_stats_alloc(ptr, numBytes, CORE_RETURN_ADDRESS);
+    return ptr;
+}
+
+/** @brief Allocates memory on the heap, aligned to CORE_ALIGNMENT bytes.
+ *
+ * Small allocations come from the size classes whose objects are all aligned,
+ * and large ones are aligned by their header.
+ */
+void* core_alloc_aligned(long long numBytes)
+{
+    void* ptr = numBytes <= CORE_ALLOC_MAX_SMALL ? core_alloc_small(core_alloc_class(numBytes < CORE_ALIGNMENT ? CORE_ALIGNMENT : numBytes)) : core_alloc_large(numBytes);
+    if(core_stats_enabled) core_stats_alloc(ptr, numBytes, CORE_RETURN_ADDRESS);
+    return ptr;
+}
+
+/** @brief Frees memory from the heap, whether from core_alloc or core_alloc_aligned.
+ */
+void core_dealloc(void* ptr)
+{
+    if(!ptr) return;
+    if(core_stats_enabled) core_stats_dealloc(ptr);
+    core_alloc_slab* slab = core_alloc_slabOf(ptr);
+    if(slab->length)
+    {
+        core_sys_munmap(slab, slab->length);
+        return;
+    }
+    int sizeClass = slab->sizeClass;
+    core_alloc_cache* cache = &core_alloc_caches[sizeClass];
+    *(void**)ptr = cache->head;
+    cache->head = ptr;
+    cache->count++;
+    if(cache->count*(long long)core_alloc_classSizes[sizeClass] < CORE_ALLOC_CACHE_BYTES) return;
+    for(int i = cache->count/2; i > 0; i--)
+    {
+        void* obj = cache->head;
+        cache->head = *(void**)obj;
+        core_alloc_release(obj);
+    }
+    cache->count -= cache->count/2;
+}
+
+/** @brief Writes part of the allocation report (see tabi_core_stats.c) to standard error.
+ */
+void core_stats_write(char* str, long long length)
+{
+    while(length > 0)
+    {
+        long long written = core_sys_write(2, str, length);
+        if(written <= 0) return;
+        str += written;
+        length -= written;
+    }
+}
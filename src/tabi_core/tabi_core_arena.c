@@ -0,0 +1,117 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+void* core_alloc_aligned(long long numBytes);
+void  core_dealloc(void* ptr);
+
+/* Arenas, into which `heaped in arena A` allocates, and which `unheap arena A` frees all at once.
+ *
+ * An `Arena` variable holds a pointer to its arena, or 0 before the first allocation into it (or after it is
+ * released). The arena lives at the start of its first chunk, so it does not move as the arena grows, and
+ * copies of the variable made after the first allocation share it. Allocations are bumped from the current
+ * chunk. Once it is full, a new chunk is taken, twice the size of the last up to CORE_ARENA_MAX_CHUNK, and the
+ * rest of the old one is left unused. An allocation too large to fit a chunk well is given a chunk of its own,
+ * leaving the current one in place.
+ *
+ * Chunks come from core_alloc_aligned, so that the memory of each starts on a cache line.
+ */
+
+#define CORE_ARENA_HEADER 64                ///< The bytes taken by the header of a chunk (the arena itself, in the first).
+#define CORE_ARENA_FIRST_CHUNK (16LL << 10) ///< The size of the first chunk of an arena.
+#define CORE_ARENA_MAX_CHUNK (1LL << 20)    ///< The most the chunk size grows to. Larger allocations get a chunk of their own.
+
+/** @brief The header of each chunk after the first.
+ */
+typedef struct core_arena_chunk
+{
+    struct core_arena_chunk* next;      ///< The chunk taken before this one, or 0.
+} core_arena_chunk;
+
+/** @brief The header of the first chunk of an arena.
+ */
+typedef struct core_arena
+{
+    core_arena_chunk* chunks;           ///< The other chunks of the arena, latest first.
+    char* next;                         ///< The first free byte of the current chunk.
+    char* end;                          ///< The end of the current chunk.
+    long long chunkSize;                ///< The size of the current chunk.
+} core_arena;
+
+static char* core_arena_align(char* ptr, long long alignment)
+{
+    return (char*)(((unsigned long long)ptr + alignment - 1) & ~(unsigned long long)(alignment - 1));
+}
+
+/** @brief Takes a new chunk of \p chunkSize bytes into \p arena, returning it (past its header), or 0 on failure.
+ */
+static char* core_arena_newChunk(core_arena* arena, long long chunkSize)
+{
+    core_arena_chunk* chunk = core_alloc_aligned(chunkSize);
+    if(!chunk) return 0;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    return (char*)chunk + CORE_ARENA_HEADER;
+}
+
+/** @brief Allocates memory from an arena, creating the arena if there is none yet.
+ *
+ * @param handle The `Arena` variable, which holds the arena, or 0.
+ * @param numBytes The size (in bytes) of the memory to be allocated.
+ * @param alignment The alignment of the memory, a power of two of at most CORE_ARENA_HEADER.
+ */
+void* core_arena_alloc(void** handle, long long numBytes, long long alignment)
+{
+    core_arena* arena = *handle;
+    if(!arena)
+    {
+        arena = core_alloc_aligned(CORE_ARENA_FIRST_CHUNK);
+        if(!arena) return 0;
+        arena->chunks = 0;
+        arena->next = (char*)arena + CORE_ARENA_HEADER;
+        arena->end = (char*)arena + CORE_ARENA_FIRST_CHUNK;
+        arena->chunkSize = CORE_ARENA_FIRST_CHUNK;
+        *handle = arena;
+    }
+    char* ptr = core_arena_align(arena->next, alignment);
+    if(numBytes <= arena->end - ptr)
+    {
+        arena->next = ptr + numBytes;
+        return ptr;
+    }
+    if(numBytes > (CORE_ARENA_MAX_CHUNK - CORE_ARENA_HEADER)/4) return core_arena_newChunk(arena, CORE_ARENA_HEADER + numBytes);
+    long long chunkSize = arena->chunkSize < CORE_ARENA_MAX_CHUNK ? 2*arena->chunkSize : CORE_ARENA_MAX_CHUNK;
+    ptr = core_arena_newChunk(arena, chunkSize);
+    if(!ptr) return 0;
+    arena->chunkSize = chunkSize;
+    arena->next = ptr + numBytes;
+    arena->end = ptr - CORE_ARENA_HEADER + chunkSize;
+    return ptr;
+}
+
+/** @brief Frees everything allocated from an arena, and the arena itself, leaving \p handle 0.
+ */
+void core_arena_release(void** handle)
+{
+    core_arena* arena = *handle;
+    if(!arena) return;
+    core_arena_chunk* chunk = arena->chunks;
+    while(chunk)
+    {
+        core_arena_chunk* next = chunk->next;
+        core_dealloc(chunk);
+        chunk = next;
+    }
+    core_dealloc(arena);
+    *handle = 0;
+}
@@ -0,0 +1,547 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+#include"tabi_core_table.h"
+
+void* core_alloc(long long numBytes);
+void  core_dealloc(void* ptr);
+
+/* Ordered indexes over a single field of a table, used for the fields declared `ordered`.
+ *
+ * An index is a B+-tree whose nodes all live in one block, laid out as,
+ *
+ *     header | nodes[capacity]
+ *
+ * so that nodes refer to each other by position, and the block can be moved when a growable table grows.
+ * Each entry is a (key, row) pair, ordered by key and then by row, so that equal keys are kept in row order
+ * and every entry can be found exactly. Keys are copied into the nodes, in a form which orders as unsigned
+ * numbers (see core_btree_order), so that searching never touches the table.
+ * Leaves are linked in order, for iteration.
+ *
+ * A leaf which becomes empty is freed, rather than being merged with its neighbours.
+ * When an insert finds too few free nodes left, the whole tree is rebuilt (packed) from the table.
+ *
+ * Every change to the tree increases its version, which lets a cursor notice that the tree changed
+ * under it (e.g. rows deleted while iterating) and find its place again by key.
+ */
+
+#define CORE_BTREE_ORDER 14         ///< The most entries (or separators) a node holds.
+#define CORE_BTREE_FILL 12          ///< The entries given to each leaf (and children to each inner node) by a rebuild.
+#define CORE_BTREE_MAX_HEIGHT 32
+
+#define CORE_BTREE_NONE -1
+
+typedef struct
+{
+    int numKeys;
+    int leaf;
+    int prev;                                       ///< The previous leaf, or CORE_BTREE_NONE. For free nodes, unused.
+    int next;                                       ///< The next leaf, or CORE_BTREE_NONE. For free nodes, the next free node.
+    unsigned long long keys[CORE_BTREE_ORDER];
+    int rows[CORE_BTREE_ORDER];
+    int children[CORE_BTREE_ORDER + 1];             ///< For inner nodes, children[i] holds the entries below keys[i] (and at least keys[i - 1]).
+} core_btree_node;
+
+typedef struct
+{
+    int capacity;                                   ///< The number of nodes.
+    int root;
+    int height;                                     ///< The number of levels, with 1 meaning that the root is a leaf.
+    int freeNode;                                   ///< The first free node, or CORE_BTREE_NONE.
+    int numFree;
+    int keySize;
+    int floating;                                   ///< Whether the keys are floating point numbers, rather than integers.
+    unsigned int version;
+} core_btree_header;
+
+/** @brief Where a range iteration has got to. The compiler only knows its size (TableScan::CURSOR_SIZE Long, in tabic).
+ */
+typedef struct
+{
+    unsigned long long key;                         ///< The key of the entry last visited.
+    int row;                                        ///< The row of the entry last visited, or -1 before the first.
+    int node;                                       ///< The leaf holding the next entry.
+    int slot;                                       ///< The position of the next entry in node.
+    unsigned int version;                           ///< The version of the tree for which node and slot are correct.
+} core_btree_cursor;
+
+typedef struct
+{
+    unsigned long long key;
+    int row;
+    int node;
+} core_btree_entry;
+
+#define CORE_BTREE_NODES(header) ((core_btree_node*)((header) + 1))
+
+static int core_btree_capacity(int numRows)
+{
+    return 4*(numRows/CORE_BTREE_FILL + 1) + 2*CORE_BTREE_MAX_HEIGHT;
+}
+
+/** @brief Maps the bits of a key to a number whose unsigned order is the order of the key.
+ *
+ * Integers are signed (as they are compared in Tabitha), so flipping the sign bit is enough.
+ * Negative floating point numbers have all their bits flipped, so that larger magnitudes come first.
+ */
+static unsigned long long core_btree_order(core_btree_header* header, unsigned long long bits)
+{
+    int numBits = 8*header->keySize;
+    unsigned long long sign = 1ull << (numBits - 1);
+    unsigned long long mask = sign | (sign - 1);
+    bits &= mask;
+    if(!header->floating) return bits ^ sign;
+    return (bits & sign) ? ~bits & mask : bits | sign;
+}
+
+static unsigned long long core_btree_key(core_btree_header* header, void* field, int row)
+{
+    return core_btree_order(header, core_table_readKey(field, header->keySize, row));
+}
+
+static int core_btree_less(unsigned long long key1, int row1, unsigned long long key2, int row2)
+{
+    return key1 < key2 || (key1 == key2 && row1 < row2);
+}
+
+static int core_btree_allocNode(core_btree_header* header, int leaf)
+{
+    core_btree_node* nodes = CORE_BTREE_NODES(header);
+    int node = header->freeNode;
+    header->freeNode = nodes[node].next;
+    header->numFree--;
+    nodes[node].numKeys = 0;
+    nodes[node].leaf = leaf;
+    nodes[node].prev = CORE_BTREE_NONE;
+    nodes[node].next = CORE_BTREE_NONE;
+    return node;
+}
+
+static void core_btree_freeNode(core_btree_header* header, int node)
+{
+    CORE_BTREE_NODES(header)[node].next = header->freeNode;
+    header->freeNode = node;
+    header->numFree++;
+}
+
+/** @brief Empties the tree, leaving every node free but the root, which is an empty leaf.
+ */
+static void core_btree_clear(core_btree_header* header)
+{
+    core_btree_node* nodes = CORE_BTREE_NODES(header);
+    for(int i = 0; i < header->capacity; i++) nodes[i].next = i + 1 < header->capacity ? i + 1 : CORE_BTREE_NONE;
+    header->freeNode = 0;
+    header->numFree = header->capacity;
+    header->root = core_btree_allocNode(header, 1);
+    header->height = 1;
+    header->version++;
+}
+
+/** @brief Returns the child of the inner node \p node which holds (or would hold) the entry (key, row).
+ */
+static int core_btree_childSlot(core_btree_node* node, unsigned long long key, int row)
+{
+    int slot = 0;
+    while(slot < node->numKeys && !core_btree_less(key, row, node->keys[slot], node->rows[slot])) slot++;
+    return slot;
+}
+
+/** @brief Finds the leaf and slot of the first entry after (key, row).
+ *
+ * The slot may be one past the end of the leaf, in which case the entry (if any) starts the next leaf.
+ */
+static void core_btree_locate(core_btree_header* header, unsigned long long key, int row, int* leaf, int* slot)
+{
+    core_btree_node* nodes = CORE_BTREE_NODES(header);
+    int node = header->root;
+    while(!nodes[node].leaf) node = nodes[node].children[core_btree_childSlot(&nodes[node], key, row)];
+    int i = 0;
+    while(i < nodes[node].numKeys && !core_btree_less(key, row, nodes[node].keys[i], nodes[node].rows[i])) i++;
+    *leaf = node;
+    *slot = i;
+}
+
+/** @brief Puts the entry (key, row) into the tree, splitting nodes as needed. There must be a free node per level, and one more.
+ */
+static void core_btree_place(core_btree_header* header, unsigned long long key, int row)
+{
+    core_btree_node* nodes = CORE_BTREE_NODES(header);
+    int path[CORE_BTREE_MAX_HEIGHT];
+    int depth = 0;
+    int node = header->root;
+    while(!nodes[node].leaf)
+    {
+        path[depth++] = node;
+        node = nodes[node].children[core_btree_childSlot(&nodes[node], key, row)];
+    }
+    //Insert into the leaf, splitting it in two if it is full.
+    unsigned long long keys[CORE_BTREE_ORDER + 1];
+    int rows[CORE_BTREE_ORDER + 1];
+    int children[CORE_BTREE_ORDER + 2];
+    core_btree_node* leaf = &nodes[node];
+    int n = leaf->numKeys;
+    int slot = 0;
+    while(slot < n && core_btree_less(leaf->keys[slot], leaf->rows[slot], key, row)) slot++;
+    for(int i = 0, j = 0; i <= n; i++)
+    {
+        if(i == slot) { keys[i] = key; rows[i] = row; continue; }
+        keys[i] = leaf->keys[j];
+        rows[i] = leaf->rows[j];
+        j++;
+    }
+    if(n < CORE_BTREE_ORDER)
+    {
+        for(int i = 0; i <= n; i++) { leaf->keys[i] = keys[i]; leaf->rows[i] = rows[i]; }
+        leaf->numKeys = n + 1;
+        return;
+    }
+    int right = core_btree_allocNode(header, 1);
+    int half = (CORE_BTREE_ORDER + 1)/2;
+    for(int i = 0; i < half; i++) { nodes[node].keys[i] = keys[i]; nodes[node].rows[i] = rows[i]; }
+    for(int i = half; i <= CORE_BTREE_ORDER; i++) { nodes[right].keys[i - half] = keys[i]; nodes[right].rows[i - half] = rows[i]; }
+    nodes[node].numKeys = half;
+    nodes[right].numKeys = CORE_BTREE_ORDER + 1 - half;
+    nodes[right].prev = node;
+    nodes[right].next = nodes[node].next;
+    if(nodes[node].next != CORE_BTREE_NONE) nodes[nodes[node].next].prev = right;
+    nodes[node].next = right;
+    //The first entry of the new leaf separates it from the old one.
+    unsigned long long sepKey = nodes[right].keys[0];
+    int sepRow = nodes[right].rows[0];
+    int newChild = right;
+    while(depth > 0)
+    {
+        node = path[--depth];
+        core_btree_node* inner = &nodes[node];
+        n = inner->numKeys;
+        slot = core_btree_childSlot(inner, sepKey, sepRow);
+        for(int i = 0, j = 0; i <= n; i++)
+        {
+            if(i == slot) { keys[i] = sepKey; rows[i] = sepRow; continue; }
+            keys[i] = inner->keys[j];
+            rows[i] = inner->rows[j];
+            j++;
+        }
+        for(int i = 0, j = 0; i <= n + 1; i++)
+        {
+            if(i == slot + 1) { children[i] = newChild; continue; }
+            children[i] = inner->children[j++];
+        }
+        if(n < CORE_BTREE_ORDER)
+        {
+            for(int i = 0; i <= n; i++) { inner->keys[i] = keys[i]; inner->rows[i] = rows[i]; }
+            for(int i = 0; i <= n + 1; i++) inner->children[i] = children[i];
+            inner->numKeys = n + 1;
+            return;
+        }
+        //The middle separator moves up, rather than being kept in either half.
+        right = core_btree_allocNode(header, 0);
+        for(int i = 0; i < half; i++) { nodes[node].keys[i] = keys[i]; nodes[node].rows[i] = rows[i]; }
+        for(int i = 0; i <= half; i++) nodes[node].children[i] = children[i];
+        for(int i = half + 1; i <= CORE_BTREE_ORDER; i++) { nodes[right].keys[i - half - 1] = keys[i]; nodes[right].rows[i - half - 1] = rows[i]; }
+        for(int i = half + 1; i <= CORE_BTREE_ORDER + 1; i++) nodes[right].children[i - half - 1] = children[i];
+        nodes[node].numKeys = half;
+        nodes[right].numKeys = CORE_BTREE_ORDER - half;
+        sepKey = keys[half];
+        sepRow = rows[half];
+        newChild = right;
+    }
+    //The root itself was split.
+    int root = core_btree_allocNode(header, 0);
+    nodes[root].numKeys = 1;
+    nodes[root].keys[0] = sepKey;
+    nodes[root].rows[0] = sepRow;
+    nodes[root].children[0] = header->root;
+    nodes[root].children[1] = newChild;
+    header->root = root;
+    header->height++;
+}
+
+/** @brief Sorts entries by (key, row), using heapsort so that no more memory is needed.
+ */
+static void core_btree_sort(core_btree_entry* entries, int numEntries)
+{
+    for(int end = numEntries, start = numEntries/2; end > 1;)
+    {
+        if(start > 0) start--;
+        else
+        {
+            end--;
+            core_btree_entry top = entries[0];
+            entries[0] = entries[end];
+            entries[end] = top;
+        }
+        //Sift entries[start] down within entries[0, end).
+        int parent = start;
+        for(int child = 2*parent + 1; child < end; child = 2*parent + 1)
+        {
+            if(child + 1 < end && core_btree_less(entries[child].key, entries[child].row, entries[child + 1].key, entries[child + 1].row)) child++;
+            if(!core_btree_less(entries[parent].key, entries[parent].row, entries[child].key, entries[child].row)) break;
+            core_btree_entry swap = entries[parent];
+            entries[parent] = entries[child];
+            entries[child] = swap;
+            parent = child;
+        }
+    }
+}
+
+/** @brief Returns the number of bytes needed for the index of a table with \p numRows rows.
+ */
+long long core_btree_getSize(int numRows)
+{
+    return sizeof(core_btree_header) + sizeof(core_btree_node)*core_btree_capacity(numRows);
+}
+
+/** @brief Sets up an empty index for a table with \p numRows rows.
+ *
+ * @param keySize The size of the field's elements, which is at most 8.
+ * @param floating Whether the field holds Float or Double, rather than integers.
+ */
+void core_btree_init(void* tree, int numRows, int keySize, int floating)
+{
+    core_btree_header* header = tree;
+    header->capacity = core_btree_capacity(numRows);
+    header->keySize = keySize;
+    header->floating = floating;
+    header->version = 0;
+    core_btree_clear(header);
+}
+
+/** @brief Empties the index, then builds it afresh from every used row, with its leaves mostly full.
+ */
+void core_btree_rebuild(void* tree, void* field, unsigned int* useField, int numRows)
+{
+    core_btree_header* header = tree;
+    core_btree_node* nodes = CORE_BTREE_NODES(header);
+    core_btree_clear(header);
+    int numEntries = 0;
+    for(int w = 0; w < (numRows + 31) >> 5; w++) numEntries += __builtin_popcount(useField[w]);
+    if(!numEntries) return;
+    core_btree_entry* entries = core_alloc(sizeof(core_btree_entry)*(long long)numEntries);
+    for(int w = 0, i = 0; w < (numRows + 31) >> 5; w++)
+    {
+        for(unsigned int word = useField[w]; word; word &= word - 1)
+        {
+            int row = (w << 5) + __builtin_ctz(word);
+            entries[i].key = core_btree_key(header, field, row);
+            entries[i].row = row;
+            i++;
+        }
+    }
+    core_btree_sort(entries, numEntries);
+    //Fill the leaves in order. Each is then described by its first entry (and the node),
+    //which is written over the front of entries, behind the entries still to be read.
+    core_btree_freeNode(header, header->root);
+    int numLevel = 0;
+    int prev = CORE_BTREE_NONE;
+    for(int start = 0; start < numEntries; start += CORE_BTREE_FILL)
+    {
+        int leaf = core_btree_allocNode(header, 1);
+        int n = numEntries - start < CORE_BTREE_FILL ? numEntries - start : CORE_BTREE_FILL;
+        for(int i = 0; i < n; i++)
+        {
+            nodes[leaf].keys[i] = entries[start + i].key;
+            nodes[leaf].rows[i] = entries[start + i].row;
+        }
+        nodes[leaf].numKeys = n;
+        nodes[leaf].prev = prev;
+        if(prev != CORE_BTREE_NONE) nodes[prev].next = leaf;
+        prev = leaf;
+        entries[numLevel].key = nodes[leaf].keys[0];
+        entries[numLevel].row = nodes[leaf].rows[0];
+        entries[numLevel].node = leaf;
+        numLevel++;
+    }
+    header->height = 1;
+    //Then each level of inner nodes, until one node is left.
+    while(numLevel > 1)
+    {
+        int numParents = 0;
+        for(int start = 0; start < numLevel; start += CORE_BTREE_FILL + 1)
+        {
+            int inner = core_btree_allocNode(header, 0);
+            int n = numLevel - start < CORE_BTREE_FILL + 1 ? numLevel - start : CORE_BTREE_FILL + 1;
+            for(int i = 0; i < n; i++)
+            {
+                nodes[inner].children[i] = entries[start + i].node;
+                if(i == 0) continue;
+                nodes[inner].keys[i - 1] = entries[start + i].key;
+                nodes[inner].rows[i - 1] = entries[start + i].row;
+            }
+            nodes[inner].numKeys = n - 1;
+            entries[numParents].key = entries[start].key;
+            entries[numParents].row = entries[start].row;
+            entries[numParents].node = inner;
+            numParents++;
+        }
+        numLevel = numParents;
+        header->height++;
+    }
+    header->root = entries[0].node;
+    core_dealloc(entries);
+}
+
+/** @brief Adds the (used) row \p row to the index, under the key it currently holds.
+ *
+ * Nothing is done for a row of -1, as given when inserting into a full table.
+ */
+void core_btree_insert(void* tree, void* field, unsigned int* useField, int numRows, int row)
+{
+    core_btree_header* header = tree;
+    if(row < 0) return;
+    //Rebuilding frees the nodes left behind by deletes, and puts row in along with the rest.
+    if(header->numFree < header->height + 1 || header->height + 1 >= CORE_BTREE_MAX_HEIGHT)
+    {
+        core_btree_rebuild(tree, field, useField, numRows);
+        return;
+    }
+    core_btree_place(header, core_btree_key(header, field, row), row);
+    header->version++;
+}
+
+/** @brief Takes \p row out of the index, which must be done before the key it holds changes.
+ *
+ * Nothing is done for a row of -1, as given by a row reference to an id not in use.
+ */
+void core_btree_remove(void* tree, void* field, int row)
+{
+    core_btree_header* header = tree;
+    if(row < 0) return;
+    core_btree_node* nodes = CORE_BTREE_NODES(header);
+    unsigned long long key = core_btree_key(header, field, row);
+    int path[CORE_BTREE_MAX_HEIGHT];
+    int pathSlots[CORE_BTREE_MAX_HEIGHT];
+    int depth = 0;
+    int node = header->root;
+    while(!nodes[node].leaf)
+    {
+        int slot = core_btree_childSlot(&nodes[node], key, row);
+        path[depth] = node;
+        pathSlots[depth] = slot;
+        depth++;
+        node = nodes[node].children[slot];
+    }
+    int slot = 0;
+    while(slot < nodes[node].numKeys && (nodes[node].keys[slot] != key || nodes[node].rows[slot] != row)) slot++;
+    if(slot == nodes[node].numKeys) return;
+    for(int i = slot + 1; i < nodes[node].numKeys; i++)
+    {
+        nodes[node].keys[i - 1] = nodes[node].keys[i];
+        nodes[node].rows[i - 1] = nodes[node].rows[i];
+    }
+    nodes[node].numKeys--;
+    header->version++;
+    if(nodes[node].numKeys > 0 || node == header->root) return;
+    //Free the empty leaf, and any inner nodes left without children.
+    if(nodes[node].prev != CORE_BTREE_NONE) nodes[nodes[node].prev].next = nodes[node].next;
+    if(nodes[node].next != CORE_BTREE_NONE) nodes[nodes[node].next].prev = nodes[node].prev;
+    core_btree_freeNode(header, node);
+    while(depth > 0)
+    {
+        node = path[--depth];
+        slot = pathSlots[depth];
+        core_btree_node* inner = &nodes[node];
+        if(inner->numKeys == 0)
+        {
+            if(node != header->root)
+            {
+                core_btree_freeNode(header, node);
+                continue;
+            }
+            //Every entry is gone.
+            core_btree_clear(header);
+            return;
+        }
+        //The separator to the left of the child goes with it, or the one to its right for the first child.
+        int keySlot = slot > 0 ? slot - 1 : 0;
+        for(int i = keySlot + 1; i < inner->numKeys; i++)
+        {
+            inner->keys[i - 1] = inner->keys[i];
+            inner->rows[i - 1] = inner->rows[i];
+        }
+        for(int i = slot + 1; i <= inner->numKeys; i++) inner->children[i - 1] = inner->children[i];
+        inner->numKeys--;
+        break;
+    }
+    //A root with a single child is not needed.
+    while(!nodes[header->root].leaf && nodes[header->root].numKeys == 0)
+    {
+        int root = header->root;
+        header->root = nodes[root].children[0];
+        header->height--;
+        core_btree_freeNode(header, root);
+    }
+}
+
+/** @brief Makes sure the index has room for a table which has grown to \p numRows rows.
+ *
+ * Returns the index, which is moved (and rebuilt) if it was too small.
+ */
+void* core_btree_reserve(void* tree, void* field, unsigned int* useField, int numRows)
+{
+    core_btree_header* header = tree;
+    if(header->capacity >= core_btree_capacity(numRows)) return tree;
+    core_btree_header* grown = core_alloc(core_btree_getSize(numRows));
+    core_btree_init(grown, numRows, header->keySize, header->floating);
+    grown->version = header->version + 1;
+    core_dealloc(tree);
+    core_btree_rebuild(grown, field, useField, numRows);
+    return grown;
+}
+
+/** @brief Points \p cursor at the first entry whose key is at least \p from (or the first entry, if not \p bounded).
+ *
+ * @param from The bits of the key, as held in the field.
+ */
+void core_btree_seek(void* tree, void* cursor, unsigned long long from, int bounded)
+{
+    core_btree_header* header = tree;
+    core_btree_cursor* c = cursor;
+    c->key = bounded ? core_btree_order(header, from) : 0;
+    c->row = -1;
+    core_btree_locate(header, c->key, c->row, &c->node, &c->slot);
+    c->version = header->version;
+}
+
+/** @brief Returns the row of the next entry, or -1 once the entries run out or pass \p to (if \p bounded).
+ *
+ * If the tree has changed since the last call, the cursor carries on from the last entry it returned,
+ * so rows may be inserted or deleted while iterating. A row whose key is moved past that entry is met again,
+ * which is why tabic rejects assignments to the ordering field inside a scan in its order.
+ *
+ * @param to The bits of the last key wanted, as held in the field.
+ */
+int core_btree_next(void* tree, void* cursor, unsigned long long to, int bounded)
+{
+    core_btree_header* header = tree;
+    core_btree_node* nodes = CORE_BTREE_NODES(header);
+    core_btree_cursor* c = cursor;
+    if(c->version != header->version)
+    {
+        core_btree_locate(header, c->key, c->row, &c->node, &c->slot);
+        c->version = header->version;
+    }
+    while(c->node != CORE_BTREE_NONE && c->slot >= nodes[c->node].numKeys)
+    {
+        c->node = nodes[c->node].next;
+        c->slot = 0;
+    }
+    if(c->node == CORE_BTREE_NONE) return -1;
+    unsigned long long key = nodes[c->node].keys[c->slot];
+    if(bounded && key > core_btree_order(header, to)) return -1;
+    c->key = key;
+    c->row = nodes[c->node].rows[c->slot];
+    c->slot++;
+    return c->row;
+}
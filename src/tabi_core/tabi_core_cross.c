@@ -14,6 +14,21 @@ https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
 #include<stdio.h>
 #include<stdlib.h>
 #include<memory.h>
+#ifdef WINDOWS
+#include<malloc.h>
+#endif
+#ifdef __linux__
+#include<sys/mman.h>
+#endif
+#include"tabi_core_stats.h"
+
+/** @brief The alignment of memory from core_alloc_aligned, which is a cache line (or two on some machines). 
+ */
+#define CORE_ALIGNMENT 64
+
+/** @brief Allocations from core_alloc_aligned of at least this many bytes are backed by huge pages where the system allows. 
+ */
+#define CORE_HUGE_PAGE_THRESHOLD (2LL << 20)
 
 void _tabi_init(); 
 void _tabi_destroy(); 
@@ -23,9 +38,51 @@ int _tabi_main();
  * 
  * @param numBytes The size (in bytes) of the memory to be allocated.
  */
-void* core_alloc(int numBytes)
+void* core_alloc(long long numBytes)
+{
+#ifdef WINDOWS
+    //Aligned and unaligned memory are both freed by core_dealloc, so both come from _aligned_malloc. 
+    void* ptr = _aligned_malloc(numBytes, sizeof(long double)); 
+#else
+    void* ptr = malloc(numBytes);
+#endif
+    if(core_stats_enabled) core_stats_alloc(ptr, numBytes, CORE_RETURN_ADDRESS); 
+    return ptr; 
+}
+
+static void* core_mallocAligned(long long alignment, long long numBytes)
+{
+#ifdef WINDOWS
+    return _aligned_malloc(numBytes, alignment); 
+#else
+    void* ptr; 
+    return posix_memalign(&ptr, alignment, numBytes) ? 0 : ptr; 
+#endif
+}
+
+/** @brief Allocates memory on the heap, aligned to CORE_ALIGNMENT bytes. 
+ *
+ * This is used for the arrays of table fields and vector elements, which are scanned a cache line at a time. 
+ * Large allocations are aligned to, and padded out to, a whole number of huge pages, and the system is advised 
+ * to back them with huge pages, to cut the TLB misses of scanning them. 
+ * The memory is freed through core_dealloc. 
+ *
+ * @param numBytes The size (in bytes) of the memory to be allocated.
+ */
+void* core_alloc_aligned(long long numBytes)
 {
-    return malloc(numBytes);
+    void* ptr; 
+    if(numBytes < CORE_HUGE_PAGE_THRESHOLD) ptr = core_mallocAligned(CORE_ALIGNMENT, numBytes); 
+    else
+    {
+        long long size = (numBytes + CORE_HUGE_PAGE_THRESHOLD - 1) & ~(CORE_HUGE_PAGE_THRESHOLD - 1); 
+        ptr = core_mallocAligned(CORE_HUGE_PAGE_THRESHOLD, size); 
+#ifdef MADV_HUGEPAGE
+        if(ptr) madvise(ptr, size, MADV_HUGEPAGE); 
+#endif
+    }
+    if(core_stats_enabled) core_stats_alloc(ptr, numBytes, CORE_RETURN_ADDRESS); 
+    return ptr; 
 }
 
 /** brief Frees memory from the heap.
@@ -35,16 +92,43 @@ void* core_alloc(int numBytes)
  */
 void core_dealloc(void* ptr)
 {
+    if(core_stats_enabled) core_stats_dealloc(ptr); 
+#ifdef WINDOWS
+    _aligned_free(ptr); 
+#else
     free(ptr); 
+#endif
 }
 
-void core_memcpy(void* dest, void* src, int numBytes)
+void core_memcpy(void* dest, void* src, long long numBytes)
 {
     memcpy(dest, src, numBytes);
 }
 
-int main()
+/** @brief Sets every byte of a region to \p value. 
+ */
+void core_memset(void* dest, int value, long long numBytes)
+{
+    memset(dest, value, numBytes);
+}
+
+/** @brief Copies memory between regions which may overlap. 
+ */
+void core_memmove(void* dest, void* src, long long numBytes)
+{
+    memmove(dest, src, numBytes);
+}
+
+/** @brief Writes part of the allocation report (see tabi_core_stats.c). 
+ */
+void core_stats_write(char* str, long long length)
+{
+    fwrite(str, 1, length, stderr); 
+}
+
+int main(int argc, char** argv, char** envp)
 {
+    core_stats_init(envp); 
     _tabi_init();
     int code = _tabi_main();  
     _tabi_destroy(); 
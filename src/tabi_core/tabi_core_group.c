@@ -0,0 +1,96 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+#include"tabi_core_table.h"
+
+void* core_alloc(long long numBytes);
+void  core_dealloc(void* ptr);
+void  core_memcpy(void* dest, void* src, long long numBytes);
+int   core_table_insertRow(void** table, int numRows, int* id);
+int   core_table_reserve(void** table, int numRows, int maxRows, int numFields, int* fieldSizes);
+
+/* Hash grouping of the rows of a table by a key field.
+ *
+ * The used rows are read once, in row order, and each distinct key is given a row of the output table,
+ * whose first user field is set to the key. The hash table is open addressing with linear probing,
+ * holding output rows, and keys are compared against those already written to the output.
+ *
+ * Only the grouping is done here: the output row of each row is written to a Int array, which
+ * the compiled code then reads to fold each aggregated field into its group, knowing the field types.
+ * The first row of each group is marked, so that the aggregates can start from it,
+ * and rows which belong to no group are marked to be skipped.
+ */
+
+#define CORE_GROUP_EMPTY -1
+
+/** @brief The group of a row which is not used, or whose group did not fit in the output table.
+ *
+ * Otherwise the group of a row is its output row, or -1 minus its output row when it is the first row of the group.
+ */
+#define CORE_GROUP_SKIP (-2147483647 - 1)
+
+/** @brief Groups the used rows of \p table by their key, adding a row to \p out for each distinct key.
+ *
+ * @param keyField The index of the key field of \p table (which may be its `id` field).
+ * @param keySize The size of the elements of the key field, which is also the first user field of \p out.
+ * @param maxRows The most rows \p out grows to when full, as for core_table_reserve, or 0 if it does not grow. Either way, keys are only added while there is room.
+ * @param numFields The number of user fields of \p out, which are described by \p fieldSizes as for core_table_reserve.
+ * @param groups Set to the group of each of the \p numRows rows of \p table (see CORE_GROUP_SKIP).
+ *
+ * Returns the number of rows added to \p out.
+ */
+int core_group_hash(void** table, int numRows, int keyField, int keySize,
+        void** out, int outRows, int maxRows, int numFields, int* fieldSizes, int* groups)
+{
+    void* keys = table[keyField];
+    unsigned int* useField = table[1];
+    //The slots last only for the group, so may number up to 2^31, which leaves one empty for any number of rows.
+    long long capacity = 8;
+    int shift = 61;
+    while(capacity/2 < ((int*)table[2])[CORE_TABLE_NUM_USED] && capacity < (1LL << 31)) { capacity <<= 1; shift--; }
+    int* slots = core_alloc(sizeof(int)*capacity);
+    long long mask = capacity - 1;
+    for(long long i = 0; i < capacity; i++) slots[i] = CORE_GROUP_EMPTY;
+    int numAdded = 0;
+    for(int row = 0; row < numRows; row++)
+    {
+        if(!CORE_TABLE_IS_USED(useField, row))
+        {
+            groups[row] = CORE_GROUP_SKIP;
+            continue;
+        }
+        unsigned long long key = core_table_readKey(keys, keySize, row);
+        long long slot = (long long)((key*0x9E3779B97F4A7C15ull) >> shift);
+        //The output's key field moves when it grows, so is read afresh each time.
+        while(slots[slot] != CORE_GROUP_EMPTY && core_table_readKey(out[CORE_TABLE_META_FIELDS], keySize, slots[slot]) != key) slot = (slot + 1) & mask;
+        if(slots[slot] != CORE_GROUP_EMPTY)
+        {
+            groups[row] = slots[slot];
+            continue;
+        }
+        if(maxRows) outRows = core_table_reserve(out, outRows, maxRows, numFields, fieldSizes);
+        int outRow = core_table_insertRow(out, outRows, 0);
+        if(outRow < 0)
+        {
+            groups[row] = CORE_GROUP_SKIP;
+            continue;
+        }
+        core_memcpy((char*)out[CORE_TABLE_META_FIELDS] + (long long)keySize*outRow, (char*)keys + (long long)keySize*row, keySize);
+        slots[slot] = outRow;
+        groups[row] = -1 - outRow;
+        numAdded++;
+    }
+    core_dealloc(slots);
+    return numAdded;
+}
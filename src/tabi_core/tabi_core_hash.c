@@ -0,0 +1,178 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+#include"tabi_core_table.h"
+
+void* core_alloc(long long numBytes); 
+void  core_dealloc(void* ptr); 
+
+/* Hash indexes over a single field of a table, used for the fields declared `indexed`.
+ *
+ * An index is an array of Int laid out as,
+ *
+ *     header[CORE_HASH_HEADER] | slots[capacity]
+ *
+ * where each slot holds a row, CORE_HASH_EMPTY or CORE_HASH_DELETED. Keys are not copied into the index,
+ * but read from the field itself, as the (little-endian) value of its first keySize (at most 8) bytes.
+ * Collisions are resolved by linear probing, and the capacity is the least power of two which is at least 
+ * twice the number of rows, so that the index is never more than half full of keys. 
+ * Deleted slots are only reclaimed by rebuilding the index, which happens once they fill a quarter of it. 
+ */
+
+#define CORE_HASH_HEADER 4
+
+#define CORE_HASH_CAPACITY 0        ///< Header slot holding the number of slots. 
+#define CORE_HASH_SHIFT 1           ///< Header slot holding 64 less the log2 of the capacity. 
+#define CORE_HASH_NUM_KEYS 2        ///< Header slot holding the number of rows in the index. 
+#define CORE_HASH_NUM_DELETED 3     ///< Header slot holding the number of deleted slots. 
+
+#define CORE_HASH_EMPTY -1
+#define CORE_HASH_DELETED -2
+
+#define CORE_HASH_MIN_CAPACITY 8
+
+/** @brief Returns the number of slots for a table with \p numRows rows, keeping the load at most a half. 
+ *
+ * Slots are Int, so the capacity stops at 2^30, which limits growable indexed tables to CORE_TABLE_MAX_INDEXED_ROWS. 
+ */
+static int core_hash_capacity(int numRows)
+{
+    int capacity = CORE_HASH_MIN_CAPACITY; 
+    while(capacity/2 < numRows && capacity < (1 << 30)) capacity <<= 1; 
+    return capacity; 
+}
+
+/** @brief Returns the slot at which probing for \p key starts, by Fibonacci hashing. 
+ */
+static int core_hash_slot(int* hash, unsigned long long key)
+{
+    return (int)((key*0x9E3779B97F4A7C15ull) >> hash[CORE_HASH_SHIFT]); 
+}
+
+/** @brief Puts \p row in the first empty or deleted slot for \p key. 
+ */
+static void core_hash_place(int* hash, unsigned long long key, int row)
+{
+    int* slots = hash + CORE_HASH_HEADER; 
+    int mask = hash[CORE_HASH_CAPACITY] - 1; 
+    int slot = core_hash_slot(hash, key); 
+    while(slots[slot] >= 0) slot = (slot + 1) & mask; 
+    if(slots[slot] == CORE_HASH_DELETED) hash[CORE_HASH_NUM_DELETED]--; 
+    slots[slot] = row; 
+    hash[CORE_HASH_NUM_KEYS]++; 
+}
+
+/** @brief Returns the number of Int needed for the index of a table with \p numRows rows. 
+ */
+int core_hash_getSize(int numRows)
+{
+    return CORE_HASH_HEADER + core_hash_capacity(numRows); 
+}
+
+/** @brief Sets up an empty index for a table with \p numRows rows. 
+ */
+void core_hash_init(int* hash, int numRows)
+{
+    int capacity = core_hash_capacity(numRows); 
+    int shift = 64; 
+    for(int c = capacity; c > 1; c >>= 1) shift--; 
+    hash[CORE_HASH_CAPACITY] = capacity; 
+    hash[CORE_HASH_SHIFT] = shift; 
+    hash[CORE_HASH_NUM_KEYS] = 0; 
+    hash[CORE_HASH_NUM_DELETED] = 0; 
+    for(int i = 0; i < capacity; i++) hash[CORE_HASH_HEADER + i] = CORE_HASH_EMPTY; 
+}
+
+/** @brief Empties the index, then puts every used row back into it. 
+ */
+void core_hash_rebuild(int* hash, void* field, int keySize, unsigned int* useField, int numRows)
+{
+    int capacity = hash[CORE_HASH_CAPACITY]; 
+    for(int i = 0; i < capacity; i++) hash[CORE_HASH_HEADER + i] = CORE_HASH_EMPTY; 
+    hash[CORE_HASH_NUM_KEYS] = 0; 
+    hash[CORE_HASH_NUM_DELETED] = 0; 
+    for(int w = 0; w < (numRows + 31) >> 5; w++)
+    {
+        for(unsigned int word = useField[w]; word; word &= word - 1)
+        {
+            int row = (w << 5) + __builtin_ctz(word); 
+            core_hash_place(hash, core_table_readKey(field, keySize, row), row); 
+        }
+    }
+}
+
+/** @brief Adds the (used) row \p row to the index, under the key it currently holds. 
+ *
+ * Nothing is done for a row of -1, as given when inserting into a full table. 
+ */
+void core_hash_insert(int* hash, void* field, int keySize, unsigned int* useField, int numRows, int row)
+{
+    if(row < 0) return; 
+    //Rebuilding clears the deleted slots, and puts row in along with the rest. 
+    if(4*(hash[CORE_HASH_NUM_KEYS] + hash[CORE_HASH_NUM_DELETED] + 1) > 3*hash[CORE_HASH_CAPACITY])
+    {
+        core_hash_rebuild(hash, field, keySize, useField, numRows); 
+        return; 
+    }
+    core_hash_place(hash, core_table_readKey(field, keySize, row), row); 
+}
+
+/** @brief Takes \p row out of the index, which must be done before the key it holds changes. 
+ *
+ * Nothing is done for a row of -1, as given by a row reference to an id not in use. 
+ */
+void core_hash_remove(int* hash, void* field, int keySize, int row)
+{
+    if(row < 0) return; 
+    int* slots = hash + CORE_HASH_HEADER; 
+    int mask = hash[CORE_HASH_CAPACITY] - 1; 
+    for(int slot = core_hash_slot(hash, core_table_readKey(field, keySize, row)); slots[slot] != CORE_HASH_EMPTY; slot = (slot + 1) & mask)
+    {
+        if(slots[slot] == row)
+        {
+            slots[slot] = CORE_HASH_DELETED; 
+            hash[CORE_HASH_NUM_KEYS]--; 
+            hash[CORE_HASH_NUM_DELETED]++; 
+            return; 
+        }
+    }
+}
+
+/** @brief Returns a used row holding \p key, or -1 if there is none. 
+ */
+int core_hash_find(int* hash, void* field, int keySize, unsigned int* useField, unsigned long long key)
+{
+    int* slots = hash + CORE_HASH_HEADER; 
+    int mask = hash[CORE_HASH_CAPACITY] - 1; 
+    for(int slot = core_hash_slot(hash, key); slots[slot] != CORE_HASH_EMPTY; slot = (slot + 1) & mask)
+    {
+        int row = slots[slot]; 
+        if(row >= 0 && CORE_TABLE_IS_USED(useField, row) && core_table_readKey(field, keySize, row) == key) return row; 
+    }
+    return -1; 
+}
+
+/** @brief Makes sure the index has room for a table which has grown to \p numRows rows. 
+ *
+ * Returns the index, which is moved (and rebuilt) if it was too small. 
+ */
+int* core_hash_reserve(int* hash, void* field, int keySize, unsigned int* useField, int numRows)
+{
+    if(hash[CORE_HASH_CAPACITY] >= core_hash_capacity(numRows)) return hash; 
+    int* grown = core_alloc(sizeof(int)*(long long)core_hash_getSize(numRows)); 
+    core_hash_init(grown, numRows); 
+    core_dealloc(hash); 
+    core_hash_rebuild(grown, field, keySize, useField, numRows); 
+    return grown; 
+}
@@ -0,0 +1,120 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+#include"tabi_core_table.h"
+
+void* core_alloc(long long numBytes);
+void  core_dealloc(void* ptr);
+int   core_table_insertRow(void** table, int numRows, int* id);
+int   core_table_reserve(void** table, int numRows, int maxRows, int numFields, int* fieldSizes);
+
+/* Hash joins of two tables on a key field of each.
+ *
+ * The table with fewer used rows (the build side) is hashed on its key, and the other (the probe side)
+ * is then read once, looking each of its keys up. The hash table is open addressing with linear probing,
+ * with each slot holding the first build row of a distinct key, and the rest of the rows with that key
+ * chained after it (in row order) through a second array. Both are only needed for the one join.
+ *
+ * Each match adds a row to the output table, with the left table's id in its first user field
+ * and the right table's id in its second, in the order of the probe side's rows.
+ */
+
+#define CORE_JOIN_EMPTY -1
+
+/** @brief Inserts the pair (leftID, rightID) into the output table, growing it first if it is growable and full.
+ *
+ * Returns 0 if there was no room.
+ */
+static int core_join_emit(void** out, int* outRows, int maxRows, int numFields, int* fieldSizes, int leftID, int rightID)
+{
+    if(maxRows) *outRows = core_table_reserve(out, *outRows, maxRows, numFields, fieldSizes);
+    int row = core_table_insertRow(out, *outRows, 0);
+    if(row < 0) return 0;
+    ((int*)out[CORE_TABLE_META_FIELDS])[row] = leftID;
+    ((int*)out[CORE_TABLE_META_FIELDS + 1])[row] = rightID;
+    return 1;
+}
+
+/** @brief Joins the used rows of \p left and \p right whose keys are equal, adding a row to \p out for each pair.
+ *
+ * @param leftField The index of the key field of \p left (which may be its `id` field).
+ * @param keySize The size of the elements of both key fields, which have the same type.
+ * @param maxRows The most rows \p out grows to when full, as for core_table_reserve, or 0 if it does not grow. Either way, the join stops once it is full.
+ * @param numFields The number of user fields of \p out, which are described by \p fieldSizes as for core_table_reserve.
+ *
+ * Returns the number of rows added to \p out.
+ */
+int core_join_hash(void** left, int leftRows, int leftField, void** right, int rightRows, int rightField, int keySize,
+        void** out, int outRows, int maxRows, int numFields, int* fieldSizes)
+{
+    //Build on the smaller side.
+    int leftBuilds = ((int*)left[2])[CORE_TABLE_NUM_USED] <= ((int*)right[2])[CORE_TABLE_NUM_USED];
+    void** build = leftBuilds ? left : right;
+    void** probe = leftBuilds ? right : left;
+    int buildRows = leftBuilds ? leftRows : rightRows;
+    int probeRows = leftBuilds ? rightRows : leftRows;
+    void* buildKeys = build[leftBuilds ? leftField : rightField];
+    void* probeKeys = probe[leftBuilds ? rightField : leftField];
+    unsigned int* buildUse = build[1];
+    unsigned int* probeUse = probe[1];
+    int* buildIDs = build[0];
+    int* probeIDs = probe[0];
+
+    //The slots last only for the join, so may number up to 2^31, which leaves one empty for any number of rows.
+    long long capacity = 8;
+    int shift = 61;
+    while(capacity/2 < ((int*)build[2])[CORE_TABLE_NUM_USED] && capacity < (1LL << 31)) { capacity <<= 1; shift--; }
+    int* slots = core_alloc(sizeof(int)*(capacity + buildRows));
+    int* chain = slots + capacity;
+    long long mask = capacity - 1;
+    for(long long i = 0; i < capacity; i++) slots[i] = CORE_JOIN_EMPTY;
+    //Rows are taken last to first, so that each is put at the front of its chain and the chains end up in row order.
+    for(int w = ((buildRows + 31) >> 5) - 1; w >= 0; w--)
+    {
+        for(unsigned int word = buildUse[w]; word; word &= ~(1u << (31 - __builtin_clz(word))))
+        {
+            int row = (w << 5) + 31 - __builtin_clz(word);
+            unsigned long long key = core_table_readKey(buildKeys, keySize, row);
+            long long slot = (long long)((key*0x9E3779B97F4A7C15ull) >> shift);
+            while(slots[slot] != CORE_JOIN_EMPTY && core_table_readKey(buildKeys, keySize, slots[slot]) != key) slot = (slot + 1) & mask;
+            chain[row] = slots[slot];
+            slots[slot] = row;
+        }
+    }
+    int numAdded = 0;
+    for(int w = 0; w < (probeRows + 31) >> 5; w++)
+    {
+        for(unsigned int word = probeUse[w]; word; word &= word - 1)
+        {
+            int row = (w << 5) + __builtin_ctz(word);
+            unsigned long long key = core_table_readKey(probeKeys, keySize, row);
+            long long slot = (long long)((key*0x9E3779B97F4A7C15ull) >> shift);
+            while(slots[slot] != CORE_JOIN_EMPTY && core_table_readKey(buildKeys, keySize, slots[slot]) != key) slot = (slot + 1) & mask;
+            for(int match = slots[slot]; match != CORE_JOIN_EMPTY; match = chain[match])
+            {
+                int added = leftBuilds
+                    ? core_join_emit(out, &outRows, maxRows, numFields, fieldSizes, buildIDs[match], probeIDs[row])
+                    : core_join_emit(out, &outRows, maxRows, numFields, fieldSizes, probeIDs[row], buildIDs[match]);
+                if(!added)
+                {
+                    core_dealloc(slots);
+                    return numAdded;
+                }
+                numAdded++;
+            }
+        }
+    }
+    core_dealloc(slots);
+    return numAdded;
+}
@@ -15,62 +15,284 @@ extern main
 extern _tabi_init
 extern _tabi_destroy
 
+section .data
+
+core_memcpy_impl: dq core_memcpy_sse2
+core_memset_impl: dq core_memset_sse2
+core_mem_erms: dq 0
+
 section .text
 
 global _exit
 
-global core_alloc
-global core_dealloc
+global core_sys_mmap
+global core_sys_munmap
+global core_sys_madvise
+global core_sys_write
+global core_mem_select
 global core_memcpy
+global core_memset
+global core_memmove
 
 ; arg order: rdi, rsi, rdx, r10, r8, r9
 
 %define SYSCALL_MMAP 9
 %define SYSCALL_MUNMAP 11
+%define SYSCALL_MADVISE 28
+%define SYSCALL_WRITE 1
 
 %define PROT_READ 1
 %define PROT_WRITE 2
 
 %define MAP_ANONYMOUS 32
-%define MAP_SHARED 1
+%define MAP_PRIVATE 2
+
+%define CPUID_AVX2 (1 << 5)       ; leaf 7, ebx 
+%define CPUID_ERMS (1 << 9)       ; leaf 7, ebx 
+%define CPUID_OSXSAVE (1 << 27)   ; leaf 1, ecx 
+%define CPUID_AVX (1 << 28)       ; leaf 1, ecx 
+%define XCR0_SSE_AVX 6            ; the OS saves the xmm and ymm registers 
+
+%define ERMS_THRESHOLD 2048       ; from this many bytes, rep movsb and rep stosb are used where ERMS makes them fast 
+
+; the heap itself (core_alloc, core_alloc_aligned and core_dealloc) is in tabi_core_alloc.c, 
+; which gets its memory through these 
 
-; args (numbytes) 
-core_alloc: 
-push rdi
+; args (length) 
+; returns the address of the mapping, or -errno 
+core_sys_mmap: 
 mov rsi, rdi                  ; length
-add rsi, 8                    ; need extra space to store the length itself 
 mov rax, SYSCALL_MMAP
 xor rdi, rdi                  ; address (null because we want the system to provide this) 
 mov rdx, PROT_READ+PROT_WRITE ; memory protection (can read and write)
-mov r10, MAP_SHARED+MAP_ANONYMOUS        ; memory flags - memory is not associated with a file
+mov r10, MAP_PRIVATE+MAP_ANONYMOUS       ; private, so that it may be backed by huge pages 
 mov r8, -1                    ; file descriptor (probably ignored due to flags)
 mov r9, 0                     ; offset
 syscall 
-pop rsi 
-mov qword [rax], rsi          ; store the length of the allocation 
-add rax, 8                    
 ret 
 
-; args (ptr)
-core_dealloc:
+; args (addr, length)
+core_sys_munmap:
 mov rax, SYSCALL_MUNMAP
-sub rdi, 8
-mov rsi, [rdi] 
 syscall
 ret
 
+; args (addr, length, advice)
+core_sys_madvise:
+mov rax, SYSCALL_MADVISE
+syscall
+ret
+
+; args (fd, buf, length) 
+; returns the number of bytes written, or -errno 
+core_sys_write:
+mov rax, SYSCALL_WRITE
+syscall
+ret
+
+; picks the core_memcpy and core_memset to use, by CPUID 
+; called by _tabi_start before anything else, so that SSE2 (which every x86-64 CPU has) is only the fallback 
+core_mem_select:
+push rbx                      ; cpuid clobbers rbx, which must be preserved 
+xor eax, eax
+cpuid
+cmp eax, 7
+jb .done                      ; no leaf 7, so neither AVX2 nor ERMS 
+mov eax, 7
+xor ecx, ecx
+cpuid
+mov r8d, ebx                  ; extended features 
+test r8d, CPUID_ERMS
+jz .check_avx2
+mov qword [rel core_mem_erms], 1
+.check_avx2:
+test r8d, CPUID_AVX2
+jz .done
+mov eax, 1
+cpuid
+and ecx, CPUID_OSXSAVE+CPUID_AVX
+cmp ecx, CPUID_OSXSAVE+CPUID_AVX
+jne .done
+xor ecx, ecx
+xgetbv                        ; edx:eax = XCR0 
+and eax, XCR0_SSE_AVX
+cmp eax, XCR0_SSE_AVX
+jne .done                     ; the OS does not save the ymm registers 
+lea rax, [rel core_memcpy_avx2]
+mov [rel core_memcpy_impl], rax
+lea rax, [rel core_memset_avx2]
+mov [rel core_memset_impl], rax
+.done:
+pop rbx
+ret
+
 ; arg (dest, src, numBytes)
 core_memcpy:
-mov rbx, -1
-.copy_byte: 
-mov rax, [rsi]
-mov [rdi], rax  
-inc rbx 
-inc rsi
-inc rdi 
-cmp rbx, rdx
-jl .copy_byte 
-ret  
+jmp [rel core_memcpy_impl]
+
+; arg (dest, value, numBytes)
+core_memset:
+jmp [rel core_memset_impl]
+
+; the copies below are all given (dest, src, numBytes), and leave rbx alone 
+; each vector copy loads the last vector first and stores it last, covering whatever the loop leaves 
+
+core_memcpy_small:
+xor ecx, ecx
+jmp .check
+.copy_byte:
+mov al, [rsi+rcx]
+mov [rdi+rcx], al
+inc rcx
+.check:
+cmp rcx, rdx
+jb .copy_byte
+ret
+
+core_memcpy_erms:
+mov rcx, rdx
+rep movsb
+ret
+
+core_memcpy_sse2:
+cmp rdx, 16
+jb core_memcpy_small
+cmp rdx, ERMS_THRESHOLD
+jb .vector
+cmp qword [rel core_mem_erms], 0
+jne core_memcpy_erms
+.vector:
+movdqu xmm1, [rsi+rdx-16]     ; the last vector 
+lea r8, [rdx-16]
+xor ecx, ecx
+jmp .check
+.copy_vector:
+movdqu xmm0, [rsi+rcx]
+movdqu [rdi+rcx], xmm0
+add rcx, 16
+.check:
+cmp rcx, r8
+jb .copy_vector
+movdqu [rdi+rdx-16], xmm1
+ret
+
+core_memcpy_avx2:
+cmp rdx, 32
+jb core_memcpy_sse2
+cmp rdx, ERMS_THRESHOLD
+jb .vector
+cmp qword [rel core_mem_erms], 0
+jne core_memcpy_erms
+.vector:
+vmovdqu ymm1, [rsi+rdx-32]    ; the last vector 
+lea r8, [rdx-32]
+xor ecx, ecx
+jmp .check
+.copy_vector:
+vmovdqu ymm0, [rsi+rcx]
+vmovdqu [rdi+rcx], ymm0
+add rcx, 32
+.check:
+cmp rcx, r8
+jb .copy_vector
+vmovdqu [rdi+rdx-32], ymm1
+vzeroupper
+ret
+
+; the sets below are all given (dest, value, numBytes) 
+
+core_memset_small:
+xor ecx, ecx
+jmp .check
+.set_byte:
+mov [rdi+rcx], sil
+inc rcx
+.check:
+cmp rcx, rdx
+jb .set_byte
+ret
+
+core_memset_erms:
+mov eax, esi
+mov rcx, rdx
+rep stosb
+ret
+
+core_memset_sse2:
+cmp rdx, 16
+jb core_memset_small
+cmp rdx, ERMS_THRESHOLD
+jb .vector
+cmp qword [rel core_mem_erms], 0
+jne core_memset_erms
+.vector:
+movzx eax, sil
+mov r8, 0x0101010101010101
+imul rax, r8                  ; the byte in every byte of rax 
+movq xmm0, rax
+punpcklqdq xmm0, xmm0
+lea r8, [rdx-16]
+xor ecx, ecx
+jmp .check
+.set_vector:
+movdqu [rdi+rcx], xmm0
+add rcx, 16
+.check:
+cmp rcx, r8
+jb .set_vector
+movdqu [rdi+rdx-16], xmm0
+ret
+
+core_memset_avx2:
+cmp rdx, 32
+jb core_memset_sse2
+cmp rdx, ERMS_THRESHOLD
+jb .vector
+cmp qword [rel core_mem_erms], 0
+jne core_memset_erms
+.vector:
+movd xmm0, esi
+vpbroadcastb ymm0, xmm0
+lea r8, [rdx-32]
+xor ecx, ecx
+jmp .check
+.set_vector:
+vmovdqu [rdi+rcx], ymm0
+add rcx, 32
+.check:
+cmp rcx, r8
+jb .set_vector
+vmovdqu [rdi+rdx-32], ymm0
+vzeroupper
+ret
+
+; arg (dest, src, numBytes)
+; unlike core_memcpy, the regions may overlap 
+core_memmove:
+mov rax, rdi
+sub rax, rsi
+cmp rax, rdx
+jae core_memcpy               ; dest below src (so rax wraps) or past its end, so copying forward is safe 
+cmp rdx, 16
+jb .copy_byte_backward
+movdqu xmm1, [rsi]            ; the first vector, stored last 
+lea rcx, [rdx-16]
+.copy_vector_backward:        ; dest above src, so copy from the end 
+movdqu xmm0, [rsi+rcx]
+movdqu [rdi+rcx], xmm0
+sub rcx, 16
+jg .copy_vector_backward
+movdqu [rdi], xmm1
+ret
+.copy_byte_backward:
+test rdx, rdx
+jz .done
+dec rdx
+mov al, [rsi+rdx]
+mov [rdi+rdx], al
+jmp .copy_byte_backward
+.done:
+ret
 
 
 _exit:
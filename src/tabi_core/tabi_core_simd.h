@@ -0,0 +1,29 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CORE_SIMD_X86
+#endif
+
+#define CORE_SIMD_NONE 0    ///< Only the portable kernels may be used.
+#define CORE_SIMD_SSE2 1    ///< 128-bit integer and floating point vectors.
+#define CORE_SIMD_AVX2 2    ///< 256-bit integer and floating point vectors.
+
+/** @brief Returns the widest of the CORE_SIMD levels supported by both the CPU and the OS.
+ *
+ * The CPU is only queried on the first call.
+ */
+int core_simd_getLevel(void);
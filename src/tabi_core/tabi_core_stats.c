@@ -0,0 +1,306 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+#include"tabi_core_stats.h"
+
+void* core_alloc(long long numBytes);
+void  core_dealloc(void* ptr);
+
+/* Recording of the allocations of a compiled program, for both runtimes, enabled by setting CORE_STATS_ENV.
+ *
+ * Each runtime's core_alloc, core_alloc_aligned and core_dealloc call in here only when core_stats_enabled
+ * is set, so that a program which does not ask for it pays for no more than the test of a flag.
+ *
+ * The size of each live allocation is kept in a hash table (open addressing with linear probing), so that
+ * frees can be counted in bytes, and with them the peak of the live bytes. Allocations are also counted by
+ * size (in powers of two) and by call site, which is the return address of core_alloc, and so lies in the
+ * compiled code which asked for the memory.
+ *
+ * The report is written to standard error by core_stats_report, which the compiled program's _tabi_destroy
+ * calls. It is formatted here without libc, which the raw runtime does not have.
+ *
+ * The counters of context tables, which a program compiled with `tabic --profile-tables` keeps, are also
+ * reported from here (by core_stats_reportTable), sharing the formatting.
+ */
+
+#define CORE_STATS_NUM_BUCKETS 48           ///< Size classes of the histogram: bucket k counts sizes in (2^(k-1), 2^k].
+#define CORE_STATS_MAX_SITES 1024           ///< The slots of the call site table, which is never grown.
+#define CORE_STATS_MIN_LIVE 1024            ///< The initial slots of the table of live allocations.
+#define CORE_STATS_REPORTED_SITES 16        ///< The call sites reported, those which allocated the most bytes.
+#define CORE_STATS_TABLE_NUM_COUNTERS 7     ///< Matches TableType::PROFILE_NUM_COUNTERS in tabic.
+
+typedef struct core_stats_site
+{
+    void* site;
+    long long count;
+    long long numBytes;
+} core_stats_site;
+
+typedef struct core_stats_entry
+{
+    void* ptr;                              ///< The live allocation, or 0 for an empty slot.
+    long long numBytes;
+} core_stats_entry;
+
+int core_stats_enabled;
+
+//Set while the live table is being grown, since that itself allocates through core_alloc.
+static int core_stats_busy;
+
+static long long core_stats_numAllocs;
+static long long core_stats_allocBytes;
+static long long core_stats_numFrees;
+static long long core_stats_freedBytes;
+static long long core_stats_liveBytes;
+static long long core_stats_peakBytes;
+static long long core_stats_histogram[CORE_STATS_NUM_BUCKETS];
+
+static core_stats_site core_stats_sites[CORE_STATS_MAX_SITES];
+static int core_stats_numSites;
+static core_stats_site core_stats_otherSites;   ///< Allocations from call sites which did not fit the table.
+
+static core_stats_entry* core_stats_live;
+static long long core_stats_liveCapacity;
+static long long core_stats_liveCount;
+
+static unsigned long long core_stats_hash(void* ptr)
+{
+    return ((unsigned long long)ptr >> 4)*0x9E3779B97F4A7C15ull;
+}
+
+void core_stats_init(char** envp)
+{
+    for(; *envp; envp++)
+    {
+        char* var = *envp;
+        const char* name = CORE_STATS_ENV;
+        while(*name && *var == *name) { var++; name++; }
+        if(!*name && *var == '=')
+        {
+            core_stats_enabled = 1;
+            return;
+        }
+    }
+}
+
+static core_stats_site* core_stats_getSite(void* site)
+{
+    long long mask = CORE_STATS_MAX_SITES - 1;
+    long long slot = (long long)(core_stats_hash(site) >> 40) & mask;
+    while(core_stats_sites[slot].site && core_stats_sites[slot].site != site) slot = (slot + 1) & mask;
+    if(core_stats_sites[slot].site) return &core_stats_sites[slot];
+    if(4*(core_stats_numSites + 1) > 3*CORE_STATS_MAX_SITES) return &core_stats_otherSites;
+    core_stats_numSites++;
+    core_stats_sites[slot].site = site;
+    return &core_stats_sites[slot];
+}
+
+static void core_stats_insertLive(core_stats_entry* table, long long capacity, void* ptr, long long numBytes)
+{
+    long long mask = capacity - 1;
+    long long slot = (long long)(core_stats_hash(ptr) >> 20) & mask;
+    while(table[slot].ptr) slot = (slot + 1) & mask;
+    table[slot].ptr = ptr;
+    table[slot].numBytes = numBytes;
+}
+
+/** @brief Doubles the table of live allocations, returning 0 if it could not be allocated.
+ */
+static int core_stats_growLive()
+{
+    long long capacity = core_stats_liveCapacity ? 2*core_stats_liveCapacity : CORE_STATS_MIN_LIVE;
+    core_stats_busy = 1;
+    core_stats_entry* table = core_alloc(capacity*(long long)sizeof(core_stats_entry));
+    core_stats_busy = 0;
+    if(!table) return 0;
+    for(long long i = 0; i < capacity; i++) table[i].ptr = 0;
+    for(long long i = 0; i < core_stats_liveCapacity; i++)
+    {
+        if(core_stats_live[i].ptr) core_stats_insertLive(table, capacity, core_stats_live[i].ptr, core_stats_live[i].numBytes);
+    }
+    core_stats_busy = 1;
+    core_dealloc(core_stats_live);
+    core_stats_busy = 0;
+    core_stats_live = table;
+    core_stats_liveCapacity = capacity;
+    return 1;
+}
+
+void core_stats_alloc(void* ptr, long long numBytes, void* site)
+{
+    if(core_stats_busy || !ptr) return;
+    if(2*(core_stats_liveCount + 1) > core_stats_liveCapacity && !core_stats_growLive()) return;
+    core_stats_insertLive(core_stats_live, core_stats_liveCapacity, ptr, numBytes);
+    core_stats_liveCount++;
+    core_stats_numAllocs++;
+    core_stats_allocBytes += numBytes;
+    core_stats_liveBytes += numBytes;
+    if(core_stats_liveBytes > core_stats_peakBytes) core_stats_peakBytes = core_stats_liveBytes;
+    int bucket = 0;
+    while(bucket < CORE_STATS_NUM_BUCKETS - 1 && (1LL << bucket) < numBytes) bucket++;
+    core_stats_histogram[bucket]++;
+    core_stats_site* entry = core_stats_getSite(site);
+    entry->count++;
+    entry->numBytes += numBytes;
+}
+
+/** @brief Removes the live allocation at \p ptr (if it is known), shifting back the entries which follow it.
+ */
+void core_stats_dealloc(void* ptr)
+{
+    if(core_stats_busy || !ptr || !core_stats_liveCount) return;
+    long long mask = core_stats_liveCapacity - 1;
+    long long i = (long long)(core_stats_hash(ptr) >> 20) & mask;
+    while(core_stats_live[i].ptr && core_stats_live[i].ptr != ptr) i = (i + 1) & mask;
+    //Memory from before recording began is not known.
+    if(!core_stats_live[i].ptr) return;
+    core_stats_numFrees++;
+    core_stats_freedBytes += core_stats_live[i].numBytes;
+    core_stats_liveBytes -= core_stats_live[i].numBytes;
+    core_stats_liveCount--;
+    long long j = i;
+    while(1)
+    {
+        j = (j + 1) & mask;
+        if(!core_stats_live[j].ptr) break;
+        long long home = (long long)(core_stats_hash(core_stats_live[j].ptr) >> 20) & mask;
+        //An entry whose home lies (cyclically) after the hole and at or before it stays put.
+        if(i <= j ? (i < home && home <= j) : (i < home || home <= j)) continue;
+        core_stats_live[i] = core_stats_live[j];
+        i = j;
+    }
+    core_stats_live[i].ptr = 0;
+}
+
+static char core_stats_buffer[256];
+static int core_stats_bufferLength;
+
+static void core_stats_flush()
+{
+    core_stats_write(core_stats_buffer, core_stats_bufferLength);
+    core_stats_bufferLength = 0;
+}
+
+static void core_stats_putStr(const char* str)
+{
+    for(; *str; str++)
+    {
+        if(core_stats_bufferLength == sizeof(core_stats_buffer)) core_stats_flush();
+        core_stats_buffer[core_stats_bufferLength++] = *str;
+    }
+}
+
+static void core_stats_putNum(unsigned long long value, int base)
+{
+    char digits[24];
+    int numDigits = 0;
+    do
+    {
+        digits[numDigits++] = "0123456789abcdef"[value % base];
+        value /= base;
+    } while(value);
+    char str[28];
+    int length = 0;
+    if(base == 16) { str[length++] = '0'; str[length++] = 'x'; }
+    while(numDigits) str[length++] = digits[--numDigits];
+    str[length] = 0;
+    core_stats_putStr(str);
+}
+
+static void core_stats_putBlocks(long long count, long long numBytes)
+{
+    core_stats_putNum(count, 10);
+    core_stats_putStr(" blocks, ");
+    core_stats_putNum(numBytes, 10);
+    core_stats_putStr(" bytes\n");
+}
+
+/** @brief Writes the report to standard error, if recording is enabled, and stops recording.
+ *
+ * The call sites which allocated the most bytes are listed, with the address of core_alloc given
+ * to relate them to the symbols of the program (whose addresses move if it is position independent).
+ */
+void core_stats_report()
+{
+    if(!core_stats_enabled) return;
+    core_stats_enabled = 0;
+    core_stats_putStr("tabi_core allocations\n  allocated: ");
+    core_stats_putBlocks(core_stats_numAllocs, core_stats_allocBytes);
+    core_stats_putStr("  freed:     ");
+    core_stats_putBlocks(core_stats_numFrees, core_stats_freedBytes);
+    core_stats_putStr("  live:      ");
+    core_stats_putBlocks(core_stats_liveCount, core_stats_liveBytes);
+    core_stats_putStr("  peak live: ");
+    core_stats_putNum(core_stats_peakBytes, 10);
+    core_stats_putStr(" bytes\n  sizes:\n");
+    for(int bucket = 0; bucket < CORE_STATS_NUM_BUCKETS; bucket++)
+    {
+        if(!core_stats_histogram[bucket]) continue;
+        core_stats_putStr("    <= ");
+        core_stats_putNum(1ull << bucket, 10);
+        core_stats_putStr(" bytes: ");
+        core_stats_putNum(core_stats_histogram[bucket], 10);
+        core_stats_putStr("\n");
+    }
+    core_stats_putStr("  call sites (core_alloc is at ");
+    core_stats_putNum((unsigned long long)core_alloc, 16);
+    core_stats_putStr("):\n");
+    //The table is no longer looked up, so the sites may be sorted in place, the most bytes first.
+    for(int i = 1; i < CORE_STATS_MAX_SITES; i++)
+    {
+        core_stats_site site = core_stats_sites[i];
+        int j = i;
+        for(; j > 0 && core_stats_sites[j - 1].numBytes < site.numBytes; j--) core_stats_sites[j] = core_stats_sites[j - 1];
+        core_stats_sites[j] = site;
+    }
+    for(int i = 0; i < CORE_STATS_REPORTED_SITES && core_stats_sites[i].site; i++)
+    {
+        core_stats_putStr("    ");
+        core_stats_putNum((unsigned long long)core_stats_sites[i].site, 16);
+        core_stats_putStr(": ");
+        core_stats_putBlocks(core_stats_sites[i].count, core_stats_sites[i].numBytes);
+    }
+    if(core_stats_otherSites.count)
+    {
+        core_stats_putStr("    other sites: ");
+        core_stats_putBlocks(core_stats_otherSites.count, core_stats_otherSites.numBytes);
+    }
+    core_stats_flush();
+}
+
+static const char* core_stats_tableCounters[CORE_STATS_TABLE_NUM_COUNTERS] = {
+    "inserts", "failed inserts", "lookups", "deletes", "measures", "crunches", "scanned rows"
+};
+
+void core_stats_reportTable(char* name, long long* counters)
+{
+    static int headed;
+    if(!headed)
+    {
+        core_stats_putStr("tabi_core table profile\n");
+        headed = 1;
+    }
+    core_stats_putStr("  ");
+    core_stats_putStr(name);
+    core_stats_putStr(":");
+    for(int i = 0; i < CORE_STATS_TABLE_NUM_COUNTERS; i++)
+    {
+        core_stats_putStr(i ? ", " : " ");
+        core_stats_putStr(core_stats_tableCounters[i]);
+        core_stats_putStr(" ");
+        core_stats_putNum(counters[i], 10);
+    }
+    core_stats_putStr("\n");
+    core_stats_flush();
+}
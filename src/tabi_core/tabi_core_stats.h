@@ -0,0 +1,59 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+#pragma once
+
+/** @brief The environment variable which, when set, enables the recording of allocations.
+ */
+#define CORE_STATS_ENV "TABI_ALLOC_STATS"
+
+/** @brief The address core_alloc (or core_dealloc) returns to, taken as the call site of an allocation.
+ */
+#ifdef _MSC_VER
+#include<intrin.h>
+#define CORE_RETURN_ADDRESS _ReturnAddress()
+#else
+#define CORE_RETURN_ADDRESS __builtin_return_address(0)
+#endif
+
+/** @brief Whether allocations are being recorded. Each runtime's heap checks this before calling the functions below.
+ */
+extern int core_stats_enabled;
+
+/** @brief Enables recording if CORE_STATS_ENV is set in \p envp, the environment of the program (null terminated).
+ */
+void core_stats_init(char** envp);
+
+/** @brief Records an allocation of \p numBytes at \p ptr, made from \p site.
+ */
+void core_stats_alloc(void* ptr, long long numBytes, void* site);
+
+/** @brief Records that \p ptr has been freed.
+ */
+void core_stats_dealloc(void* ptr);
+
+/** @brief Writes the report to standard error, if recording is enabled. Called by the compiled program's _tabi_destroy.
+ */
+void core_stats_report();
+
+/** @brief Writes the counters of a table to standard error. Called by _tabi_destroy for each context table, when built with `tabic --profile-tables`.
+ *
+ * @param name The full name of the table's context variable, e.g. `main_World_enemies`.
+ * @param counters The CORE_STATS_TABLE_NUM_COUNTERS counters kept for the table, in the order of TableType::PROFILE_INSERTS and those after it.
+ */
+void core_stats_reportTable(char* name, long long* counters);
+
+/** @brief Writes \p length bytes of the report to standard error. Each runtime has its own.
+ */
+void core_stats_write(char* str, long long length);
@@ -0,0 +1,73 @@
+/*
+Copyright 2022 Matthew Peter Smith
+
+This file is provided under the terms of the Mozilla Public License - Version 2.0.
+A copy of the licence can be found in the root of The Tabitha SDK GitHub repository,
+
+https://github.com/DeltaBoyBZ/tabitha-sdk
+
+or alternatively a copy can be found at,
+
+https://www.mozilla.org/media/MPL/2.0/index.815ca599c9df.txt
+
+*/
+
+#pragma once
+
+/** @brief The number of fields which precede the user's fields in every table: `id`, `#use` and `#index`. 
+ */
+#define CORE_TABLE_META_FIELDS 3
+
+/** @brief The number of Int kept at the start of the `#index` field (see TableType::INDEX_HEADER_SIZE in tabic). 
+ */
+#define CORE_TABLE_INDEX_HEADER 4
+
+#define CORE_TABLE_FREE_ROW 0       ///< Header slot holding the first row of the free row list (or -1). 
+#define CORE_TABLE_NUM_FREE_IDS 1   ///< Header slot holding the number of ids in the free id heap. 
+#define CORE_TABLE_NUM_USED 2       ///< Header slot holding the number of used rows. 
+#define CORE_TABLE_NUM_ROWS 3       ///< Header slot holding the current number of rows, which only changes for growable tables. 
+
+/** @brief The number of rows a growable table is given when it grows from fewer. 
+ */
+#define CORE_TABLE_MIN_GROWN_ROWS 16
+
+/** @brief The most rows a growable table grows to. 
+ *
+ * Rows and ids are Int, while byte sizes and offsets are computed as long long, so a table may hold far more than 2 GB. 
+ * This leaves room to round the row count up to whole `#use` words without overflow. 
+ */
+#define CORE_TABLE_MAX_ROWS 0x7FFFFFE0
+
+/** @brief The most rows a growable table with a hash index grows to. 
+ *
+ * The slots of a hash index are Int, so stop at 2^30 (see core_hash_capacity), and are kept at most half full. 
+ */
+#define CORE_TABLE_MAX_INDEXED_ROWS (1 << 29)
+
+/* The `#use` field of a table is a bitmap of (numRows + 31)/32 words, with bit (row & 31) of word (row >> 5) set when row is used.
+ * 
+ * The `#index` field of a table with numRows rows is laid out as,
+ *
+ *     header[CORE_TABLE_INDEX_HEADER] | index[numRows] | freeIDs[numRows]
+ *
+ * index[id] is the row holding id when in use. Otherwise it is -1 - k, where freeIDs[k] == id.
+ * freeIDs is a binary min-heap, so that an insert takes the smallest free id (as ids were always given out),
+ * and any free id can be taken out of it in logarithmic time.
+ * Unused rows form a list threaded through their `id` field. 
+ *
+ * Ids outside of [0, numRows) can only be created through core_table_getRowByID, and are not indexed.
+ */
+
+#define CORE_TABLE_IS_USED(useField, row) (((useField)[(row) >> 5] >> ((row) & 31)) & 1u)
+
+/** @brief Returns element \p row of a field whose elements are \p keySize (at most 8) bytes, as a little-endian number. 
+ *
+ * This is how the fields used as keys (by indexes, joins and grouping) are read, whatever their type. 
+ */
+static inline unsigned long long core_table_readKey(void* field, int keySize, int row)
+{
+    unsigned char* bytes = (unsigned char*)field + (long long)keySize*row; 
+    unsigned long long key = 0; 
+    for(int i = 0; i < keySize; i++) key |= (unsigned long long)bytes[i] << 8*i; 
+    return key; 
+}
@@ -14,11 +14,17 @@ extern _tabi_main
 extern _exit 
 extern _tabi_init
 extern _tabi_destroy
+extern core_mem_select
+extern core_stats_init
 
 section .text
 global _tabi_start
 
 _tabi_start:
+call core_mem_select
+mov rax, [rsp]                ; argc, followed by the argv pointers and a null, then the environment 
+lea rdi, [rsp+8*rax+16]       ; envp 
+call core_stats_init
 call _tabi_init
 call _tabi_main
 push rax
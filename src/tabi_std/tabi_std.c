@@ -19,7 +19,7 @@ typedef long size_t;
 typedef int size_t;
 #endif
 
-void* core_alloc(int numBytes); 
+void* core_alloc(long long numBytes); 
 void  core_dealloc(void* ptr); 
 void  std_printLn(char* str); 
 void  std_readLn(char* buffer);
@@ -16,6 +16,7 @@ limitations under the License.
 #include"tabic/build.hpp"
 
 #include"tabic/model/model.hpp"
+#include"tabic/util.hpp"
 #include"llvm/IR/LLVMContext.h"
 #include"llvm/IR/IRBuilder.h"
 #include"llvm/IR/Module.h"
@@ -26,6 +27,9 @@ limitations under the License.
 #include"llvm/IR/Value.h"
 #include"llvm/IR/DataLayout.h"
 
+#include<atomic>
+#include<thread>
+
 
 /**
  * Elements such as calling convention are determined by the system. 
@@ -36,10 +40,50 @@ static llvm::CallingConv::ID TABITHA_CALLING_CONVENTION = llvm::CallingConv::Win
 static llvm::CallingConv::ID TABITHA_CALLING_CONVENTION = llvm::CallingConv::X86_64_SysV; 
 #endif
 
-static llvm::LLVMContext llvmContext; 
-static llvm::IRBuilder<> builder(llvmContext);
+//Given -j N, each thread builds its own copy of the Bundle, so has its own context and builder. 
+static thread_local llvm::LLVMContext llvmContext; 
+static thread_local llvm::IRBuilder<> builder(llvmContext);
+
+void tabic::buildBundle(Bundle* bundle, std::function<void(Slab*)> slabBuilt)
+{
+    buildBundleGlobals(bundle); 
+    for(auto pair : bundle->create.slabs)
+    {
+        Slab* slab = pair.second;
+        buildSlabFunctions(slab); 
+        if(slabBuilt) slabBuilt(slab); 
+    }
+}
+
+void tabic::buildBundleInParallel(Bundle* bundle, int numThreads, std::function<Bundle*()> copyBundle, std::function<void(Slab*)> slabBuilt)
+{
+    //Each thread takes the next Slab not yet taken, by its place in the (ordered) map of slabs, which is the same in every copy. 
+    std::atomic<int> nextSlab(0); 
+    auto work = [&](Bundle* threadBundle)
+    {
+        buildBundleGlobals(threadBundle); 
+        std::vector<Slab*> slabs; 
+        for(auto pair : threadBundle->create.slabs) slabs.push_back(pair.second); 
+        for(int i = nextSlab++; i < slabs.size(); i = nextSlab++)
+        {
+            buildSlabFunctions(slabs[i]); 
+            if(slabBuilt) slabBuilt(slabs[i]); 
+        }
+    }; 
+    std::vector<std::thread> threads; 
+    for(int i = 1; i < numThreads; i++)
+    {
+        threads.emplace_back([&]
+        {
+            Bundle* threadBundle = copyBundle(); 
+            if(threadBundle) work(threadBundle); 
+        }); 
+    }
+    work(bundle); 
+    for(std::thread &thread : threads) thread.join(); 
+}
 
-void tabic::buildBundle(Bundle* bundle)
+void tabic::buildBundleGlobals(Bundle* bundle)
 {
     //NOTE: We do not build slab-wise, because e.g. some Type are needed by other Slab.
     //Build the primitive types
@@ -53,6 +97,7 @@ void tabic::buildBundle(Bundle* bundle)
     SupportedPrimitives::CHAR.common.build.llvmType = llvm::Type::getInt8Ty(llvmContext);
     SupportedPrimitives::TRUTH.common.build.llvmType = llvm::Type::getInt1Ty(llvmContext);
     SupportedPrimitives::NONE.common.build.llvmType = llvm::Type::getVoidTy(llvmContext);
+    SupportedPrimitives::ARENA.common.build.llvmType = llvm::Type::getInt8PtrTy(llvmContext);
 
     //Build the core functions.
     {
@@ -80,8 +125,7 @@ void tabic::buildBundle(Bundle* bundle)
     }
     {
         std::vector<llvm::Type*> argTypes = {
-            SupportedPrimitives::NONE.common.build.llvmType->getPointerTo()->getPointerTo(),
-            SupportedPrimitives::INT.common.build.llvmType
+            SupportedPrimitives::NONE.common.build.llvmType->getPointerTo()->getPointerTo()
         };
         TabiCore::TABLE_GET_NUM_USED.build.functionType = llvm::FunctionType::get(SupportedPrimitives::INT.common.build.llvmType, llvm::ArrayRef(argTypes), false);
     }
@@ -97,16 +141,201 @@ void tabic::buildBundle(Bundle* bundle)
     }
     {
         std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::NONE.common.build.llvmType->getPointerTo()->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo()
+        };
+        TabiCore::TABLE_RESERVE.build.functionType = llvm::FunctionType::get(SupportedPrimitives::INT.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::NONE.common.build.llvmType->getPointerTo()->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType
+        };
+        TabiCore::TABLE_FIND_BY_ID.build.functionType = llvm::FunctionType::get(SupportedPrimitives::INT.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::INT.common.build.llvmType
+        };
+        TabiCore::HASH_GET_SIZE.build.functionType = llvm::FunctionType::get(SupportedPrimitives::INT.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType
+        };
+        TabiCore::HASH_INIT.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType
+        };
+        TabiCore::HASH_INSERT.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType
+        };
+        TabiCore::HASH_REMOVE.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::LONG.common.build.llvmType
+        };
+        TabiCore::HASH_FIND.build.functionType = llvm::FunctionType::get(SupportedPrimitives::INT.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType
+        };
+        TabiCore::HASH_REBUILD.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+        TabiCore::HASH_RESERVE.build.functionType = llvm::FunctionType::get(SupportedPrimitives::INT.common.build.llvmType->getPointerTo(), llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::INT.common.build.llvmType
+        };
+        TabiCore::BTREE_GET_SIZE.build.functionType = llvm::FunctionType::get(SupportedPrimitives::SIZE.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType
+        };
+        TabiCore::BTREE_INIT.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType
+        };
+        TabiCore::BTREE_INSERT.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
             SupportedPrimitives::INT.common.build.llvmType
         };
+        TabiCore::BTREE_REMOVE.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType
+        };
+        TabiCore::BTREE_REBUILD.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+        TabiCore::BTREE_RESERVE.build.functionType = llvm::FunctionType::get(SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(), llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::LONG.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::LONG.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType
+        };
+        TabiCore::BTREE_SEEK.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+        TabiCore::BTREE_NEXT.build.functionType = llvm::FunctionType::get(SupportedPrimitives::INT.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::NONE.common.build.llvmType->getPointerTo()->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::NONE.common.build.llvmType->getPointerTo()->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::NONE.common.build.llvmType->getPointerTo()->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo()
+        };
+        TabiCore::JOIN_HASH.build.functionType = llvm::FunctionType::get(SupportedPrimitives::INT.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::NONE.common.build.llvmType->getPointerTo()->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::NONE.common.build.llvmType->getPointerTo()->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType,
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo(),
+            SupportedPrimitives::INT.common.build.llvmType->getPointerTo()
+        };
+        TabiCore::GROUP_HASH.build.functionType = llvm::FunctionType::get(SupportedPrimitives::INT.common.build.llvmType, llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::SIZE.common.build.llvmType
+        };
         TabiCore::ALLOC.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType->getPointerTo(), llvm::ArrayRef(argTypes), false);
     }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::SIZE.common.build.llvmType
+        };
+        TabiCore::ALLOC_ALIGNED.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType->getPointerTo(), llvm::ArrayRef(argTypes), false);
+    }
     {
         std::vector<llvm::Type*> argTypes = {
             SupportedPrimitives::NONE.common.build.llvmType->getPointerTo()
         };
         TabiCore::DEALLOC.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false); 
     }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::ARENA.common.build.llvmType->getPointerTo(), 
+            SupportedPrimitives::SIZE.common.build.llvmType, SupportedPrimitives::SIZE.common.build.llvmType
+        };
+        TabiCore::ARENA_ALLOC.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType->getPointerTo(), llvm::ArrayRef(argTypes), false);
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::ARENA.common.build.llvmType->getPointerTo()
+        };
+        TabiCore::ARENA_RELEASE.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false); 
+    }
+    {
+        TabiCore::STATS_REPORT.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, false); 
+    }
+    {
+        std::vector<llvm::Type*> argTypes = {
+            SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(), SupportedPrimitives::LONG.common.build.llvmType->getPointerTo()
+        };
+        TabiCore::STATS_REPORT_TABLE.build.functionType = llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType, llvm::ArrayRef(argTypes), false); 
+    }
     {
         llvm::Type* int_type = SupportedPrimitives::INT.common.build.llvmType; 
         std::vector<llvm::Type*> argTypes = {
@@ -173,6 +402,39 @@ void tabic::buildBundle(Bundle* bundle)
         builder.SetInsertPoint(bundle->build.initExit); 
         builder.CreateRetVoid();
         builder.SetInsertPoint(bundle->build.destroyEntry); 
+        //Reports the counters of each context table, when built with `--profile-tables`. 
+        if(Util::flags.at("profile-tables"))
+        {
+            Slab* rootSlab = bundle->create.rootSlab; 
+            llvm::FunctionCallee coreStatsReportTable = rootSlab->build.llvmModule->getOrInsertFunction(
+                    TabiCore::STATS_REPORT_TABLE.create.name, TabiCore::STATS_REPORT_TABLE.build.functionType); 
+            for(auto pair : bundle->create.slabs)
+            {
+                for(auto pair : pair.second->create.contexts)
+                {
+                    for(auto pair : pair.second->parse.members)
+                    {
+                        ContextVariable* variable = pair.second; 
+                        if(variable->common.parse.type->common.typeClass != TYPE_TABLE) continue; 
+                        std::vector<llvm::Value*> offsets = {
+                            llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
+                            llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0))
+                        }; 
+                        std::vector<llvm::Value*> args = {
+                            builder.CreateGlobalStringPtr(variable->build.fullName), 
+                            builder.CreateGEP(
+                                    llvm::ArrayType::get(SupportedPrimitives::LONG.common.build.llvmType, TableType::PROFILE_NUM_COUNTERS),
+                                    buildTableProfileStore(variable, rootSlab), llvm::ArrayRef(offsets))
+                        }; 
+                        builder.CreateCall(coreStatsReportTable, llvm::ArrayRef(args)); 
+                    }
+                }
+            }
+        }
+        //Reports the program's allocations, when the TABI_ALLOC_STATS environment variable asks for it. 
+        llvm::FunctionCallee coreStatsReport = bundle->create.rootSlab->build.llvmModule->getOrInsertFunction(
+                TabiCore::STATS_REPORT.create.name, TabiCore::STATS_REPORT.build.functionType); 
+        builder.CreateCall(coreStatsReport); 
         builder.CreateRetVoid();
     }
     //Register all Function.
@@ -185,17 +447,18 @@ void tabic::buildBundle(Bundle* bundle)
             registerFunction(function);
         }
     }
-    //Build all Function.
-    for(auto pair : bundle->create.slabs)
+}
+
+void tabic::buildSlabFunctions(Slab* slab)
+{
+    //Functions only add to the Module of their own Slab (references to other slabs are declared by name), 
+    //so the Slab is complete once its own functions are built. 
+    for(auto pair : slab->create.functions)
     {
-        Slab* slab = pair.second;
-        for(auto pair : slab->create.functions)
-        {
-            Function* function = pair.second;
-            if(function->common.functionClass == FUNCTION_TABITHA) buildTabithaFunction((TabithaFunction*) function);
-            //NOTE: ExternalFunction is not built in the sense meant here. 
-            //This is because by defnition they are given elsewhere. 
-        }
+        Function* function = pair.second;
+        if(function->common.functionClass == FUNCTION_TABITHA) buildTabithaFunction((TabithaFunction*) function);
+        //NOTE: ExternalFunction is not built in the sense meant here. 
+        //This is because by defnition they are given elsewhere. 
     }
 }
 
@@ -234,11 +497,22 @@ void tabic::buildType(Type* type)
     {
         buildExpression(type->table.parse.numRows);
         std::vector<llvm::Type*> llvmFieldTypes = {}; 
+        std::vector<llvm::Type*> llvmRecordTypes = {}; 
         for(TableField &field : type->table.parse.fields)
         {
             buildType(field.type); 
             llvmFieldTypes.push_back(field.type->common.build.llvmType->getPointerTo());
+            if(llvmFieldTypes.size() > TableType::NUM_META_FIELDS) llvmRecordTypes.push_back(field.type->common.build.llvmType); 
+        }
+        //A row major table points to its records in place of its first user field. 
+        if(type->table.parse.rowMajor)
+        {
+            type->table.build.recordType = llvm::StructType::get(llvmContext, llvm::ArrayRef(llvmRecordTypes)); 
+            llvmFieldTypes[TableType::NUM_META_FIELDS] = type->table.build.recordType->getPointerTo(); 
         }
+        //The pointers to the hash indexes follow the fields, and the pointers to the ordered indexes follow those. 
+        llvmFieldTypes.insert(llvmFieldTypes.end(), type->table.parse.indexedFields.size(), SupportedPrimitives::INT.common.build.llvmType->getPointerTo()); 
+        llvmFieldTypes.insert(llvmFieldTypes.end(), type->table.parse.orderedFields.size(), SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo()); 
         type->common.build.llvmType = llvm::StructType::get(llvmContext, llvm::ArrayRef(llvmFieldTypes));
     }
     else if(typeClass == TYPE_ALIAS)
@@ -277,6 +551,14 @@ void tabic::buildBlock(Block* block)
             {
                 allocateStackTableFields(statement->localDeclaration.parse.variable->common.parse.type, block->common.parse.hostFunction, statement->localDeclaration.parse.variable->common.build.llvmStore); 
             }
+            else if(isArenaType(statement->localDeclaration.parse.variable->common.parse.type)
+                    && !statement->localDeclaration.parse.initialiser)
+            {
+                //An Arena holds nothing until the first allocation into it. 
+                builder.CreateStore(
+                        llvm::ConstantPointerNull::get((llvm::PointerType*) SupportedPrimitives::ARENA.common.build.llvmType), 
+                        statement->localDeclaration.parse.variable->common.build.llvmStore); 
+            }
             if(statement->localDeclaration.parse.initialiser)
             {
                 buildExpression(statement->localDeclaration.parse.initialiser); 
@@ -306,9 +588,19 @@ void tabic::buildBlock(Block* block)
             TypeClass typeClass = type->common.typeClass;
             if(typeClass == TYPE_PRIMITIVE | typeClass == TYPE_COLLECTION | typeClass == TYPE_ADDRESS)
             {
+                //A row which moves to a new key must be moved in the field's hash or ordered index. 
+                ValueRef* ref = statement->assignment.parse.ref; 
+                bool indexed = ref->common.valueRefClass == VALUE_REF_ROW 
+                    && (ref->common.parse.parent->common.parse.type->table.parse.fields[ref->row.parse.fieldIndex].indexed
+                        || ref->common.parse.parent->common.parse.type->table.parse.fields[ref->row.parse.fieldIndex].ordered); 
+                Slab* hostSlab = block->common.parse.hostFunction->create.hostSlab;
+                if(indexed) buildTableKeyIndexUpdate(ref->common.parse.parent->common.parse.type, ref->common.parse.parent->common.build.llvmStore, 
+                        hostSlab, ref->row.build.row, false, ref->row.parse.fieldIndex); 
                 builder.CreateStore(
                         statement->assignment.parse.expression->common.build.llvmValue, 
                         statement->assignment.parse.ref->common.build.llvmStore); 
+                if(indexed) buildTableKeyIndexUpdate(ref->common.parse.parent->common.parse.type, ref->common.parse.parent->common.build.llvmStore, 
+                        hostSlab, ref->row.build.row, true, ref->row.parse.fieldIndex); 
             }
             else if(typeClass == TYPE_VECTOR)
             {
@@ -318,8 +610,8 @@ void tabic::buildBlock(Block* block)
                     llvm::DataLayout dl = block->common.parse.hostFunction->create.hostSlab->build.llvmModule->getDataLayout();
                     llvm::Value* arrayStore = builder.CreateLoad(type->common.build.llvmType, statement->assignment.parse.ref->common.build.llvmStore); 
                     numBytes = builder.CreateMul(
-                            numBytes,
-                            llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, dl.getTypeAllocSize(type->vector.parse.elemType->common.build.llvmType))));
+                            buildSizeCast(numBytes),
+                            llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, dl.getTypeAllocSize(type->vector.parse.elemType->common.build.llvmType)));
                     builder.CreateMemCpy(
                             arrayStore, llvm::MaybeAlign{}, 
                             statement->assignment.parse.expression->common.build.llvmValue, llvm::MaybeAlign{},
@@ -346,7 +638,9 @@ void tabic::buildBlock(Block* block)
             llvm::FunctionCallee callee = hostSlab->build.llvmModule->getOrInsertFunction(
                     statement->procedureCall.parse.callee->common.build.fullName,
                     statement->procedureCall.parse.callee->common.build.llvmFunction->getFunctionType());
-            builder.CreateCall(callee, llvm::ArrayRef(llvmArgs));
+            //The call and declaration must match the calling convention of the definition, or the optimiser takes the call to be undefined. 
+            llvm::cast<llvm::Function>(callee.getCallee())->setCallingConv(TABITHA_CALLING_CONVENTION); 
+            builder.CreateCall(callee, llvm::ArrayRef(llvmArgs))->setCallingConv(TABITHA_CALLING_CONVENTION);
         }
         else if(statementClass == STATEMENT_CONDITIONAL)
         {
@@ -380,6 +674,22 @@ void tabic::buildBlock(Block* block)
         {
             buildTableCrunch((TableCrunch*) statement); 
         }
+        else if(statementClass == STATEMENT_TABLE_SCAN)
+        {
+            buildTableScan((TableScan*) statement); 
+        }
+        else if(statementClass == STATEMENT_TABLE_SELECT)
+        {
+            buildTableSelect((TableSelect*) statement); 
+        }
+        else if(statementClass == STATEMENT_TABLE_JOIN)
+        {
+            buildTableJoin((TableJoin*) statement); 
+        }
+        else if(statementClass == STATEMENT_TABLE_GROUP)
+        {
+            buildTableGroup((TableGroup*) statement); 
+        }
         else if(statementClass == STATEMENT_LABEL)
         {
             buildLabel((Label*) statement);
@@ -388,6 +698,10 @@ void tabic::buildBlock(Block* block)
         {
             buildUnheap((Unheap*) statement); 
         }
+        else if(statementClass == STATEMENT_UNHEAP_ARENA)
+        {
+            buildUnheapArena((UnheapArena*) statement); 
+        }
         else if(statementClass == STATEMENT_BLOCK)
         {
             buildBlock((Block*) statement); 
@@ -418,6 +732,24 @@ void tabic::buildTableInsert(TableInsert* tableInsert)
 {
     buildValueRef(tableInsert->parse.tableRef, nullptr);
     if(tableInsert->parse.idRef) buildValueRef(tableInsert->parse.idRef, nullptr);
+    Slab* hostSlab = tableInsert->common.parse.hostFunction->create.hostSlab;
+    Type* type = tableInsert->parse.tableRef->common.parse.type; 
+    llvm::Value* numRows = buildTableNumRows(type, tableInsert->parse.tableRef->common.build.llvmStore); 
+    //A growable table is made to have a free row before inserting. 
+    if(type->table.parse.growable)
+    {
+        std::vector<llvm::Value*> args = {
+            tableInsert->parse.tableRef->common.build.llvmStore,
+            numRows,
+            llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, getTableMaxRows(type))),
+            llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, 
+                    llvm::APInt(32, getTableNumArrays(type))),
+            buildTableFieldSizes(type, hostSlab)
+        };
+        llvm::FunctionCallee coreTableReserve = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::TABLE_RESERVE.create.name, TabiCore::TABLE_RESERVE.build.functionType); 
+        numRows = builder.CreateCall(coreTableReserve, llvm::ArrayRef(args)); 
+        buildTableKeyIndexReserve(type, tableInsert->parse.tableRef->common.build.llvmStore, hostSlab, numRows); 
+    }
     //First get the relevant row. 
     llvm::Value* row; 
     {
@@ -426,7 +758,7 @@ void tabic::buildTableInsert(TableInsert* tableInsert)
         {
             args = {
                 tableInsert->parse.tableRef->common.build.llvmStore,
-                tableInsert->parse.tableRef->common.parse.type->table.parse.numRows->common.build.llvmValue,
+                numRows,
                 tableInsert->parse.idRef->common.build.llvmStore
             };
         }
@@ -434,51 +766,47 @@ void tabic::buildTableInsert(TableInsert* tableInsert)
         {   
             args = {
                 tableInsert->parse.tableRef->common.build.llvmStore,
-                tableInsert->parse.tableRef->common.parse.type->table.parse.numRows->common.build.llvmValue,
+                numRows,
                 llvm::Constant::getNullValue(SupportedPrimitives::INT.common.build.llvmType->getPointerTo())
             };
         }
-        Slab* hostSlab = tableInsert->common.parse.hostFunction->create.hostSlab;
         llvm::FunctionCallee coreTableInsert = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::TABLE_INSERT.create.name, TabiCore::TABLE_INSERT.build.functionType); 
         row = builder.CreateCall(coreTableInsert, llvm::ArrayRef(args)); 
     }
+    //A full table gives -1, which counts as a failed insert, and leaves the table as it was. 
+    llvm::Value* inserted = builder.CreateICmpSGE(row, llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0))); 
+    buildTableProfileCount(tableInsert->parse.tableRef, TableType::PROFILE_INSERTS); 
+    buildTableProfileCount(tableInsert->parse.tableRef, TableType::PROFILE_FAILED_INSERTS, builder.CreateZExt(
+            builder.CreateNot(inserted), SupportedPrimitives::LONG.common.build.llvmType)); 
+    llvm::Function* llvmFunction = tableInsert->common.parse.hostFunction->common.build.llvmFunction; 
+    llvm::BasicBlock* insertStore = llvm::BasicBlock::Create(llvmContext, "insert_store", llvmFunction); 
+    llvm::BasicBlock* insertEnd = llvm::BasicBlock::Create(llvmContext, "insert_end", llvmFunction); 
+    builder.CreateCondBr(inserted, insertStore, insertEnd); 
+    builder.SetInsertPoint(insertStore); 
     //Then update table elements. 
     ValueRef* tableRef = tableInsert->parse.tableRef; 
     TableType* tableType = (TableType*) tableInsert->parse.tableRef->common.parse.type; 
-    for(int fieldIndex = 2; fieldIndex < tableType->parse.fields.size(); fieldIndex++)
+    for(int fieldIndex = TableType::NUM_META_FIELDS; fieldIndex < tableType->parse.fields.size(); fieldIndex++)
     {
         TableField &field = tableType->parse.fields[fieldIndex]; 
-        //Get the field store
-        llvm::Value* fieldStore; 
-        {
-            std::vector<llvm::Value*> offsets = {
-                llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
-                llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, fieldIndex))
-            };
-            fieldStore = builder.CreateGEP(tableType->common.build.llvmType, tableRef->common.build.llvmStore, llvm::ArrayRef(offsets)); 
-        }
-        //Get the array store
-        llvm::Value* arrayStore = builder.CreateLoad(tableType->parse.fields[fieldIndex].type->common.build.llvmType->getPointerTo(), fieldStore);
         //Get the element store
-        llvm::Value* elemStore; 
-        {
-            std::vector<llvm::Value*> offsets = {
-                row
-            };
-            elemStore = builder.CreateGEP(field.type->common.build.llvmType, arrayStore, llvm::ArrayRef(offsets)); 
-        }
+        llvm::Value* elemStore = buildTableElementStore((Type*) tableType, tableRef->common.build.llvmStore, fieldIndex, row); 
         //Store the value if given. 
         //Otherwise store null
-        if(tableInsert->parse.elements[fieldIndex-2])
+        if(tableInsert->parse.elements[fieldIndex - TableType::NUM_META_FIELDS])
         {
-            buildExpression(tableInsert->parse.elements[fieldIndex-2]); 
-            builder.CreateStore(tableInsert->parse.elements[fieldIndex-2]->common.build.llvmValue, elemStore);
+            buildExpression(tableInsert->parse.elements[fieldIndex - TableType::NUM_META_FIELDS]); 
+            builder.CreateStore(tableInsert->parse.elements[fieldIndex - TableType::NUM_META_FIELDS]->common.build.llvmValue, elemStore);
         }
         else
         {
             builder.CreateStore(llvm::Constant::getNullValue(field.type->common.build.llvmType), elemStore);
         }
     }
+    //The keys are only read once stored. 
+    buildTableKeyIndexUpdate(type, tableRef->common.build.llvmStore, hostSlab, row, true); 
+    builder.CreateBr(insertEnd); 
+    builder.SetInsertPoint(insertEnd); 
 }
 
 void tabic::buildTabithaFunction(TabithaFunction* function)
@@ -570,9 +898,9 @@ llvm::Value* tabic::copyVector(Type* type, llvm::Value* arg, TabithaFunction* ho
     llvm::Value* arrayStore = builder.CreateAlloca(type->vector.parse.elemType->common.build.llvmType, type->vector.parse.numElem->common.build.llvmValue); 
     //vectors are passed to the function by their address in memory
     //and by default we create a copy of the vector to be used as a stacked variable
-    llvm::Value* copySize = type->vector.parse.numElem->common.build.llvmValue; 
-    copySize = builder.CreateMul(copySize, llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, 
-                llvm::APInt(32, dl.getTypeAllocSize(type->vector.parse.elemType->common.build.llvmType))));  
+    llvm::Value* copySize = buildSizeCast(type->vector.parse.numElem->common.build.llvmValue); 
+    copySize = builder.CreateMul(copySize, llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, 
+                dl.getTypeAllocSize(type->vector.parse.elemType->common.build.llvmType)));  
     builder.CreateMemCpy(arrayStore, llvm::MaybeAlign{}, arg, llvm::MaybeAlign{}, copySize); 
     builder.CreateStore(arrayStore, store); 
     //TODO implement deeper copying
@@ -785,70 +1113,350 @@ llvm::Value* tabic::allocateStackVectorElements(Type* type, TabithaFunction* hos
     return arrayStore; 
 } 
 
-void tabic::allocateStackTableFields(Type* type, TabithaFunction* hostFunction, llvm::Value* store)
+llvm::Value* tabic::buildSizeCast(llvm::Value* count)
 {
-    int fieldIndex = 0; 
-    for(TableField &field : type->table.parse.fields)
+    return builder.CreateSExtOrTrunc(count, SupportedPrimitives::SIZE.common.build.llvmType); 
+}
+
+llvm::Value* tabic::buildTableFieldLength(Type* type, int fieldIndex)
+{
+    llvm::Value* numRows = buildSizeCast(type->table.parse.numRows->common.build.llvmValue);
+    std::string name = type->table.parse.fields[fieldIndex].name; 
+    //The #use field is a bitmap with one bit per row.
+    if(name == "#use") 
     {
-        llvm::Value* fieldAlloc = builder.CreateAlloca(field.type->common.build.llvmType, type->table.parse.numRows->common.build.llvmValue); 
-        llvm::Value* fieldStore;
-        {
-            std::vector<llvm::Value*> offsets = { 
-                llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
-                llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, fieldIndex))
-            };
-            fieldStore = builder.CreateGEP(
-                    type->common.build.llvmType, 
-                    store, 
-                    llvm::ArrayRef(offsets)); 
-        }
-        builder.CreateStore(fieldAlloc, fieldStore); 
-        fieldIndex++; 
+        llvm::Value* bits = llvm::ConstantInt::get(numRows->getType(), 31); 
+        return builder.CreateUDiv(builder.CreateAdd(numRows, bits), llvm::ConstantInt::get(numRows->getType(), 32)); 
     }
-    //Call the core_table_init function
+    //The #index field holds a header, the id index and the free id stack. 
+    if(name == "#index") 
     {
-        std::vector<llvm::Value*> args = {
-            store, type->table.parse.numRows->common.build.llvmValue
-        }; 
-        Slab* hostSlab = hostFunction->create.hostSlab;
-        llvm::FunctionCallee coreTableInit = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::TABLE_INIT.create.name, TabiCore::TABLE_INIT.build.functionType); 
-        builder.CreateCall(coreTableInit, llvm::ArrayRef(args)); 
+        llvm::Value* header = llvm::ConstantInt::get(numRows->getType(), TableType::INDEX_HEADER_SIZE); 
+        return builder.CreateAdd(builder.CreateAdd(numRows, numRows), header); 
     }
+    return numRows; 
 }
 
-void tabic::allocateStackSubvectors(CollectionType* collectionType, llvm::Value* store, TabithaFunction* hostFunction)
+llvm::Value* tabic::buildTableNumRows(Type* type, llvm::Value* store)
 {
-    for(auto pair : collectionType->parse.members)
-    {
-        CollectionMember &member = pair.second;
-        Type* memberType = member.type;
-        std::vector<llvm::Value*> offsets = {
-            llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
-            llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, member.index))
-        };
-        llvm::Value* memberStore = builder.CreateGEP(collectionType->common.build.llvmType, store, llvm::ArrayRef(offsets));
-        if(memberType->common.typeClass == TYPE_VECTOR)
-        {
-            llvm::Value* vecStore = allocateStackType(memberType, hostFunction);  
-            llvm::Value* vec      = builder.CreateLoad(memberType->common.build.llvmType, vecStore); 
-            builder.CreateStore(vec, memberStore); 
-        }
-        else if(memberType->common.typeClass == TYPE_TABLE)
-        {
-            llvm::Value* tableStore = allocateStackType(memberType, hostFunction); 
-            llvm::Value* table = builder.CreateLoad(memberType->common.build.llvmType, tableStore); 
-            builder.CreateStore(table, memberStore); 
-        }
-        else if(memberType->common.typeClass == TYPE_COLLECTION)
-        {
-            allocateStackSubvectors((CollectionType*) memberType, memberStore, hostFunction);
-        }
-    }
+    if(!type->table.parse.growable) return type->table.parse.numRows->common.build.llvmValue; 
+    std::vector<llvm::Value*> offsets = {
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 2))
+    };
+    llvm::Value* indexField = builder.CreateLoad(SupportedPrimitives::INT.common.build.llvmType->getPointerTo(), 
+            builder.CreateGEP(type->common.build.llvmType, store, llvm::ArrayRef(offsets))); 
+    offsets = { llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, TableType::INDEX_NUM_ROWS)) }; 
+    return builder.CreateLoad(SupportedPrimitives::INT.common.build.llvmType, 
+            builder.CreateGEP(SupportedPrimitives::INT.common.build.llvmType, indexField, llvm::ArrayRef(offsets))); 
 }
 
-void tabic::allocateStackVariables(Block* block)
+int tabic::getTableNumArrays(Type* type)
 {
-    //First allocate all stack variables belonging explicitly to this block. 
+    return type->table.parse.rowMajor ? 1 : type->table.parse.fields.size() - TableType::NUM_META_FIELDS; 
+}
+
+int tabic::getTableMaxRows(Type* type)
+{
+    return type->table.parse.indexedFields.empty() ? TableType::MAX_ROWS : TableType::MAX_INDEXED_ROWS; 
+}
+
+llvm::Type* tabic::getTableArrayElemType(Type* type, int fieldIndex)
+{
+    if(type->table.parse.rowMajor && fieldIndex == TableType::NUM_META_FIELDS) return type->table.build.recordType; 
+    return type->table.parse.fields[fieldIndex].type->common.build.llvmType; 
+}
+
+llvm::Value* tabic::buildTableElementStore(Type* type, llvm::Value* store, int fieldIndex, llvm::Value* row)
+{
+    bool inRecord = type->table.parse.rowMajor && fieldIndex >= TableType::NUM_META_FIELDS; 
+    int arrayIndex = inRecord ? TableType::NUM_META_FIELDS : fieldIndex; 
+    llvm::Type* elemType = getTableArrayElemType(type, arrayIndex); 
+    std::vector<llvm::Value*> offsets = {
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, arrayIndex))
+    };
+    llvm::Value* arrayStore = builder.CreateLoad(elemType->getPointerTo(), builder.CreateGEP(type->common.build.llvmType, store, llvm::ArrayRef(offsets))); 
+    offsets = { row }; 
+    if(inRecord) offsets.push_back(llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, fieldIndex - TableType::NUM_META_FIELDS))); 
+    return builder.CreateGEP(elemType, arrayStore, llvm::ArrayRef(offsets)); 
+}
+
+llvm::Value* tabic::buildTableFieldSizes(Type* type, Slab* hostSlab)
+{
+    //The sizes are known when building, so they are kept in a constant of the slab's module, 
+    //in place of an array on the stack which would be built again at each insert, join or group. 
+    int numFields = getTableNumArrays(type);
+    llvm::DataLayout dl = hostSlab->build.llvmModule->getDataLayout();
+    std::vector<llvm::Constant*> sizes; 
+    for(int i = 0; i < numFields; i++)
+    {
+        sizes.push_back(llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, 
+                    llvm::APInt(32, dl.getTypeAllocSize(getTableArrayElemType(type, TableType::NUM_META_FIELDS + i))))); 
+    }
+    llvm::ArrayType* sizesType = llvm::ArrayType::get(SupportedPrimitives::INT.common.build.llvmType, numFields); 
+    llvm::GlobalVariable* fieldSizes = new llvm::GlobalVariable(
+            *hostSlab->build.llvmModule, sizesType,
+            true, llvm::GlobalVariable::PrivateLinkage, llvm::ConstantArray::get(sizesType, llvm::ArrayRef(sizes)),
+            "field_sizes", nullptr, llvm::GlobalVariable::NotThreadLocal); 
+    fieldSizes->setUnnamedAddr(llvm::GlobalValue::UnnamedAddr::Global); 
+    std::vector<llvm::Constant*> offsets = {
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0))
+    };
+    return llvm::ConstantExpr::getInBoundsGetElementPtr(sizesType, fieldSizes, llvm::ArrayRef(offsets)); 
+}
+
+llvm::Value* tabic::buildTableHashStore(Type* type, llvm::Value* store, int hashIndex)
+{
+    std::vector<llvm::Value*> offsets = {
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, type->table.parse.fields.size() + hashIndex))
+    };
+    return builder.CreateGEP(type->common.build.llvmType, store, llvm::ArrayRef(offsets)); 
+}
+
+std::vector<llvm::Value*> tabic::buildTableHashArgs(Type* type, llvm::Value* store, Slab* hostSlab, int hashIndex, bool useField)
+{
+    llvm::Type* intType = SupportedPrimitives::INT.common.build.llvmType; 
+    int fieldIndex = type->table.parse.indexedFields[hashIndex]; 
+    llvm::Type* keyType = type->table.parse.fields[fieldIndex].type->common.build.llvmType; 
+    llvm::DataLayout dl = hostSlab->build.llvmModule->getDataLayout(); 
+    std::vector<llvm::Value*> offsets = {
+        llvm::ConstantInt::get(intType, llvm::APInt(32, 0)),
+        llvm::ConstantInt::get(intType, llvm::APInt(32, fieldIndex))
+    };
+    llvm::Value* field = builder.CreateLoad(keyType->getPointerTo(), builder.CreateGEP(type->common.build.llvmType, store, llvm::ArrayRef(offsets))); 
+    std::vector<llvm::Value*> args = {
+        builder.CreateLoad(intType->getPointerTo(), buildTableHashStore(type, store, hashIndex)),
+        builder.CreateBitCast(field, SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo()),
+        llvm::ConstantInt::get(intType, llvm::APInt(32, dl.getTypeAllocSize(keyType)))
+    };
+    if(useField)
+    {
+        offsets[1] = llvm::ConstantInt::get(intType, llvm::APInt(32, 1)); 
+        args.push_back(builder.CreateLoad(intType->getPointerTo(), builder.CreateGEP(type->common.build.llvmType, store, llvm::ArrayRef(offsets)))); 
+    }
+    return args; 
+}
+
+llvm::Value* tabic::buildTableTreeStore(Type* type, llvm::Value* store, int treeIndex)
+{
+    std::vector<llvm::Value*> offsets = {
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, 
+                llvm::APInt(32, type->table.parse.fields.size() + type->table.parse.indexedFields.size() + treeIndex))
+    };
+    return builder.CreateGEP(type->common.build.llvmType, store, llvm::ArrayRef(offsets)); 
+}
+
+std::vector<llvm::Value*> tabic::buildTableTreeArgs(Type* type, llvm::Value* store, int treeIndex, bool useField)
+{
+    llvm::Type* intType = SupportedPrimitives::INT.common.build.llvmType; 
+    llvm::Type* charPtrType = SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(); 
+    int fieldIndex = type->table.parse.orderedFields[treeIndex]; 
+    llvm::Type* keyType = type->table.parse.fields[fieldIndex].type->common.build.llvmType; 
+    std::vector<llvm::Value*> offsets = {
+        llvm::ConstantInt::get(intType, llvm::APInt(32, 0)),
+        llvm::ConstantInt::get(intType, llvm::APInt(32, fieldIndex))
+    };
+    llvm::Value* field = builder.CreateLoad(keyType->getPointerTo(), builder.CreateGEP(type->common.build.llvmType, store, llvm::ArrayRef(offsets))); 
+    std::vector<llvm::Value*> args = {
+        builder.CreateLoad(charPtrType, buildTableTreeStore(type, store, treeIndex)),
+        builder.CreateBitCast(field, charPtrType)
+    };
+    if(useField)
+    {
+        offsets[1] = llvm::ConstantInt::get(intType, llvm::APInt(32, 1)); 
+        args.push_back(builder.CreateLoad(intType->getPointerTo(), builder.CreateGEP(type->common.build.llvmType, store, llvm::ArrayRef(offsets)))); 
+    }
+    return args; 
+}
+
+void tabic::allocateTableKeyIndexes(Type* type, llvm::Value* store, Slab* hostSlab, bool stacked, llvm::Value* arena)
+{
+    llvm::Type* intType = SupportedPrimitives::INT.common.build.llvmType; 
+    llvm::Type* charType = SupportedPrimitives::CHAR.common.build.llvmType; 
+    llvm::Value* numRows = type->table.parse.numRows->common.build.llvmValue; 
+    llvm::DataLayout dl = hostSlab->build.llvmModule->getDataLayout(); 
+    llvm::FunctionCallee coreHashGetSize = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::HASH_GET_SIZE.create.name, TabiCore::HASH_GET_SIZE.build.functionType); 
+    llvm::FunctionCallee coreHashInit = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::HASH_INIT.create.name, TabiCore::HASH_INIT.build.functionType); 
+    for(int hashIndex = 0; hashIndex < type->table.parse.indexedFields.size(); hashIndex++)
+    {
+        std::vector<llvm::Value*> args = { numRows }; 
+        llvm::Value* size = builder.CreateCall(coreHashGetSize, llvm::ArrayRef(args)); 
+        llvm::Value* hash; 
+        if(stacked) hash = builder.CreateAlloca(intType, size); 
+        else
+        {
+            llvm::Value* numBytes = builder.CreateMul(buildSizeCast(size), llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, dl.getTypeAllocSize(intType))); 
+            hash = builder.CreateBitCast(buildHeapAlloc(hostSlab, numBytes, false, arena), intType->getPointerTo()); 
+        }
+        builder.CreateStore(hash, buildTableHashStore(type, store, hashIndex)); 
+        args = { hash, numRows }; 
+        builder.CreateCall(coreHashInit, llvm::ArrayRef(args)); 
+    }
+    llvm::FunctionCallee coreTreeGetSize = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::BTREE_GET_SIZE.create.name, TabiCore::BTREE_GET_SIZE.build.functionType); 
+    llvm::FunctionCallee coreTreeInit = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::BTREE_INIT.create.name, TabiCore::BTREE_INIT.build.functionType); 
+    for(int treeIndex = 0; treeIndex < type->table.parse.orderedFields.size(); treeIndex++)
+    {
+        llvm::Type* keyType = type->table.parse.fields[type->table.parse.orderedFields[treeIndex]].type->common.build.llvmType; 
+        std::vector<llvm::Value*> args = { numRows }; 
+        llvm::Value* size = builder.CreateCall(coreTreeGetSize, llvm::ArrayRef(args)); 
+        llvm::Value* tree; 
+        if(stacked)
+        {
+            //The nodes hold Long keys, so must be aligned to suit. 
+            llvm::AllocaInst* treeAlloc = builder.CreateAlloca(charType, size); 
+            treeAlloc->setAlignment(llvm::Align(8)); 
+            tree = treeAlloc; 
+        }
+        else
+        {
+            tree = builder.CreateBitCast(buildHeapAlloc(hostSlab, size, false, arena), charType->getPointerTo()); 
+        }
+        builder.CreateStore(tree, buildTableTreeStore(type, store, treeIndex)); 
+        args = { 
+            tree, numRows, 
+            llvm::ConstantInt::get(intType, llvm::APInt(32, dl.getTypeAllocSize(keyType))),
+            llvm::ConstantInt::get(intType, llvm::APInt(32, keyType->isFloatingPointTy() ? 1 : 0))
+        }; 
+        builder.CreateCall(coreTreeInit, llvm::ArrayRef(args)); 
+    }
+}
+
+void tabic::buildTableKeyIndexUpdate(Type* type, llvm::Value* store, Slab* hostSlab, llvm::Value* row, bool insert, int fieldIndex)
+{
+    if(type->table.parse.indexedFields.empty() && type->table.parse.orderedFields.empty()) return; 
+    llvm::Value* numRows = insert ? buildTableNumRows(type, store) : nullptr; 
+    llvm::FunctionCallee coreHashUpdate = insert 
+        ? hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::HASH_INSERT.create.name, TabiCore::HASH_INSERT.build.functionType)
+        : hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::HASH_REMOVE.create.name, TabiCore::HASH_REMOVE.build.functionType); 
+    for(int hashIndex = 0; hashIndex < type->table.parse.indexedFields.size(); hashIndex++)
+    {
+        if(fieldIndex != -1 && type->table.parse.indexedFields[hashIndex] != fieldIndex) continue; 
+        std::vector<llvm::Value*> args = buildTableHashArgs(type, store, hostSlab, hashIndex, insert); 
+        if(insert) args.push_back(numRows); 
+        args.push_back(row); 
+        builder.CreateCall(coreHashUpdate, llvm::ArrayRef(args)); 
+    }
+    llvm::FunctionCallee coreTreeUpdate = insert 
+        ? hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::BTREE_INSERT.create.name, TabiCore::BTREE_INSERT.build.functionType)
+        : hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::BTREE_REMOVE.create.name, TabiCore::BTREE_REMOVE.build.functionType); 
+    for(int treeIndex = 0; treeIndex < type->table.parse.orderedFields.size(); treeIndex++)
+    {
+        if(fieldIndex != -1 && type->table.parse.orderedFields[treeIndex] != fieldIndex) continue; 
+        std::vector<llvm::Value*> args = buildTableTreeArgs(type, store, treeIndex, insert); 
+        if(insert) args.push_back(numRows); 
+        args.push_back(row); 
+        builder.CreateCall(coreTreeUpdate, llvm::ArrayRef(args)); 
+    }
+}
+
+void tabic::buildTableKeyIndexRebuild(Type* type, llvm::Value* store, Slab* hostSlab)
+{
+    if(type->table.parse.indexedFields.empty() && type->table.parse.orderedFields.empty()) return; 
+    llvm::Value* numRows = buildTableNumRows(type, store); 
+    llvm::FunctionCallee coreHashRebuild = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::HASH_REBUILD.create.name, TabiCore::HASH_REBUILD.build.functionType); 
+    for(int hashIndex = 0; hashIndex < type->table.parse.indexedFields.size(); hashIndex++)
+    {
+        std::vector<llvm::Value*> args = buildTableHashArgs(type, store, hostSlab, hashIndex, true); 
+        args.push_back(numRows); 
+        builder.CreateCall(coreHashRebuild, llvm::ArrayRef(args)); 
+    }
+    llvm::FunctionCallee coreTreeRebuild = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::BTREE_REBUILD.create.name, TabiCore::BTREE_REBUILD.build.functionType); 
+    for(int treeIndex = 0; treeIndex < type->table.parse.orderedFields.size(); treeIndex++)
+    {
+        std::vector<llvm::Value*> args = buildTableTreeArgs(type, store, treeIndex, true); 
+        args.push_back(numRows); 
+        builder.CreateCall(coreTreeRebuild, llvm::ArrayRef(args)); 
+    }
+}
+
+void tabic::buildTableKeyIndexReserve(Type* type, llvm::Value* store, Slab* hostSlab, llvm::Value* numRows)
+{
+    llvm::FunctionCallee coreHashReserve = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::HASH_RESERVE.create.name, TabiCore::HASH_RESERVE.build.functionType); 
+    for(int hashIndex = 0; hashIndex < type->table.parse.indexedFields.size(); hashIndex++)
+    {
+        std::vector<llvm::Value*> args = buildTableHashArgs(type, store, hostSlab, hashIndex, true); 
+        args.push_back(numRows); 
+        builder.CreateStore(builder.CreateCall(coreHashReserve, llvm::ArrayRef(args)), buildTableHashStore(type, store, hashIndex)); 
+    }
+    llvm::FunctionCallee coreTreeReserve = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::BTREE_RESERVE.create.name, TabiCore::BTREE_RESERVE.build.functionType); 
+    for(int treeIndex = 0; treeIndex < type->table.parse.orderedFields.size(); treeIndex++)
+    {
+        std::vector<llvm::Value*> args = buildTableTreeArgs(type, store, treeIndex, true); 
+        args.push_back(numRows); 
+        builder.CreateStore(builder.CreateCall(coreTreeReserve, llvm::ArrayRef(args)), buildTableTreeStore(type, store, treeIndex)); 
+    }
+}
+
+void tabic::allocateStackTableFields(Type* type, TabithaFunction* hostFunction, llvm::Value* store)
+{
+    for(int fieldIndex = 0; fieldIndex < type->table.parse.fields.size(); fieldIndex++)
+    {
+        //A row major table has just the one array for the user's fields. 
+        if(type->table.parse.rowMajor && fieldIndex > TableType::NUM_META_FIELDS) break; 
+        llvm::AllocaInst* fieldAlloc = builder.CreateAlloca(getTableArrayElemType(type, fieldIndex), buildTableFieldLength(type, fieldIndex)); 
+        fieldAlloc->setAlignment(llvm::Align(TabiCore::ALIGNMENT)); 
+        llvm::Value* fieldStore;
+        {
+            std::vector<llvm::Value*> offsets = { 
+                llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
+                llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, fieldIndex))
+            };
+            fieldStore = builder.CreateGEP(
+                    type->common.build.llvmType, 
+                    store, 
+                    llvm::ArrayRef(offsets)); 
+        }
+        builder.CreateStore(fieldAlloc, fieldStore); 
+    }
+    //Call the core_table_init function
+    {
+        std::vector<llvm::Value*> args = {
+            store, type->table.parse.numRows->common.build.llvmValue
+        }; 
+        Slab* hostSlab = hostFunction->create.hostSlab;
+        llvm::FunctionCallee coreTableInit = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::TABLE_INIT.create.name, TabiCore::TABLE_INIT.build.functionType); 
+        builder.CreateCall(coreTableInit, llvm::ArrayRef(args)); 
+    }
+    allocateTableKeyIndexes(type, store, hostFunction->create.hostSlab, true); 
+}
+
+void tabic::allocateStackSubvectors(CollectionType* collectionType, llvm::Value* store, TabithaFunction* hostFunction)
+{
+    for(auto pair : collectionType->parse.members)
+    {
+        CollectionMember &member = pair.second;
+        Type* memberType = member.type;
+        std::vector<llvm::Value*> offsets = {
+            llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
+            llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, member.index))
+        };
+        llvm::Value* memberStore = builder.CreateGEP(collectionType->common.build.llvmType, store, llvm::ArrayRef(offsets));
+        if(memberType->common.typeClass == TYPE_VECTOR)
+        {
+            llvm::Value* vecStore = allocateStackType(memberType, hostFunction);  
+            llvm::Value* vec      = builder.CreateLoad(memberType->common.build.llvmType, vecStore); 
+            builder.CreateStore(vec, memberStore); 
+        }
+        else if(memberType->common.typeClass == TYPE_TABLE)
+        {
+            llvm::Value* tableStore = allocateStackType(memberType, hostFunction); 
+            llvm::Value* table = builder.CreateLoad(memberType->common.build.llvmType, tableStore); 
+            builder.CreateStore(table, memberStore); 
+        }
+        else if(memberType->common.typeClass == TYPE_COLLECTION)
+        {
+            allocateStackSubvectors((CollectionType*) memberType, memberStore, hostFunction);
+        }
+    }
+}
+
+void tabic::allocateStackVariables(Block* block)
+{
+    //First allocate all stack variables belonging explicitly to this block. 
     for(auto pair : block->parse.variables)
     {
         Variable* variable = pair.second;
@@ -883,50 +1491,94 @@ void tabic::allocateStackVariables(Block* block)
         {
             allocateStackVariables(statement->loop.parse.directions);
         }
+        else if(statementClass == STATEMENT_TABLE_SCAN)
+        {
+            statement->tableScan.build.rowStore = builder.CreateAlloca(SupportedPrimitives::INT.common.build.llvmType, nullptr, "scan_row"); 
+            if(statement->tableScan.parse.orderFieldIndex != -1)
+            {
+                statement->tableScan.build.cursorStore = builder.CreateAlloca(SupportedPrimitives::LONG.common.build.llvmType, 
+                        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, TableScan::CURSOR_SIZE)), "scan_cursor"); 
+            }
+            allocateStackVariables(statement->tableScan.parse.scope);
+        }
+        else if(statementClass == STATEMENT_TABLE_SELECT)
+        {
+            //The field variables are columns rather than values, so the scope needs no allocations of its own. 
+            statement->tableSelect.build.wordStore = builder.CreateAlloca(SupportedPrimitives::INT.common.build.llvmType, nullptr, "select_word"); 
+            statement->tableSelect.build.countStore = builder.CreateAlloca(SupportedPrimitives::INT.common.build.llvmType, nullptr, "select_count"); 
+            statement->tableSelect.build.bitsStore = builder.CreateAlloca(SupportedPrimitives::INT.common.build.llvmType, nullptr, "select_bits"); 
+        }
+        else if(statementClass == STATEMENT_TABLE_GROUP)
+        {
+            statement->tableGroup.build.rowStore = builder.CreateAlloca(SupportedPrimitives::INT.common.build.llvmType, nullptr, "group_row"); 
+        }
+    }
+}
+
+bool tabic::isArenaType(Type* type)
+{
+    //An alias has taken on the primitive by now, and no other primitive is a pointer. 
+    return type->common.typeClass == TYPE_PRIMITIVE && type->common.build.llvmType == SupportedPrimitives::ARENA.common.build.llvmType; 
+}
+
+llvm::Value* tabic::buildHeapAlloc(Slab* hostSlab, llvm::Value* numBytes, bool aligned, llvm::Value* arena)
+{
+    llvm::Module* llvmModule = hostSlab->build.llvmModule; 
+    if(arena)
+    {
+        llvm::FunctionCallee coreArenaAlloc = llvmModule->getOrInsertFunction(TabiCore::ARENA_ALLOC.create.name, TabiCore::ARENA_ALLOC.build.functionType); 
+        std::vector<llvm::Value*> args = { 
+            arena, numBytes, 
+            llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, aligned ? TabiCore::ALIGNMENT : TabiCore::HEAP_ALIGNMENT)
+        }; 
+        return builder.CreateCall(coreArenaAlloc, llvm::ArrayRef(args)); 
     }
+    CoreFunction &alloc = aligned ? TabiCore::ALLOC_ALIGNED : TabiCore::ALLOC; 
+    llvm::FunctionCallee coreAlloc = llvmModule->getOrInsertFunction(alloc.create.name, alloc.build.functionType); 
+    std::vector<llvm::Value*> args = { numBytes }; 
+    return builder.CreateCall(coreAlloc, llvm::ArrayRef(args)); 
 }
 
-llvm::Value* tabic::allocateHeapType(Type* type, TabithaFunction* hostFunction, std::string name)
+llvm::Value* tabic::allocateHeapType(Type* type, TabithaFunction* hostFunction, std::string name, llvm::Value* arena)
 {
     Slab* hostSlab = hostFunction->create.hostSlab;
-    llvm::FunctionCallee coreAlloc = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::ALLOC.create.name, TabiCore::ALLOC.build.functionType); 
     buildType(type); 
     TypeClass typeClass = type->common.typeClass;
     llvm::DataLayout dl = hostSlab->build.llvmModule->getDataLayout(); 
     llvm::Value* store;
     if(typeClass == TYPE_PRIMITIVE)
     {
-        std::vector<llvm::Value*> args = { llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, 
-                llvm::APInt(32, dl.getTypeAllocSize(type->common.build.llvmType))) }; 
-        store = builder.CreateCall(coreAlloc, llvm::ArrayRef(args));  
+        llvm::Value* numBytes = llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, 
+                dl.getTypeAllocSize(type->common.build.llvmType)); 
+        store = buildHeapAlloc(hostSlab, numBytes, false, arena);  
     }
     else if(typeClass == TYPE_COLLECTION)
     {
-        std::vector<llvm::Value*> args = { llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, dl.getTypeAllocSize(type->common.build.llvmType))) }; 
-        store = builder.CreateCall(coreAlloc, llvm::ArrayRef(args));  
-        allocateHeapSubvectors((CollectionType*) type, store, hostFunction);
+        llvm::Value* numBytes = llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, dl.getTypeAllocSize(type->common.build.llvmType)); 
+        store = buildHeapAlloc(hostSlab, numBytes, false, arena);  
+        allocateHeapSubvectors((CollectionType*) type, store, hostFunction, arena);
     }
     else if(typeClass == TYPE_ADDRESS)
     {
-        std::vector<llvm::Value*> args = { llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, dl.getTypeAllocSize(type->common.build.llvmType))) }; 
-        store = builder.CreateCall(coreAlloc, llvm::ArrayRef(args));  
+        llvm::Value* numBytes = llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, dl.getTypeAllocSize(type->common.build.llvmType)); 
+        store = buildHeapAlloc(hostSlab, numBytes, false, arena);  
     }
     else if(typeClass == TYPE_VECTOR)
     {
         Type* elemType = type->vector.parse.elemType; 
         //allocate the pointer storage 
         {
-            std::vector<llvm::Value*> args = { llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, dl.getTypeAllocSize(type->common.build.llvmType))) }; 
-            store = builder.CreateCall(coreAlloc, llvm::ArrayRef(args));  
+            llvm::Value* numBytes = llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, dl.getTypeAllocSize(type->common.build.llvmType)); 
+            store = buildHeapAlloc(hostSlab, numBytes, false, arena);  
         }
         //allocate element storage
         if(type->vector.parse.numElem)
         {
                 buildExpression(type->vector.parse.numElem); 
-                llvm::Value* elemSize = llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, dl.getTypeAllocSize(elemType->common.build.llvmType)));
-                llvm::Value* vecSize  = builder.CreateMul(elemSize, type->vector.parse.numElem->common.build.llvmValue); 
-                std::vector<llvm::Value*> args = { vecSize };
-                llvm::Value* arrayStore = builder.CreateCall(coreAlloc, llvm::ArrayRef(args));  
+                llvm::Value* elemSize = llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, dl.getTypeAllocSize(elemType->common.build.llvmType));
+                llvm::Value* vecSize  = builder.CreateMul(elemSize, buildSizeCast(type->vector.parse.numElem->common.build.llvmValue)); 
+                //Element arrays are aligned, so that scans over them start on a cache line. 
+                llvm::Value* arrayStore = buildHeapAlloc(hostSlab, vecSize, true, arena);  
                 builder.CreateStore(arrayStore, store); 
                 //ensure that vector-like elements are allocated properly
                 if(type->vector.parse.elemType->common.typeClass == TYPE_VECTOR)
@@ -948,7 +1600,7 @@ llvm::Value* tabic::allocateHeapType(Type* type, TabithaFunction* hostFunction,
                     llvm::BasicBlock* subVecAllocElem = llvm::BasicBlock::Create(
                             llvmContext, "subvec_alloc_elem", hostFunction->common.build.llvmFunction); 
                     builder.SetInsertPoint(subVecAllocElem); 
-                    llvm::Value* elemAlloc = allocateHeapType(type->vector.parse.elemType, hostFunction); 
+                    llvm::Value* elemAlloc = allocateHeapType(type->vector.parse.elemType, hostFunction, "", arena); 
                     llvm::Value* elem = builder.CreateLoad(type->vector.parse.elemType->common.build.llvmType, elemAlloc); 
                     llvm::Value* offsets = { index }; 
                     llvm::Value* elemStore = builder.CreateGEP(type->vector.parse.elemType->common.build.llvmType, arrayStore, llvm::ArrayRef(offsets));
@@ -982,7 +1634,7 @@ llvm::Value* tabic::allocateHeapType(Type* type, TabithaFunction* hostFunction,
                    builder.SetInsertPoint(subVecAllocElem); 
                    llvm::Value* offsets = { index }; 
                    llvm::Value* elemStore = builder.CreateGEP(type->vector.parse.elemType->common.build.llvmType, arrayStore, llvm::ArrayRef(offsets));
-                   allocateHeapSubvectors((CollectionType*)type->vector.parse.elemType, elemStore, hostFunction);
+                   allocateHeapSubvectors((CollectionType*)type->vector.parse.elemType, elemStore, hostFunction, arena);
                    builder.CreateStore(builder.CreateAdd(index, llvm::ConstantInt::get(int_type, llvm::APInt(32, 1))), indexStore); 
                    builder.CreateBr(subVecCondition);
                    llvm::BasicBlock* subVecAllocEnd = llvm::BasicBlock::Create(llvmContext, "subvec_alloc_end", hostFunction->common.build.llvmFunction); 
@@ -994,15 +1646,14 @@ llvm::Value* tabic::allocateHeapType(Type* type, TabithaFunction* hostFunction,
     }
     else if(typeClass == TYPE_TABLE)
     {
-        std::vector<llvm::Value*> args = { llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, dl.getTypeAllocSize(type->common.build.llvmType))) }; 
-        store = builder.CreateCall(coreAlloc, llvm::ArrayRef(args));  
+        llvm::Value* numBytes = llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, dl.getTypeAllocSize(type->common.build.llvmType)); 
+        store = buildHeapAlloc(hostSlab, numBytes, false, arena);  
         for(int fieldIndex = 0; fieldIndex < type->table.parse.fields.size(); fieldIndex++)
         {
-            TableField &field = type->table.parse.fields[fieldIndex];
-            llvm::Value* elemSize = llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, dl.getTypeAllocSize(field.type->common.build.llvmType)));
-            llvm::Value* fieldSize = builder.CreateMul(type->table.parse.numRows->common.build.llvmValue, elemSize);  
-            std::vector<llvm::Value*> args = { fieldSize } ;
-            llvm::Value* fieldAlloc = builder.CreateCall(coreAlloc, llvm::ArrayRef(args)); 
+            if(type->table.parse.rowMajor && fieldIndex > TableType::NUM_META_FIELDS) break; 
+            llvm::Value* elemSize = llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, dl.getTypeAllocSize(getTableArrayElemType(type, fieldIndex)));
+            llvm::Value* fieldSize = builder.CreateMul(buildTableFieldLength(type, fieldIndex), elemSize);  
+            llvm::Value* fieldAlloc = buildHeapAlloc(hostSlab, fieldSize, true, arena); 
             std::vector<llvm::Value*> offsets = {
                 llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
                 llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, fieldIndex))
@@ -1010,6 +1661,15 @@ llvm::Value* tabic::allocateHeapType(Type* type, TabithaFunction* hostFunction,
             llvm::Value* fieldStore = builder.CreateGEP(type->common.build.llvmType, store, llvm::ArrayRef(offsets)); 
             builder.CreateStore(fieldAlloc, fieldStore); 
         }
+        //Call the core_table_init function
+        {
+            std::vector<llvm::Value*> args = {
+                store, type->table.parse.numRows->common.build.llvmValue
+            }; 
+            llvm::FunctionCallee coreTableInit = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::TABLE_INIT.create.name, TabiCore::TABLE_INIT.build.functionType); 
+            builder.CreateCall(coreTableInit, llvm::ArrayRef(args)); 
+        }
+        allocateTableKeyIndexes(type, store, hostSlab, false, arena); 
     }
     return store;
 }
@@ -1017,11 +1677,11 @@ llvm::Value* tabic::allocateHeapType(Type* type, TabithaFunction* hostFunction,
 void tabic::allocateContextType(Type* type, Slab* hostSlab, llvm::Value* contextStore, std::string name)
 {
     Bundle* hostBundle = hostSlab->create.hostBundle;
-    llvm::FunctionCallee coreAlloc = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::ALLOC.create.name, TabiCore::ALLOC.build.functionType); 
+    //Element arrays are aligned, so that scans over them start on a cache line. 
+    llvm::FunctionCallee coreAllocAligned = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::ALLOC_ALIGNED.create.name, TabiCore::ALLOC_ALIGNED.build.functionType); 
     buildType(type); 
     TypeClass typeClass = type->common.typeClass;
     llvm::DataLayout dl = hostSlab->build.llvmModule->getDataLayout(); 
-    llvm::Value* store;
     if(typeClass == TYPE_COLLECTION)
     {
         allocateContextSubvectors((CollectionType*) type, contextStore, hostSlab);
@@ -1029,19 +1689,14 @@ void tabic::allocateContextType(Type* type, Slab* hostSlab, llvm::Value* context
     else if(typeClass == TYPE_VECTOR)
     {
         Type* elemType = type->vector.parse.elemType; 
-        //allocate the pointer storage 
-        {
-            std::vector<llvm::Value*> args = { llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, dl.getTypeAllocSize(type->common.build.llvmType))) }; 
-            store = builder.CreateCall(coreAlloc, llvm::ArrayRef(args));  
-        }
         //allocate element storage
         if(type->vector.parse.numElem)
         {
                 buildExpression(type->vector.parse.numElem); 
-                llvm::Value* elemSize = llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, dl.getTypeAllocSize(elemType->common.build.llvmType)));
-                llvm::Value* vecSize  = builder.CreateMul(elemSize, type->vector.parse.numElem->common.build.llvmValue); 
+                llvm::Value* elemSize = llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, dl.getTypeAllocSize(elemType->common.build.llvmType));
+                llvm::Value* vecSize  = builder.CreateMul(elemSize, buildSizeCast(type->vector.parse.numElem->common.build.llvmValue)); 
                 std::vector<llvm::Value*> args = { vecSize };
-                llvm::Value* arrayStore = builder.CreateCall(coreAlloc, llvm::ArrayRef(args));  
+                llvm::Value* arrayStore = builder.CreateCall(coreAllocAligned, llvm::ArrayRef(args));  
                 builder.CreateStore(arrayStore, contextStore); 
                 //ensure that vector-like elements are allocated properly
                 if(type->vector.parse.elemType->common.typeClass == TYPE_VECTOR)
@@ -1107,15 +1762,13 @@ void tabic::allocateContextType(Type* type, Slab* hostSlab, llvm::Value* context
     }
     else if(typeClass == TYPE_TABLE)
     {
-        //std::vector<llvm::Value*> args = { llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, dl.getTypeAllocSize(type->common.build.llvmType))) }; 
-        //store = builder.CreateCall(coreAlloc, llvm::ArrayRef(args));  
         for(int fieldIndex = 0; fieldIndex < type->table.parse.fields.size(); fieldIndex++)
         {
-            TableField &field = type->table.parse.fields[fieldIndex];
-            llvm::Value* elemSize = llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, dl.getTypeAllocSize(field.type->common.build.llvmType)));
-            llvm::Value* fieldSize = builder.CreateMul(type->table.parse.numRows->common.build.llvmValue, elemSize);  
+            if(type->table.parse.rowMajor && fieldIndex > TableType::NUM_META_FIELDS) break; 
+            llvm::Value* elemSize = llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, dl.getTypeAllocSize(getTableArrayElemType(type, fieldIndex)));
+            llvm::Value* fieldSize = builder.CreateMul(buildTableFieldLength(type, fieldIndex), elemSize);  
             std::vector<llvm::Value*> args = { fieldSize } ;
-            llvm::Value* fieldAlloc = builder.CreateCall(coreAlloc, llvm::ArrayRef(args)); 
+            llvm::Value* fieldAlloc = builder.CreateCall(coreAllocAligned, llvm::ArrayRef(args)); 
             std::vector<llvm::Value*> offsets = {
                 llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
                 llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, fieldIndex))
@@ -1123,10 +1776,19 @@ void tabic::allocateContextType(Type* type, Slab* hostSlab, llvm::Value* context
             llvm::Value* fieldStore = builder.CreateGEP(type->common.build.llvmType, contextStore, llvm::ArrayRef(offsets)); 
             builder.CreateStore(fieldAlloc, fieldStore); 
         }
+        //Call the core_table_init function
+        {
+            std::vector<llvm::Value*> args = {
+                contextStore, type->table.parse.numRows->common.build.llvmValue
+            }; 
+            llvm::FunctionCallee coreTableInit = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::TABLE_INIT.create.name, TabiCore::TABLE_INIT.build.functionType); 
+            builder.CreateCall(coreTableInit, llvm::ArrayRef(args)); 
+        }
+        allocateTableKeyIndexes(type, contextStore, hostSlab, false); 
     }
 }
 
-void tabic::allocateHeapSubvectors(CollectionType* collectionType, llvm::Value* store, TabithaFunction* hostFunction)
+void tabic::allocateHeapSubvectors(CollectionType* collectionType, llvm::Value* store, TabithaFunction* hostFunction, llvm::Value* arena)
 {
     for(auto pair : collectionType->parse.members)
     {
@@ -1139,19 +1801,19 @@ void tabic::allocateHeapSubvectors(CollectionType* collectionType, llvm::Value*
         llvm::Value* memberStore = builder.CreateGEP(collectionType->common.build.llvmType, store, llvm::ArrayRef(offsets));
         if(memberType->common.typeClass == TYPE_VECTOR)
         {
-            llvm::Value* vecStore = allocateHeapType(memberType, hostFunction);  
+            llvm::Value* vecStore = allocateHeapType(memberType, hostFunction, "", arena);  
             llvm::Value* vec      = builder.CreateLoad(memberType->common.build.llvmType, vecStore); 
             builder.CreateStore(vec, memberStore); 
         }
         else if(memberType->common.typeClass == TYPE_TABLE)
         {
-            llvm::Value* tableStore = allocateHeapType(memberType, hostFunction); 
+            llvm::Value* tableStore = allocateHeapType(memberType, hostFunction, "", arena); 
             llvm::Value* table = builder.CreateLoad(memberType->common.build.llvmType, tableStore); 
             builder.CreateStore(table, memberStore); 
         }
         else if(memberType->common.typeClass == TYPE_COLLECTION)
         {
-            allocateHeapSubvectors((CollectionType*) memberType, memberStore, hostFunction);
+            allocateHeapSubvectors((CollectionType*) memberType, memberStore, hostFunction, arena);
         }
     }
 }
@@ -1185,8 +1847,20 @@ void tabic::buildHeapedDeclaration(HeapedDeclaration* heapedDeclaration)
     HeapedVariable* variable = heapedDeclaration->parse.variable;
     Type* type = variable->common.parse.type;
     buildType(type);
-    llvm::Value* ptr = allocateHeapType(type, heapedDeclaration->common.parse.hostFunction, variable->common.parse.name);    
+    llvm::Value* arena = nullptr; 
+    if(heapedDeclaration->parse.arenaRef)
+    {
+        buildValueRef(heapedDeclaration->parse.arenaRef, nullptr); 
+        arena = heapedDeclaration->parse.arenaRef->common.build.llvmStore; 
+    }
+    llvm::Value* ptr = allocateHeapType(type, heapedDeclaration->common.parse.hostFunction, variable->common.parse.name, arena);    
     builder.CreateStore(ptr, variable->common.build.llvmStore);
+    //An Arena holds nothing until the first allocation into it. 
+    if(isArenaType(type) && !heapedDeclaration->parse.initialiser)
+    {
+        llvm::Value* handle = builder.CreateBitCast(ptr, type->common.build.llvmType->getPointerTo()); 
+        builder.CreateStore(llvm::ConstantPointerNull::get((llvm::PointerType*) type->common.build.llvmType), handle); 
+    }
 }
 
 void tabic::registerFunction(Function* function)
@@ -1229,6 +1903,29 @@ void tabic::registerFunction(Function* function)
     function->common.build.llvmFunction->setCallingConv(TABITHA_CALLING_CONVENTION); 
 }
 
+llvm::Value* tabic::buildTableProfileStore(ContextVariable* variable, Slab* hostSlab)
+{
+    llvm::Type* profileType = llvm::ArrayType::get(SupportedPrimitives::LONG.common.build.llvmType, TableType::PROFILE_NUM_COUNTERS); 
+    return hostSlab->build.llvmModule->getOrInsertGlobal(variable->build.fullName + "_profile", profileType); 
+}
+
+void tabic::buildTableProfileCount(ValueRef* tableRef, int counter, llvm::Value* amount)
+{
+    if(!Util::flags.at("profile-tables")) return; 
+    //Only context tables have counters, being the relational state which outlives a function call. 
+    if(tableRef->common.valueRefClass != VALUE_REF_VARIABLE || tableRef->variable.parse.variable->common.variableClass != VARIABLE_CONTEXT) return; 
+    if(tableRef->variable.parse.variable->common.parse.type->common.typeClass != TYPE_TABLE) return; 
+    llvm::Type* longType = SupportedPrimitives::LONG.common.build.llvmType; 
+    llvm::Value* profileStore = buildTableProfileStore(&tableRef->variable.parse.variable->context, tableRef->variable.parse.hostSlab); 
+    std::vector<llvm::Value*> offsets = {
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
+        llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, counter))
+    }; 
+    llvm::Value* counterStore = builder.CreateGEP(llvm::ArrayType::get(longType, TableType::PROFILE_NUM_COUNTERS), profileStore, llvm::ArrayRef(offsets)); 
+    if(!amount) amount = llvm::ConstantInt::get(longType, llvm::APInt(64, 1)); 
+    builder.CreateStore(builder.CreateAdd(builder.CreateLoad(longType, counterStore), amount), counterStore); 
+}
+
 void tabic::buildContext(Context* context)
 {
     Bundle* hostBundle = context->create.hostSlab->create.hostBundle;
@@ -1254,6 +1951,14 @@ void tabic::buildContext(Context* context)
                 false, llvm::GlobalVariable::ExternalLinkage, (llvm::Constant*) llvmInit,
                 variable->build.fullName, nullptr, llvm::GlobalVariable::NotThreadLocal);
         variable->build.declaredIn.push_back(context->create.hostSlab); 
+        if(Util::flags.at("profile-tables") && variable->common.parse.type->common.typeClass == TYPE_TABLE)
+        {
+            llvm::Type* profileType = llvm::ArrayType::get(SupportedPrimitives::LONG.common.build.llvmType, TableType::PROFILE_NUM_COUNTERS); 
+            new llvm::GlobalVariable(
+                    *context->create.hostSlab->build.llvmModule, profileType,
+                    false, llvm::GlobalVariable::ExternalLinkage, llvm::Constant::getNullValue(profileType),
+                    variable->build.fullName + "_profile", nullptr, llvm::GlobalVariable::NotThreadLocal); 
+        }
 
         if((variable->common.parse.type->common.typeClass == TYPE_VECTOR && variable->common.parse.type->vector.parse.numElem) ||
                 variable->common.parse.type->common.typeClass == TYPE_TABLE || variable->common.parse.type->common.typeClass == TYPE_COLLECTION)
@@ -1333,7 +2038,7 @@ void tabic::buildExpression(Expression* expression)
     {
         expression->common.build.llvmValue = llvm::ConstantInt::get(
                 SupportedPrimitives::SIZE.common.build.llvmType,
-                llvm::APInt(32, expression->sizeLiteral.parse.value)); 
+                expression->sizeLiteral.parse.value); 
     }
     else if(expressionClass == EXPRESSION_CHAR_LITERAL)
     {
@@ -1381,7 +2086,18 @@ void tabic::buildExpression(Expression* expression)
             buildExpression(arg); 
             llvmArgs.push_back(arg->common.build.llvmValue);
         }
-        expression->common.build.llvmValue = builder.CreateCall(callee, llvm::ArrayRef(llvmArgs));
+        llvm::cast<llvm::Function>(callee.getCallee())->setCallingConv(TABITHA_CALLING_CONVENTION); 
+        llvm::CallInst* call = builder.CreateCall(callee, llvm::ArrayRef(llvmArgs)); 
+        call->setCallingConv(TABITHA_CALLING_CONVENTION); 
+        expression->common.build.llvmValue = call;
+    }
+    else if(expressionClass == EXPRESSION_AGGREGATE)
+    {
+        buildAggregate((Aggregate*) expression); 
+    }
+    else if(expressionClass == EXPRESSION_LOOKUP)
+    {
+        buildLookup((Lookup*) expression); 
     }
     else if(expressionClass == EXPRESSION_BRACKETED)
     {
@@ -1394,160 +2110,266 @@ void tabic::buildExpression(Expression* expression)
     }
     else if(expressionClass == EXPRESSION_BINARY)
     {
-        //account for order of operations
-        if(expression->binary.parse.rhs->common.expressionClass == EXPRESSION_BINARY)
-        {
-            Expression* a = expression->binary.parse.lhs; 
-            Expression* b = expression->binary.parse.rhs->binary.parse.lhs; 
-            Expression* c = expression->binary.parse.rhs->binary.parse.rhs; 
-            BinaryOperator p = expression->binary.parse.op; 
-            BinaryOperator q = expression->binary.parse.rhs->binary.parse.op; 
-            if(p > q)
-            {
-                Expression* dummy = expression->binary.parse.lhs; 
-                expression->binary.parse.lhs = expression->binary.parse.rhs; 
-                expression->binary.parse.rhs = dummy;
-                expression->binary.parse.lhs->binary.parse.lhs = a;
-                expression->binary.parse.lhs->binary.parse.rhs = b;
-                expression->binary.parse.rhs = c; 
-                expression->binary.parse.op = q; 
-                expression->binary.parse.lhs->binary.parse.op = p;
-            }
-        }
+        orderBinaryExpression(expression); 
         Expression* lhs = expression->binary.parse.lhs;
         Expression* rhs = expression->binary.parse.rhs;
-        BinaryOperator op = expression->binary.parse.op;
         //Build the type. 
         buildType(expression->common.parse.type); 
         //Build the LHS and RHS.
         buildExpression(lhs);
         buildExpression(rhs);
-        llvm::Value* llvmLHS = lhs->common.build.llvmValue;
-        llvm::Value* llvmRHS = rhs->common.build.llvmValue;
-        Type* lhsType = lhs->common.parse.type;
+        expression->common.build.llvmValue = buildBinaryOperation(
+                expression->binary.parse.op, expression->binary.parse.ep,
+                lhs->common.build.llvmValue, rhs->common.build.llvmValue); 
+    }
+}
+
+void tabic::orderBinaryExpression(Expression* expression)
+{
+    //account for order of operations
+    if(expression->binary.parse.rhs->common.expressionClass == EXPRESSION_BINARY)
+    {
+        Expression* a = expression->binary.parse.lhs; 
+        Expression* b = expression->binary.parse.rhs->binary.parse.lhs; 
+        Expression* c = expression->binary.parse.rhs->binary.parse.rhs; 
+        BinaryOperator p = expression->binary.parse.op; 
+        BinaryOperator q = expression->binary.parse.rhs->binary.parse.op; 
+        if(p > q)
+        {
+            Expression* dummy = expression->binary.parse.lhs; 
+            expression->binary.parse.lhs = expression->binary.parse.rhs; 
+            expression->binary.parse.rhs = dummy;
+            expression->binary.parse.lhs->binary.parse.lhs = a;
+            expression->binary.parse.lhs->binary.parse.rhs = b;
+            expression->binary.parse.rhs = c; 
+            expression->binary.parse.op = q; 
+            expression->binary.parse.lhs->binary.parse.op = p;
+        }
+    }
+}
 
-        //Now process based on the operator and respective types. 
-        if(op == BINARY_OP_PLUS)
+llvm::Value* tabic::buildBinaryOperation(BinaryOperator op, EquivalentPrimitive ep, llvm::Value* lhs, llvm::Value* rhs)
+{
+    //Process based on the operator and respective types. 
+    llvm::Value* result = nullptr; 
+    if(op == BINARY_OP_PLUS)
+    {
+        if(ep == EP_INT)
         {
-            if(expression->binary.parse.ep == EP_INT)
-            {
-                expression->common.build.llvmValue = builder.CreateAdd(llvmLHS, llvmRHS);
-            }
-            else if(expression->binary.parse.ep == EP_FLOAT)
-            {
-                expression->common.build.llvmValue = builder.CreateFAdd(llvmLHS, llvmRHS);
-            }
+            result = builder.CreateAdd(lhs, rhs);
         }
-        else if(op == BINARY_OP_SUB)
+        else if(ep == EP_FLOAT)
         {
-            if(expression->binary.parse.ep == EP_INT)
-            {
-                expression->common.build.llvmValue = builder.CreateSub(llvmLHS, llvmRHS); 
-            }
-            else if(expression->binary.parse.ep == EP_FLOAT)
-            {
-                expression->common.build.llvmValue = builder.CreateFSub(llvmLHS, llvmRHS); 
-            } 
+            result = builder.CreateFAdd(lhs, rhs);
         }
-        else if(op == BINARY_OP_MUL)
+    }
+    else if(op == BINARY_OP_SUB)
+    {
+        if(ep == EP_INT)
         {
-            if(expression->binary.parse.ep == EP_INT)
-            {
-                expression->common.build.llvmValue = builder.CreateMul(llvmLHS, llvmRHS);
-            }
-            else if(expression->binary.parse.ep == EP_FLOAT)
-            {
-                expression->common.build.llvmValue = builder.CreateFMul(llvmLHS, llvmRHS); 
-            }
+            result = builder.CreateSub(lhs, rhs); 
         }
-        else if(op == BINARY_OP_DIV)
+        else if(ep == EP_FLOAT)
         {
-            if(expression->binary.parse.ep == EP_INT)
-            {
-                expression->common.build.llvmValue = builder.CreateSDiv(llvmLHS, llvmRHS); 
-            }
-            else if(expression->binary.parse.ep == EP_FLOAT)
-            {
-                expression->common.build.llvmValue = builder.CreateFDiv(llvmLHS, llvmRHS);
-            }
+            result = builder.CreateFSub(lhs, rhs); 
+        } 
+    }
+    else if(op == BINARY_OP_MUL)
+    {
+        if(ep == EP_INT)
+        {
+            result = builder.CreateMul(lhs, rhs);
         }
-        else if(op == BINARY_OP_LT)
+        else if(ep == EP_FLOAT)
         {
-            if(expression->binary.parse.ep == EP_INT)
-            {
-                expression->common.build.llvmValue = builder.CreateICmpSLT(llvmLHS, llvmRHS); 
-            }
-            else if(expression->binary.parse.ep == EP_FLOAT)
-            {
-                expression->common.build.llvmValue = builder.CreateFCmpOLT(llvmLHS, llvmRHS); 
-            }
+            result = builder.CreateFMul(lhs, rhs); 
         }
-        else if(op == BINARY_OP_GT)
+    }
+    else if(op == BINARY_OP_DIV)
+    {
+        if(ep == EP_INT)
         {
-            if(expression->binary.parse.ep == EP_INT)
-            {
-                expression->common.build.llvmValue = builder.CreateICmpSGT(llvmLHS, llvmRHS); 
-            }
-            else if(expression->binary.parse.ep == EP_FLOAT)
-            {
-                expression->common.build.llvmValue = builder.CreateFCmpOGT(llvmLHS, llvmRHS); 
-            }
+            result = builder.CreateSDiv(lhs, rhs); 
         }
-        else if(op == BINARY_OP_LTE)
+        else if(ep == EP_FLOAT)
         {
-            if(expression->binary.parse.ep == EP_INT)
-            {
-                expression->common.build.llvmValue = builder.CreateICmpSLE(llvmLHS, llvmRHS); 
-            }
-            else if(expression->binary.parse.ep == EP_FLOAT)
-            {
-                expression->common.build.llvmValue = builder.CreateFCmpOLE(llvmLHS, llvmRHS); 
-            }
+            result = builder.CreateFDiv(lhs, rhs);
         }
-        else if(op == BINARY_OP_GTE)
+    }
+    else if(op == BINARY_OP_LT)
+    {
+        if(ep == EP_INT)
         {
-            if(expression->binary.parse.ep == EP_INT)
-            {
-                expression->common.build.llvmValue = builder.CreateICmpSGE(llvmLHS, llvmRHS); 
-            }
-            else if(expression->binary.parse.ep == EP_FLOAT)
-            {
-                expression->common.build.llvmValue = builder.CreateFCmpOGE(llvmLHS, llvmRHS); 
-            }
+            result = builder.CreateICmpSLT(lhs, rhs); 
         }
-        else if(op == BINARY_OP_EQUALS)
+        else if(ep == EP_FLOAT)
         {
-            if(expression->binary.parse.ep == EP_INT)
-            {
-                expression->common.build.llvmValue = builder.CreateICmpEQ(llvmLHS, llvmRHS);
-            }
-            else if(expression->binary.parse.ep == EP_FLOAT)
-            {
-                expression->common.build.llvmValue = builder.CreateFCmpOEQ(llvmLHS, llvmRHS); 
-            }
-            else if(expression->binary.parse.ep == EP_CHAR)
-            {
-                expression->common.build.llvmValue = builder.CreateICmpEQ(llvmLHS, llvmRHS); 
-            }
+            result = builder.CreateFCmpOLT(lhs, rhs); 
         }
-        else if(op == BINARY_OP_NOT_EQUAL)
+    }
+    else if(op == BINARY_OP_GT)
+    {
+        if(ep == EP_INT)
         {
-            if(expression->binary.parse.ep == EP_INT)
-            {
-                expression->common.build.llvmValue = builder.CreateICmpNE(llvmLHS, llvmRHS); 
-            }
-            else if(expression->binary.parse.ep == EP_FLOAT)
-            {
-                expression->common.build.llvmValue = builder.CreateFCmpONE(llvmLHS, llvmRHS); 
-            }
-            else if(expression->binary.parse.ep == EP_CHAR)
-            {
-                expression->common.build.llvmValue = builder.CreateICmpNE(llvmLHS, llvmRHS); 
-            }
+            result = builder.CreateICmpSGT(lhs, rhs); 
+        }
+        else if(ep == EP_FLOAT)
+        {
+            result = builder.CreateFCmpOGT(lhs, rhs); 
         }
     }
+    else if(op == BINARY_OP_LTE)
+    {
+        if(ep == EP_INT)
+        {
+            result = builder.CreateICmpSLE(lhs, rhs); 
+        }
+        else if(ep == EP_FLOAT)
+        {
+            result = builder.CreateFCmpOLE(lhs, rhs); 
+        }
+    }
+    else if(op == BINARY_OP_GTE)
+    {
+        if(ep == EP_INT)
+        {
+            result = builder.CreateICmpSGE(lhs, rhs); 
+        }
+        else if(ep == EP_FLOAT)
+        {
+            result = builder.CreateFCmpOGE(lhs, rhs); 
+        }
+    }
+    else if(op == BINARY_OP_EQUALS)
+    {
+        if(ep == EP_INT)
+        {
+            result = builder.CreateICmpEQ(lhs, rhs);
+        }
+        else if(ep == EP_FLOAT)
+        {
+            result = builder.CreateFCmpOEQ(lhs, rhs); 
+        }
+        else if(ep == EP_CHAR)
+        {
+            result = builder.CreateICmpEQ(lhs, rhs); 
+        }
+    }
+    else if(op == BINARY_OP_NOT_EQUAL)
+    {
+        if(ep == EP_INT)
+        {
+            result = builder.CreateICmpNE(lhs, rhs); 
+        }
+        else if(ep == EP_FLOAT)
+        {
+            result = builder.CreateFCmpONE(lhs, rhs); 
+        }
+        else if(ep == EP_CHAR)
+        {
+            result = builder.CreateICmpNE(lhs, rhs); 
+        }
+    }
+    return result; 
+}
+
+void tabic::buildAggregate(Aggregate* aggregate)
+{
+    buildType(aggregate->common.parse.type); 
+    buildValueRef(aggregate->parse.tableRef, nullptr); 
+    Type* tableType = aggregate->parse.tableRef->common.parse.type; 
+    llvm::Value* tableStore = aggregate->parse.tableRef->common.build.llvmStore; 
+    llvm::Module* hostModule = aggregate->common.parse.hostSlab->build.llvmModule; 
+    llvm::Type* intType = SupportedPrimitives::INT.common.build.llvmType; 
+    llvm::Value* numRows = buildTableNumRows(tableType, tableStore); 
+    //The count is kept by the table itself. 
+    if(aggregate->parse.op == AGGREGATE_COUNT)
+    {
+        llvm::FunctionCallee coreTableGetNumUsed = hostModule->getOrInsertFunction(TabiCore::TABLE_GET_NUM_USED.create.name, TabiCore::TABLE_GET_NUM_USED.build.functionType);
+        std::vector<llvm::Value*> args = { tableStore }; 
+        aggregate->common.build.llvmValue = builder.CreateCall(coreTableGetNumUsed, llvm::ArrayRef(args)); 
+        return; 
+    }
+    //Otherwise pass the field and the #use bitmap to the kernel. 
+    llvm::Type* elemType = tableType->table.parse.fields[aggregate->parse.fieldIndex].type->common.build.llvmType; 
+    llvm::Value* field; 
+    llvm::Value* useField; 
+    {
+        std::vector<llvm::Value*> offsets = {
+            llvm::ConstantInt::get(intType, llvm::APInt(32, 0)),
+            llvm::ConstantInt::get(intType, llvm::APInt(32, aggregate->parse.fieldIndex))
+        }; 
+        field = builder.CreateLoad(elemType->getPointerTo(), builder.CreateGEP(tableType->common.build.llvmType, tableStore, llvm::ArrayRef(offsets))); 
+        offsets[1] = llvm::ConstantInt::get(intType, llvm::APInt(32, 1)); 
+        useField = builder.CreateLoad(intType->getPointerTo(), builder.CreateGEP(tableType->common.build.llvmType, tableStore, llvm::ArrayRef(offsets))); 
+    }
+    //The mean has kernels of its own, which sum in a wider type than the field's, and give a Double. 
+    std::string kernelName = "core_aggregate_"; 
+    llvm::Type* resultType = elemType; 
+    if(aggregate->parse.op == AGGREGATE_MIN) kernelName += "min"; 
+    else if(aggregate->parse.op == AGGREGATE_MAX) kernelName += "max"; 
+    else if(aggregate->parse.op == AGGREGATE_MEAN)
+    {
+        kernelName += "mean"; 
+        resultType = SupportedPrimitives::DOUBLE.common.build.llvmType; 
+    }
+    else kernelName += "sum"; 
+    kernelName += aggregate->parse.elemName; 
+    std::vector<llvm::Type*> argTypes = { elemType->getPointerTo(), intType->getPointerTo(), intType }; 
+    llvm::FunctionCallee kernel = hostModule->getOrInsertFunction(kernelName, llvm::FunctionType::get(resultType, llvm::ArrayRef(argTypes), false)); 
+    std::vector<llvm::Value*> args = { field, useField, numRows }; 
+    aggregate->common.build.llvmValue = builder.CreateCall(kernel, llvm::ArrayRef(args)); 
 }
 
+llvm::Value* tabic::buildKeyBits(llvm::Value* key)
+{
+    llvm::Type* longType = SupportedPrimitives::LONG.common.build.llvmType; 
+    llvm::Type* keyType = key->getType(); 
+    if(keyType->isPointerTy()) return builder.CreatePtrToInt(key, longType); 
+    if(keyType->isFloatingPointTy()) key = builder.CreateBitCast(key, llvm::IntegerType::get(llvmContext, keyType->getPrimitiveSizeInBits())); 
+    return builder.CreateZExt(key, longType); 
+}
+
+void tabic::buildLookup(Lookup* lookup)
+{
+    buildValueRef(lookup->parse.tableRef, nullptr); 
+    buildExpression(lookup->parse.key); 
+    Type* tableType = lookup->parse.tableRef->common.parse.type; 
+    llvm::Value* tableStore = lookup->parse.tableRef->common.build.llvmStore; 
+    llvm::Module* hostModule = lookup->common.parse.hostSlab->build.llvmModule; 
+    llvm::Type* intType = SupportedPrimitives::INT.common.build.llvmType; 
+    int hashIndex = 0; 
+    while(tableType->table.parse.indexedFields[hashIndex] != lookup->parse.fieldIndex) hashIndex++; 
+    std::vector<llvm::Value*> args = buildTableHashArgs(tableType, tableStore, lookup->common.parse.hostSlab, hashIndex, true); 
+    args.push_back(buildKeyBits(lookup->parse.key->common.build.llvmValue)); 
+    llvm::FunctionCallee coreHashFind = hostModule->getOrInsertFunction(TabiCore::HASH_FIND.create.name, TabiCore::HASH_FIND.build.functionType); 
+    llvm::Value* row = builder.CreateCall(coreHashFind, llvm::ArrayRef(args)); 
+    buildTableProfileCount(lookup->parse.tableRef, TableType::PROFILE_LOOKUPS); 
+    //Read the ID of the row, if one was found. 
+    llvm::Function* llvmFunction = lookup->common.parse.hostBlock->common.parse.hostFunction->common.build.llvmFunction; 
+    llvm::BasicBlock* lookupStart = builder.GetInsertBlock(); 
+    llvm::BasicBlock* lookupFound = llvm::BasicBlock::Create(llvmContext, "lookup_found", llvmFunction); 
+    llvm::BasicBlock* lookupEnd = llvm::BasicBlock::Create(llvmContext, "lookup_end", llvmFunction); 
+    llvm::Value* none = llvm::ConstantInt::get(intType, llvm::APInt(32, -1, true)); 
+    builder.CreateCondBr(builder.CreateICmpEQ(row, none), lookupEnd, lookupFound); 
+    builder.SetInsertPoint(lookupFound); 
+    llvm::Value* id; 
+    {
+        std::vector<llvm::Value*> offsets = {
+            llvm::ConstantInt::get(intType, llvm::APInt(32, 0)),
+            llvm::ConstantInt::get(intType, llvm::APInt(32, 0))
+        }; 
+        llvm::Value* idField = builder.CreateLoad(intType->getPointerTo(), builder.CreateGEP(tableType->common.build.llvmType, tableStore, llvm::ArrayRef(offsets))); 
+        offsets = { row }; 
+        id = builder.CreateLoad(intType, builder.CreateGEP(intType, idField, llvm::ArrayRef(offsets))); 
+    }
+    builder.CreateBr(lookupEnd); 
+    builder.SetInsertPoint(lookupEnd); 
+    llvm::PHINode* result = builder.CreatePHI(intType, 2); 
+    result->addIncoming(none, lookupStart); 
+    result->addIncoming(id, lookupFound); 
+    lookup->common.build.llvmValue = result; 
+}
 
 void tabic::buildConditional(Conditional* conditional)
 {
@@ -1760,13 +2582,19 @@ void tabic::buildValueRef(ValueRef* valueRef, ValueRef* fine)
     }
     else if(valueRefClass == VALUE_REF_ROW)
     {
-        buildExpression(valueRef->row.parse.id); 
         //Get the associated row.
         llvm::Value* row; 
+        if(valueRef->row.parse.scan)
         {
+            //The enclosing TableScan already knows which row we are on. 
+            row = builder.CreateLoad(SupportedPrimitives::INT.common.build.llvmType, valueRef->row.parse.scan->build.rowStore); 
+        }
+        else
+        {
+            buildExpression(valueRef->row.parse.id); 
             std::vector<llvm::Value*> args = {
                 valueRef->common.parse.parent->common.build.llvmStore,
-                valueRef->common.parse.parent->common.parse.type->table.parse.numRows->common.build.llvmValue,
+                buildTableNumRows(valueRef->common.parse.parent->common.parse.type, valueRef->common.parse.parent->common.build.llvmStore),
                 valueRef->row.parse.id->common.build.llvmValue
             }; 
             Slab* hostSlab = valueRef->common.parse.parent->variable.parse.hostSlab;
@@ -1774,28 +2602,15 @@ void tabic::buildValueRef(ValueRef* valueRef, ValueRef* fine)
                     TabiCore::TABLE_GET_BY_ID.create.name, TabiCore::TABLE_GET_BY_ID.build.functionType
             );
             row = builder.CreateCall(coreTableGetRow, llvm::ArrayRef(args)); 
+            buildTableProfileCount(valueRef->common.parse.parent, TableType::PROFILE_LOOKUPS); 
         }
-        //Get the field store
-        llvm::Value* fieldStore;
-        {
-            std::vector<llvm::Value*> offsets = {
-                llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
-                llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, valueRef->row.parse.fieldIndex)) 
-            };
-            fieldStore = builder.CreateGEP(
-                    valueRef->common.parse.parent->common.parse.type->common.build.llvmType,
-                    valueRef->common.parse.parent->common.build.llvmStore,
-                    llvm::ArrayRef(offsets));
-        }
-        //now load the actual pointer to elements
-        llvm::Value* arrayStore = builder.CreateLoad(valueRef->common.parse.type->common.build.llvmType->getPointerTo(), fieldStore);
+        valueRef->row.build.row = row; 
         //Get the element store
-        {
-            std::vector<llvm::Value*> offsets = {
-                row
-            };
-            valueRef->common.build.llvmStore = builder.CreateGEP(valueRef->common.parse.type->common.build.llvmType, arrayStore, llvm::ArrayRef(offsets)); 
-        }
+        valueRef->common.build.llvmStore = buildTableElementStore(
+                valueRef->common.parse.parent->common.parse.type,
+                valueRef->common.parse.parent->common.build.llvmStore,
+                valueRef->row.parse.fieldIndex,
+                row); 
     }
     //Now if there has been a query, we do an extra load. 
     if(valueRef == fine && valueRef->common.parse.query)
@@ -1814,10 +2629,26 @@ void tabic::buildTableDelete(TableDelete* tableDelete)
     llvm::FunctionCallee coreTableDelete = hostSlab->build.llvmModule->getOrInsertFunction( TabiCore::TABLE_DELETE_BY_ID.create.name, TabiCore::TABLE_DELETE_BY_ID.build.functionType); 
     std::vector<llvm::Value*> args = {
         tableDelete->parse.tableRef->common.build.llvmStore,
-        tableDelete->parse.tableRef->common.parse.type->table.parse.numRows->common.build.llvmValue,
+        buildTableNumRows(tableDelete->parse.tableRef->common.parse.type, tableDelete->parse.tableRef->common.build.llvmStore),
         tableDelete->parse.id->common.build.llvmValue
     };
+    //The row (if any) is taken out of the hash and ordered indexes while its keys can still be read. 
+    Type* type = tableDelete->parse.tableRef->common.parse.type; 
+    if(!type->table.parse.indexedFields.empty() || !type->table.parse.orderedFields.empty())
+    {
+        llvm::FunctionCallee coreTableFindRow = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::TABLE_FIND_BY_ID.create.name, TabiCore::TABLE_FIND_BY_ID.build.functionType); 
+        llvm::Value* row = builder.CreateCall(coreTableFindRow, llvm::ArrayRef(args)); 
+        llvm::Function* llvmFunction = tableDelete->common.parse.hostFunction->common.build.llvmFunction; 
+        llvm::BasicBlock* hashRemove = llvm::BasicBlock::Create(llvmContext, "delete_hash_remove", llvmFunction); 
+        llvm::BasicBlock* hashEnd = llvm::BasicBlock::Create(llvmContext, "delete_hash_end", llvmFunction); 
+        builder.CreateCondBr(builder.CreateICmpSGE(row, llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0))), hashRemove, hashEnd); 
+        builder.SetInsertPoint(hashRemove); 
+        buildTableKeyIndexUpdate(type, tableDelete->parse.tableRef->common.build.llvmStore, hostSlab, row, false); 
+        builder.CreateBr(hashEnd); 
+        builder.SetInsertPoint(hashEnd); 
+    }
     builder.CreateCall(coreTableDelete, llvm::ArrayRef(args)); 
+    buildTableProfileCount(tableDelete->parse.tableRef, TableType::PROFILE_DELETES); 
 }
 
 void tabic::buildTableMeasure(TableMeasure* tableMeasure)
@@ -1827,11 +2658,11 @@ void tabic::buildTableMeasure(TableMeasure* tableMeasure)
     Slab* hostSlab = tableMeasure->common.parse.hostFunction->create.hostSlab;
     llvm::FunctionCallee coreTableGetNumUsed = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::TABLE_GET_NUM_USED.create.name, TabiCore::TABLE_GET_NUM_USED.build.functionType);
     std::vector<llvm::Value*> args = {
-        tableMeasure->parse.tableRef->common.build.llvmStore,
-        tableMeasure->parse.tableRef->common.parse.type->table.parse.numRows->common.build.llvmValue
+        tableMeasure->parse.tableRef->common.build.llvmStore
     };
     llvm::Value* numUsed = builder.CreateCall(coreTableGetNumUsed, llvm::ArrayRef(args));
     builder.CreateStore(numUsed, tableMeasure->parse.usedRef->common.build.llvmStore);
+    buildTableProfileCount(tableMeasure->parse.tableRef, TableType::PROFILE_MEASURES); 
 }
 
 void tabic::buildTableCrunch(TableCrunch* tableCrunch)
@@ -1839,27 +2670,15 @@ void tabic::buildTableCrunch(TableCrunch* tableCrunch)
     buildValueRef(tableCrunch->parse.tableRef, nullptr); 
     if(tableCrunch->parse.idRef) buildValueRef(tableCrunch->parse.idRef, nullptr); 
     Slab* hostSlab = tableCrunch->common.parse.hostFunction->create.hostSlab;
-    int numFields = tableCrunch->parse.tableRef->common.parse.type->table.parse.fields.size() - 2;
+    int numFields = getTableNumArrays(tableCrunch->parse.tableRef->common.parse.type);
     llvm::FunctionCallee coreTableCrunch = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::TABLE_CRUNCH.create.name, TabiCore::TABLE_CRUNCH.build.functionType);
-    llvm::Value* fieldSizes = builder.CreateAlloca(SupportedPrimitives::INT.common.build.llvmType, 
-            llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, numFields));
-    llvm::DataLayout dl = hostSlab->build.llvmModule->getDataLayout();
-    for(int i = 0; i < numFields; i++)
-    {
-        std::vector<llvm::Value*> offsets = { 
-            llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, i))
-        };
-        llvm::Value* elemPtr = builder.CreateGEP(SupportedPrimitives::INT.common.build.llvmType, fieldSizes, llvm::ArrayRef(offsets));
-        builder.CreateStore(
-                llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, 
-                    llvm::APInt(32, dl.getTypeAllocSize(tableCrunch->parse.tableRef->common.parse.type->table.parse.fields[i].type->common.build.llvmType))),
-                elemPtr);
-    }
+    llvm::Value* fieldSizes = buildTableFieldSizes(tableCrunch->parse.tableRef->common.parse.type, hostSlab); 
+    llvm::Value* numRows = buildTableNumRows(tableCrunch->parse.tableRef->common.parse.type, tableCrunch->parse.tableRef->common.build.llvmStore); 
     std::vector<llvm::Value*> args;
     if(tableCrunch->parse.idRef) {
         args = {
             tableCrunch->parse.tableRef->common.build.llvmStore,
-            tableCrunch->parse.tableRef->common.parse.type->table.parse.numRows->common.build.llvmValue,
+            numRows,
             llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType,
                     llvm::APInt(32, numFields)),
             fieldSizes,
@@ -1870,7 +2689,7 @@ void tabic::buildTableCrunch(TableCrunch* tableCrunch)
     {
         args = {
             tableCrunch->parse.tableRef->common.build.llvmStore,
-            tableCrunch->parse.tableRef->common.parse.type->table.parse.numRows->common.build.llvmValue,
+            numRows,
             llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType,
                     llvm::APInt(32, numFields)),
             fieldSizes,
@@ -1878,6 +2697,518 @@ void tabic::buildTableCrunch(TableCrunch* tableCrunch)
         };
     }
     builder.CreateCall(coreTableCrunch, llvm::ArrayRef(args));
+    buildTableProfileCount(tableCrunch->parse.tableRef, TableType::PROFILE_CRUNCHES); 
+    //Crunching moves rows, so the hash indexes are built afresh. 
+    buildTableKeyIndexRebuild(tableCrunch->parse.tableRef->common.parse.type, tableCrunch->parse.tableRef->common.build.llvmStore, hostSlab); 
+}
+
+void tabic::buildTableScan(TableScan* tableScan)
+{
+    buildValueRef(tableScan->parse.tableRef, nullptr); 
+    Type* tableType = tableScan->parse.tableRef->common.parse.type; 
+    llvm::Value* tableStore = tableScan->parse.tableRef->common.build.llvmStore; 
+    llvm::Type* intType = SupportedPrimitives::INT.common.build.llvmType; 
+    llvm::Function* llvmFunction = tableScan->common.parse.hostFunction->common.build.llvmFunction; 
+    Slab* hostSlab = tableScan->common.parse.hostFunction->create.hostSlab; 
+    bool ordered = tableScan->parse.orderFieldIndex != -1; 
+    //Start from the first row, or from the first entry of the ordered index within the bounds. 
+    llvm::Value* toBits = nullptr; 
+    int treeIndex = 0; 
+    if(ordered)
+    {
+        while(tableType->table.parse.orderedFields[treeIndex] != tableScan->parse.orderFieldIndex) treeIndex++; 
+        llvm::Value* fromBits = llvm::ConstantInt::get(SupportedPrimitives::LONG.common.build.llvmType, llvm::APInt(64, 0)); 
+        toBits = fromBits; 
+        if(tableScan->parse.from)
+        {
+            buildExpression(tableScan->parse.from); 
+            fromBits = buildKeyBits(tableScan->parse.from->common.build.llvmValue); 
+        }
+        if(tableScan->parse.to)
+        {
+            buildExpression(tableScan->parse.to); 
+            toBits = buildKeyBits(tableScan->parse.to->common.build.llvmValue); 
+        }
+        std::vector<llvm::Value*> args = {
+            builder.CreateLoad(SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(), buildTableTreeStore(tableType, tableStore, treeIndex)), 
+            tableScan->build.cursorStore, 
+            fromBits, 
+            llvm::ConstantInt::get(intType, llvm::APInt(32, tableScan->parse.from ? 1 : 0))
+        }; 
+        llvm::FunctionCallee coreTreeSeek = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::BTREE_SEEK.create.name, TabiCore::BTREE_SEEK.build.functionType); 
+        builder.CreateCall(coreTreeSeek, llvm::ArrayRef(args)); 
+    }
+    else builder.CreateStore(llvm::ConstantInt::get(intType, llvm::APInt(32, 0)), tableScan->build.rowStore); 
+    llvm::BasicBlock* condition = llvm::BasicBlock::Create(llvmContext, "scan_condition", llvmFunction); 
+    llvm::BasicBlock* directionStart = llvm::BasicBlock::Create(llvmContext, "scan_direction_start", llvmFunction); 
+    llvm::BasicBlock* next = llvm::BasicBlock::Create(llvmContext, "scan_next", llvmFunction); 
+    llvm::BasicBlock* scanEnd = llvm::BasicBlock::Create(llvmContext, "scan_end", llvmFunction); 
+    builder.CreateBr(condition); 
+    builder.SetInsertPoint(condition); 
+    llvm::Value* row; 
+    if(ordered)
+    {
+        //The ordered index only holds used rows, and gives -1 once past the last row within the bounds. 
+        //The index is loaded on each iteration, as the directions may grow (and so move) it. 
+        std::vector<llvm::Value*> args = {
+            builder.CreateLoad(SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(), buildTableTreeStore(tableType, tableStore, treeIndex)), 
+            tableScan->build.cursorStore, 
+            toBits, 
+            llvm::ConstantInt::get(intType, llvm::APInt(32, tableScan->parse.to ? 1 : 0))
+        }; 
+        llvm::FunctionCallee coreTreeNext = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::BTREE_NEXT.create.name, TabiCore::BTREE_NEXT.build.functionType); 
+        row = builder.CreateCall(coreTreeNext, llvm::ArrayRef(args)); 
+        builder.CreateStore(row, tableScan->build.rowStore); 
+        builder.CreateCondBr(builder.CreateICmpSGE(row, llvm::ConstantInt::get(intType, llvm::APInt(32, 0))), directionStart, scanEnd); 
+    }
+    else
+    {
+        //Stop once we run out of rows. 
+        llvm::BasicBlock* check = llvm::BasicBlock::Create(llvmContext, "scan_check", llvmFunction); 
+        row = builder.CreateLoad(intType, tableScan->build.rowStore); 
+        builder.CreateCondBr(
+                builder.CreateICmpSLT(row, buildTableNumRows(tableType, tableStore)), 
+                check, scanEnd); 
+        //Skip unused rows, by testing the row's bit in the #use field. 
+        //The field pointers (and number of rows) are loaded on each iteration, rather than once before the loop, 
+        //so that they remain correct if the directions grow the table. 
+        builder.SetInsertPoint(check); 
+        llvm::Value* useField; 
+        {
+            std::vector<llvm::Value*> offsets = {
+                llvm::ConstantInt::get(intType, llvm::APInt(32, 0)),
+                llvm::ConstantInt::get(intType, llvm::APInt(32, 1))
+            }; 
+            useField = builder.CreateLoad(intType->getPointerTo(), builder.CreateGEP(tableType->common.build.llvmType, tableStore, llvm::ArrayRef(offsets))); 
+        }
+        llvm::Value* useWord; 
+        {
+            std::vector<llvm::Value*> offsets = {
+                builder.CreateLShr(row, llvm::ConstantInt::get(intType, llvm::APInt(32, 5)))
+            }; 
+            useWord = builder.CreateLoad(intType, builder.CreateGEP(intType, useField, llvm::ArrayRef(offsets))); 
+        }
+        llvm::Value* useBit = builder.CreateAnd(
+                builder.CreateLShr(useWord, builder.CreateAnd(row, llvm::ConstantInt::get(intType, llvm::APInt(32, 31)))),
+                llvm::ConstantInt::get(intType, llvm::APInt(32, 1))); 
+        builder.CreateCondBr(builder.CreateICmpNE(useBit, llvm::ConstantInt::get(intType, llvm::APInt(32, 0))), directionStart, next); 
+    }
+    //Expose the row's ID to the directions. 
+    builder.SetInsertPoint(directionStart); 
+    buildTableProfileCount(tableScan->parse.tableRef, TableType::PROFILE_SCANNED_ROWS); 
+    {
+        std::vector<llvm::Value*> offsets = {
+            llvm::ConstantInt::get(intType, llvm::APInt(32, 0)),
+            llvm::ConstantInt::get(intType, llvm::APInt(32, 0))
+        }; 
+        llvm::Value* idField = builder.CreateLoad(intType->getPointerTo(), builder.CreateGEP(tableType->common.build.llvmType, tableStore, llvm::ArrayRef(offsets))); 
+        offsets = { row }; 
+        llvm::Value* id = builder.CreateLoad(intType, builder.CreateGEP(intType, idField, llvm::ArrayRef(offsets))); 
+        builder.CreateStore(id, tableScan->parse.rowVariable->common.build.llvmStore); 
+    }
+    llvm::Value* stackState; 
+    {
+        llvm::FunctionCallee stackSave = hostSlab->build.llvmModule->getOrInsertFunction("llvm.stacksave", 
+                llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType->getPointerTo(), false)); 
+        stackState = builder.CreateCall(stackSave); 
+    }
+    buildBlock(tableScan->parse.scope); 
+    {
+        std::vector<llvm::Type*> argTypes = { SupportedPrimitives::NONE.common.build.llvmType->getPointerTo() }; 
+        llvm::FunctionCallee stackRestore = hostSlab->build.llvmModule->getOrInsertFunction("llvm.stackrestore", 
+                llvm::FunctionType::get(SupportedPrimitives::NONE.common.build.llvmType->getPointerTo(), llvm::ArrayRef(argTypes), false)); 
+        std::vector<llvm::Value*> args = { stackState }; 
+        builder.CreateCall(stackRestore, llvm::ArrayRef(args)); 
+    }
+    if(!builder.GetInsertBlock()->getTerminator()) builder.CreateBr(next); 
+    //Move on to the next row. The cursor of an ordered index has already moved on. 
+    builder.SetInsertPoint(next); 
+    if(!ordered)
+    {
+        builder.CreateStore(
+                builder.CreateAdd(builder.CreateLoad(intType, tableScan->build.rowStore), llvm::ConstantInt::get(intType, llvm::APInt(32, 1))),
+                tableScan->build.rowStore); 
+    }
+    builder.CreateBr(condition); 
+    builder.SetInsertPoint(scanEnd); 
+}
+
+void tabic::buildTableSelect(TableSelect* tableSelect)
+{
+    buildValueRef(tableSelect->parse.tableRef, nullptr); 
+    buildValueRef(tableSelect->parse.intoRef, nullptr); 
+    if(tableSelect->parse.countRef) buildValueRef(tableSelect->parse.countRef, nullptr); 
+    Type* tableType = tableSelect->parse.tableRef->common.parse.type; 
+    llvm::Value* tableStore = tableSelect->parse.tableRef->common.build.llvmStore; 
+    llvm::Type* intType = SupportedPrimitives::INT.common.build.llvmType; 
+    llvm::Function* llvmFunction = tableSelect->common.parse.hostFunction->common.build.llvmFunction; 
+    Slab* hostSlab = tableSelect->common.parse.hostFunction->create.hostSlab; 
+    llvm::Value* numRows = buildTableNumRows(tableType, tableStore); 
+    //The predicate can neither call functions nor change the table, so the field pointers are loaded once. 
+    tableSelect->build.fields.clear(); 
+    for(int i = 0; i < tableSelect->parse.fieldVariables.size(); i++)
+    {
+        llvm::Value* field = nullptr; 
+        if(i < 2 || tableSelect->parse.fieldVariables[i])
+        {
+            std::vector<llvm::Value*> offsets = {
+                llvm::ConstantInt::get(intType, llvm::APInt(32, 0)),
+                llvm::ConstantInt::get(intType, llvm::APInt(32, i))
+            }; 
+            field = builder.CreateLoad(tableType->table.parse.fields[i].type->common.build.llvmType->getPointerTo(),
+                    builder.CreateGEP(tableType->common.build.llvmType, tableStore, llvm::ArrayRef(offsets))); 
+        }
+        tableSelect->build.fields.push_back(field); 
+    }
+    llvm::Value* idField = tableSelect->build.fields[0]; 
+    llvm::Value* useField = tableSelect->build.fields[1]; 
+    Type* intoType = tableSelect->parse.intoRef->common.parse.type; 
+    llvm::Value* ids = builder.CreateLoad(intoType->common.build.llvmType, tableSelect->parse.intoRef->common.build.llvmStore); 
+    //No more IDs are written than the vector has elements, though all are still counted. 
+    llvm::Value* numElem = nullptr; 
+    if(intoType->vector.parse.numElem)
+    {
+        buildExpression(intoType->vector.parse.numElem); 
+        numElem = intoType->vector.parse.numElem->common.build.llvmValue; 
+    }
+    buildSelectInvariants(tableSelect->parse.predicate, tableSelect); 
+    llvm::Value* numWords = builder.CreateLShr(
+            builder.CreateAdd(numRows, llvm::ConstantInt::get(intType, llvm::APInt(32, 31))),
+            llvm::ConstantInt::get(intType, llvm::APInt(32, 5))); 
+    builder.CreateStore(llvm::ConstantInt::get(intType, llvm::APInt(32, 0)), tableSelect->build.wordStore); 
+    builder.CreateStore(llvm::ConstantInt::get(intType, llvm::APInt(32, 0)), tableSelect->build.countStore); 
+    llvm::BasicBlock* condition = llvm::BasicBlock::Create(llvmContext, "select_condition", llvmFunction); 
+    llvm::BasicBlock* check = llvm::BasicBlock::Create(llvmContext, "select_check", llvmFunction); 
+    llvm::BasicBlock* test = llvm::BasicBlock::Create(llvmContext, "select_test", llvmFunction); 
+    llvm::BasicBlock* full = llvm::BasicBlock::Create(llvmContext, "select_full", llvmFunction); 
+    llvm::BasicBlock* partial = llvm::BasicBlock::Create(llvmContext, "select_partial", llvmFunction); 
+    llvm::BasicBlock* collect = llvm::BasicBlock::Create(llvmContext, "select_collect", llvmFunction); 
+    llvm::BasicBlock* emitCheck = llvm::BasicBlock::Create(llvmContext, "select_emit_check", llvmFunction); 
+    llvm::BasicBlock* emit = llvm::BasicBlock::Create(llvmContext, "select_emit", llvmFunction); 
+    llvm::BasicBlock* next = llvm::BasicBlock::Create(llvmContext, "select_next", llvmFunction); 
+    llvm::BasicBlock* selectEnd = llvm::BasicBlock::Create(llvmContext, "select_end", llvmFunction); 
+    builder.CreateBr(condition); 
+    //Stop once we run out of words. 
+    builder.SetInsertPoint(condition); 
+    llvm::Value* word = builder.CreateLoad(intType, tableSelect->build.wordStore); 
+    builder.CreateCondBr(builder.CreateICmpSLT(word, numWords), check, selectEnd); 
+    //Skip words with no used rows, without touching the fields. 
+    builder.SetInsertPoint(check); 
+    llvm::Value* useWord; 
+    {
+        std::vector<llvm::Value*> offsets = { word }; 
+        useWord = builder.CreateLoad(intType, builder.CreateGEP(intType, useField, llvm::ArrayRef(offsets))); 
+    }
+    builder.CreateCondBr(builder.CreateICmpNE(useWord, llvm::ConstantInt::get(intType, llvm::APInt(32, 0))), test, next); 
+    //Only the last word may cover rows past the end of the table, which must not be read. 
+    builder.SetInsertPoint(test); 
+    llvm::Value* base = builder.CreateShl(word, llvm::ConstantInt::get(intType, llvm::APInt(32, 5))); 
+    builder.CreateCondBr(
+            builder.CreateICmpSLE(builder.CreateAdd(base, llvm::ConstantInt::get(intType, llvm::APInt(32, 32))), numRows),
+            full, partial); 
+    //The vector of Truth for 32 rows is the bitmask of the rows for which the predicate holds. 
+    builder.SetInsertPoint(full); 
+    builder.CreateStore(
+            builder.CreateBitCast(buildSelectPredicate(tableSelect->parse.predicate, tableSelect, base, nullptr), intType),
+            tableSelect->build.bitsStore); 
+    builder.CreateBr(collect); 
+    builder.SetInsertPoint(partial); 
+    {
+        std::vector<uint32_t> lanes = {}; 
+        for(uint32_t i = 0; i < TableSelect::LANES; i++) lanes.push_back(i); 
+        llvm::Value* rowMask = builder.CreateICmpSLT(
+                llvm::ConstantDataVector::get(llvmContext, llvm::ArrayRef(lanes)),
+                builder.CreateVectorSplat(TableSelect::LANES, builder.CreateSub(numRows, base))); 
+        builder.CreateStore(
+                builder.CreateBitCast(buildSelectPredicate(tableSelect->parse.predicate, tableSelect, base, rowMask), intType),
+                tableSelect->build.bitsStore); 
+    }
+    builder.CreateBr(collect); 
+    builder.SetInsertPoint(collect); 
+    builder.CreateStore(builder.CreateAnd(builder.CreateLoad(intType, tableSelect->build.bitsStore), useWord), tableSelect->build.bitsStore); 
+    builder.CreateBr(emitCheck); 
+    //Write out the ID of each selected row, lowest bit first so that rows stay in order. 
+    builder.SetInsertPoint(emitCheck); 
+    llvm::Value* bits = builder.CreateLoad(intType, tableSelect->build.bitsStore); 
+    builder.CreateCondBr(builder.CreateICmpNE(bits, llvm::ConstantInt::get(intType, llvm::APInt(32, 0))), emit, next); 
+    builder.SetInsertPoint(emit); 
+    llvm::Value* count = builder.CreateLoad(intType, tableSelect->build.countStore); 
+    if(numElem)
+    {
+        //Once the vector is full, the rest of the word is only counted. 
+        llvm::BasicBlock* emitWrite = llvm::BasicBlock::Create(llvmContext, "select_emit_write", llvmFunction); 
+        llvm::BasicBlock* emitFull = llvm::BasicBlock::Create(llvmContext, "select_emit_full", llvmFunction); 
+        builder.CreateCondBr(builder.CreateICmpSLT(count, numElem), emitWrite, emitFull); 
+        builder.SetInsertPoint(emitFull); 
+        std::vector<llvm::Type*> argTypes = { intType }; 
+        llvm::FunctionCallee countPopulation = hostSlab->build.llvmModule->getOrInsertFunction("llvm.ctpop.i32", 
+                llvm::FunctionType::get(intType, llvm::ArrayRef(argTypes), false)); 
+        std::vector<llvm::Value*> args = { bits }; 
+        builder.CreateStore(builder.CreateAdd(count, builder.CreateCall(countPopulation, llvm::ArrayRef(args))), tableSelect->build.countStore); 
+        builder.CreateBr(next); 
+        builder.SetInsertPoint(emitWrite); 
+    }
+    {
+        std::vector<llvm::Type*> argTypes = { intType, SupportedPrimitives::TRUTH.common.build.llvmType }; 
+        llvm::FunctionCallee countTrailingZeros = hostSlab->build.llvmModule->getOrInsertFunction("llvm.cttz.i32", 
+                llvm::FunctionType::get(intType, llvm::ArrayRef(argTypes), false)); 
+        std::vector<llvm::Value*> args = { bits, llvm::ConstantInt::getTrue(llvmContext) }; 
+        llvm::Value* row = builder.CreateAdd(base, builder.CreateCall(countTrailingZeros, llvm::ArrayRef(args))); 
+        std::vector<llvm::Value*> offsets = { row }; 
+        llvm::Value* id = builder.CreateLoad(intType, builder.CreateGEP(intType, idField, llvm::ArrayRef(offsets))); 
+        offsets = { count }; 
+        builder.CreateStore(id, builder.CreateGEP(intType, ids, llvm::ArrayRef(offsets))); 
+        builder.CreateStore(builder.CreateAdd(count, llvm::ConstantInt::get(intType, llvm::APInt(32, 1))), tableSelect->build.countStore); 
+        builder.CreateStore(builder.CreateAnd(bits, builder.CreateSub(bits, llvm::ConstantInt::get(intType, llvm::APInt(32, 1)))), tableSelect->build.bitsStore); 
+    }
+    builder.CreateBr(emitCheck); 
+    //Move on to the next word. 
+    builder.SetInsertPoint(next); 
+    builder.CreateStore(
+            builder.CreateAdd(builder.CreateLoad(intType, tableSelect->build.wordStore), llvm::ConstantInt::get(intType, llvm::APInt(32, 1))),
+            tableSelect->build.wordStore); 
+    builder.CreateBr(condition); 
+    builder.SetInsertPoint(selectEnd); 
+    if(tableSelect->parse.countRef)
+    {
+        builder.CreateStore(builder.CreateLoad(intType, tableSelect->build.countStore), tableSelect->parse.countRef->common.build.llvmStore); 
+    }
+}
+
+void tabic::buildSelectInvariants(Expression* expression, TableSelect* tableSelect)
+{
+    ExpressionClass expressionClass = expression->common.expressionClass; 
+    if(expressionClass == EXPRESSION_VARIABLE_VALUE 
+            && expression->variableValue.parse.ref->common.valueRefClass == VALUE_REF_VARIABLE
+            && expression->variableValue.parse.ref->variable.parse.variable->common.variableClass == VARIABLE_STACKED
+            && expression->variableValue.parse.ref->variable.parse.variable->stacked.parse.hostBlock == tableSelect->parse.scope)
+    {
+        //Fields are loaded by buildSelectPredicate. 
+        buildType(expression->common.parse.type); 
+    }
+    else if(expressionClass == EXPRESSION_BRACKETED)
+    {
+        buildType(expression->common.parse.type); 
+        buildSelectInvariants(expression->bracketed.parse.contents, tableSelect); 
+    }
+    else if(expressionClass == EXPRESSION_BINARY)
+    {
+        orderBinaryExpression(expression); 
+        buildType(expression->common.parse.type); 
+        buildSelectInvariants(expression->binary.parse.lhs, tableSelect); 
+        buildSelectInvariants(expression->binary.parse.rhs, tableSelect); 
+    }
+    else
+    {
+        //Anything else is the same for every row, so is only evaluated once. 
+        buildExpression(expression); 
+    }
+}
+
+llvm::Value* tabic::buildSelectPredicate(Expression* expression, TableSelect* tableSelect, llvm::Value* base, llvm::Value* rowMask)
+{
+    ExpressionClass expressionClass = expression->common.expressionClass; 
+    if(expressionClass == EXPRESSION_VARIABLE_VALUE 
+            && expression->variableValue.parse.ref->common.valueRefClass == VALUE_REF_VARIABLE
+            && expression->variableValue.parse.ref->variable.parse.variable->common.variableClass == VARIABLE_STACKED
+            && expression->variableValue.parse.ref->variable.parse.variable->stacked.parse.hostBlock == tableSelect->parse.scope)
+    {
+        Variable* variable = expression->variableValue.parse.ref->variable.parse.variable; 
+        int fieldIndex = 0; 
+        while((Variable*) tableSelect->parse.fieldVariables[fieldIndex] != variable) fieldIndex++; 
+        llvm::Type* elemType = expression->common.parse.type->common.build.llvmType; 
+        //A Truth takes up a whole byte within a field, but only a bit within a vector. 
+        llvm::Type* loadType = elemType->isIntegerTy(1) ? SupportedPrimitives::CHAR.common.build.llvmType : elemType; 
+        llvm::Type* vectorType = llvm::FixedVectorType::get(loadType, TableSelect::LANES); 
+        std::vector<llvm::Value*> offsets = { base }; 
+        llvm::Value* columnStore = builder.CreateBitCast(
+                builder.CreateGEP(elemType, tableSelect->build.fields[fieldIndex], llvm::ArrayRef(offsets)),
+                vectorType->getPointerTo()); 
+        llvm::Align align = tableSelect->common.parse.hostFunction->create.hostSlab->build.llvmModule->getDataLayout().getABITypeAlign(loadType); 
+        llvm::Value* column; 
+        if(rowMask) column = builder.CreateMaskedLoad(vectorType, columnStore, align, rowMask, llvm::Constant::getNullValue(vectorType)); 
+        else column = builder.CreateAlignedLoad(vectorType, columnStore, align); 
+        if(elemType->isIntegerTy(1)) column = builder.CreateTrunc(column, llvm::FixedVectorType::get(elemType, TableSelect::LANES)); 
+        return column; 
+    }
+    else if(expressionClass == EXPRESSION_BRACKETED)
+    {
+        return buildSelectPredicate(expression->bracketed.parse.contents, tableSelect, base, rowMask); 
+    }
+    else if(expressionClass == EXPRESSION_BINARY)
+    {
+        llvm::Value* lhs = buildSelectPredicate(expression->binary.parse.lhs, tableSelect, base, rowMask); 
+        llvm::Value* rhs = buildSelectPredicate(expression->binary.parse.rhs, tableSelect, base, rowMask); 
+        if(expression->binary.parse.op == BINARY_OP_DIV && expression->binary.parse.ep == EP_INT)
+        {
+            //Every lane is divided, including those of unused rows, which must not trap. 
+            rhs = builder.CreateSelect(
+                    builder.CreateICmpEQ(rhs, llvm::Constant::getNullValue(rhs->getType())), 
+                    llvm::ConstantInt::get(rhs->getType(), 1), 
+                    rhs); 
+        }
+        return buildBinaryOperation(expression->binary.parse.op, expression->binary.parse.ep, lhs, rhs); 
+    }
+    return builder.CreateVectorSplat(TableSelect::LANES, expression->common.build.llvmValue); 
+}
+
+void tabic::buildTableJoin(TableJoin* tableJoin)
+{
+    buildValueRef(tableJoin->parse.leftRef, nullptr); 
+    buildValueRef(tableJoin->parse.rightRef, nullptr); 
+    buildValueRef(tableJoin->parse.intoRef, nullptr); 
+    if(tableJoin->parse.countRef) buildValueRef(tableJoin->parse.countRef, nullptr); 
+    Slab* hostSlab = tableJoin->common.parse.hostFunction->create.hostSlab; 
+    llvm::Type* intType = SupportedPrimitives::INT.common.build.llvmType; 
+    Type* leftType = tableJoin->parse.leftRef->common.parse.type; 
+    Type* rightType = tableJoin->parse.rightRef->common.parse.type; 
+    Type* intoType = tableJoin->parse.intoRef->common.parse.type; 
+    llvm::Value* intoStore = tableJoin->parse.intoRef->common.build.llvmStore; 
+    llvm::Type* keyType = leftType->table.parse.fields[tableJoin->parse.leftFieldIndex].type->common.build.llvmType; 
+    llvm::DataLayout dl = hostSlab->build.llvmModule->getDataLayout(); 
+    std::vector<llvm::Value*> args = {
+        tableJoin->parse.leftRef->common.build.llvmStore,
+        buildTableNumRows(leftType, tableJoin->parse.leftRef->common.build.llvmStore),
+        llvm::ConstantInt::get(intType, llvm::APInt(32, tableJoin->parse.leftFieldIndex)),
+        tableJoin->parse.rightRef->common.build.llvmStore,
+        buildTableNumRows(rightType, tableJoin->parse.rightRef->common.build.llvmStore),
+        llvm::ConstantInt::get(intType, llvm::APInt(32, tableJoin->parse.rightFieldIndex)),
+        llvm::ConstantInt::get(intType, llvm::APInt(32, dl.getTypeAllocSize(keyType))),
+        intoStore,
+        buildTableNumRows(intoType, intoStore),
+        llvm::ConstantInt::get(intType, llvm::APInt(32, intoType->table.parse.growable ? getTableMaxRows(intoType) : 0)),
+        llvm::ConstantInt::get(intType, llvm::APInt(32, getTableNumArrays(intoType))),
+        buildTableFieldSizes(intoType, hostSlab)
+    };
+    llvm::FunctionCallee coreJoinHash = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::JOIN_HASH.create.name, TabiCore::JOIN_HASH.build.functionType); 
+    llvm::Value* numPairs = builder.CreateCall(coreJoinHash, llvm::ArrayRef(args)); 
+    if(tableJoin->parse.countRef) builder.CreateStore(numPairs, tableJoin->parse.countRef->common.build.llvmStore); 
+    //The rows are inserted by tabi_core, which knows nothing of the output's key indexes, so they are built afresh. 
+    if(intoType->table.parse.growable) buildTableKeyIndexReserve(intoType, intoStore, hostSlab, buildTableNumRows(intoType, intoStore)); 
+    buildTableKeyIndexRebuild(intoType, intoStore, hostSlab); 
+}
+
+void tabic::buildTableGroup(TableGroup* tableGroup)
+{
+    buildValueRef(tableGroup->parse.tableRef, nullptr); 
+    buildValueRef(tableGroup->parse.intoRef, nullptr); 
+    if(tableGroup->parse.countRef) buildValueRef(tableGroup->parse.countRef, nullptr); 
+    Slab* hostSlab = tableGroup->common.parse.hostFunction->create.hostSlab; 
+    llvm::Function* llvmFunction = tableGroup->common.parse.hostFunction->common.build.llvmFunction; 
+    llvm::Type* intType = SupportedPrimitives::INT.common.build.llvmType; 
+    Type* tableType = tableGroup->parse.tableRef->common.parse.type; 
+    llvm::Value* tableStore = tableGroup->parse.tableRef->common.build.llvmStore; 
+    Type* intoType = tableGroup->parse.intoRef->common.parse.type; 
+    llvm::Value* intoStore = tableGroup->parse.intoRef->common.build.llvmStore; 
+    llvm::DataLayout dl = hostSlab->build.llvmModule->getDataLayout(); 
+    llvm::Value* numRows = buildTableNumRows(tableType, tableStore); 
+    //The group of each row is found by tabi_core. 
+    llvm::Value* groups; 
+    {
+        llvm::FunctionCallee coreAlloc = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::ALLOC.create.name, TabiCore::ALLOC.build.functionType); 
+        std::vector<llvm::Value*> args = { builder.CreateMul(buildSizeCast(numRows), llvm::ConstantInt::get(SupportedPrimitives::SIZE.common.build.llvmType, dl.getTypeAllocSize(intType))) }; 
+        groups = builder.CreateBitCast(builder.CreateCall(coreAlloc, llvm::ArrayRef(args)), intType->getPointerTo()); 
+    }
+    {
+        llvm::Type* keyType = tableType->table.parse.fields[tableGroup->parse.keyFieldIndex].type->common.build.llvmType; 
+        std::vector<llvm::Value*> args = {
+            tableStore,
+            numRows,
+            llvm::ConstantInt::get(intType, llvm::APInt(32, tableGroup->parse.keyFieldIndex)),
+            llvm::ConstantInt::get(intType, llvm::APInt(32, dl.getTypeAllocSize(keyType))),
+            intoStore,
+            buildTableNumRows(intoType, intoStore),
+            llvm::ConstantInt::get(intType, llvm::APInt(32, intoType->table.parse.growable ? getTableMaxRows(intoType) : 0)),
+            llvm::ConstantInt::get(intType, llvm::APInt(32, getTableNumArrays(intoType))),
+            buildTableFieldSizes(intoType, hostSlab),
+            groups
+        };
+        llvm::FunctionCallee coreGroupHash = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::GROUP_HASH.create.name, TabiCore::GROUP_HASH.build.functionType); 
+        llvm::Value* numGroups = builder.CreateCall(coreGroupHash, llvm::ArrayRef(args)); 
+        if(tableGroup->parse.countRef) builder.CreateStore(numGroups, tableGroup->parse.countRef->common.build.llvmStore); 
+    }
+    //The output may have grown, so its fields are only loaded now. 
+    std::vector<llvm::Value*> fields; 
+    std::vector<llvm::Value*> intoFields; 
+    for(int i = 0; i < tableGroup->parse.aggregates.size(); i++)
+    {
+        GroupAggregate &aggregate = tableGroup->parse.aggregates[i]; 
+        int intoIndex = TableType::NUM_META_FIELDS + 1 + i; 
+        std::vector<llvm::Value*> offsets = {
+            llvm::ConstantInt::get(intType, llvm::APInt(32, 0)),
+            llvm::ConstantInt::get(intType, llvm::APInt(32, intoIndex))
+        }; 
+        intoFields.push_back(builder.CreateLoad(intoType->table.parse.fields[intoIndex].type->common.build.llvmType->getPointerTo(),
+                builder.CreateGEP(intoType->common.build.llvmType, intoStore, llvm::ArrayRef(offsets)))); 
+        llvm::Value* field = nullptr; 
+        if(aggregate.op != AGGREGATE_COUNT)
+        {
+            offsets[1] = llvm::ConstantInt::get(intType, llvm::APInt(32, aggregate.fieldIndex)); 
+            field = builder.CreateLoad(tableType->table.parse.fields[aggregate.fieldIndex].type->common.build.llvmType->getPointerTo(),
+                    builder.CreateGEP(tableType->common.build.llvmType, tableStore, llvm::ArrayRef(offsets))); 
+        }
+        fields.push_back(field); 
+    }
+    //Then every row is folded into its group, each group starting from its first row. 
+    llvm::BasicBlock* condition = llvm::BasicBlock::Create(llvmContext, "group_condition", llvmFunction); 
+    llvm::BasicBlock* check = llvm::BasicBlock::Create(llvmContext, "group_check", llvmFunction); 
+    llvm::BasicBlock* fold = llvm::BasicBlock::Create(llvmContext, "group_fold", llvmFunction); 
+    llvm::BasicBlock* next = llvm::BasicBlock::Create(llvmContext, "group_next", llvmFunction); 
+    llvm::BasicBlock* groupEnd = llvm::BasicBlock::Create(llvmContext, "group_end", llvmFunction); 
+    builder.CreateStore(llvm::ConstantInt::get(intType, llvm::APInt(32, 0)), tableGroup->build.rowStore); 
+    builder.CreateBr(condition); 
+    builder.SetInsertPoint(condition); 
+    llvm::Value* row = builder.CreateLoad(intType, tableGroup->build.rowStore); 
+    builder.CreateCondBr(builder.CreateICmpSLT(row, numRows), check, groupEnd); 
+    builder.SetInsertPoint(check); 
+    llvm::Value* group; 
+    {
+        std::vector<llvm::Value*> offsets = { row }; 
+        group = builder.CreateLoad(intType, builder.CreateGEP(intType, groups, llvm::ArrayRef(offsets))); 
+    }
+    builder.CreateCondBr(builder.CreateICmpEQ(group, llvm::ConstantInt::get(intType, llvm::APInt(32, TableGroup::SKIP, true))), next, fold); 
+    builder.SetInsertPoint(fold); 
+    llvm::Value* first = builder.CreateICmpSLT(group, llvm::ConstantInt::get(intType, llvm::APInt(32, 0))); 
+    llvm::Value* intoRow = builder.CreateSelect(first, builder.CreateSub(llvm::ConstantInt::get(intType, llvm::APInt(32, -1, true)), group), group); 
+    for(int i = 0; i < tableGroup->parse.aggregates.size(); i++)
+    {
+        GroupAggregate &aggregate = tableGroup->parse.aggregates[i]; 
+        llvm::Type* accType = intoType->table.parse.fields[TableType::NUM_META_FIELDS + 1 + i].type->common.build.llvmType; 
+        std::vector<llvm::Value*> offsets = { intoRow }; 
+        llvm::Value* accStore = builder.CreateGEP(accType, intoFields[i], llvm::ArrayRef(offsets)); 
+        llvm::Value* acc = builder.CreateLoad(accType, accStore); 
+        llvm::Value* result; 
+        if(aggregate.op == AGGREGATE_COUNT)
+        {
+            result = builder.CreateSelect(first, 
+                    llvm::ConstantInt::get(intType, llvm::APInt(32, 1)), 
+                    builder.CreateAdd(acc, llvm::ConstantInt::get(intType, llvm::APInt(32, 1)))); 
+        }
+        else
+        {
+            offsets = { row }; 
+            llvm::Value* value = builder.CreateLoad(accType, builder.CreateGEP(accType, fields[i], llvm::ArrayRef(offsets))); 
+            EquivalentPrimitive ep = accType->isFloatingPointTy() ? EP_FLOAT : EP_INT; 
+            llvm::Value* combined; 
+            if(aggregate.op == AGGREGATE_SUM) combined = buildBinaryOperation(BINARY_OP_PLUS, ep, acc, value); 
+            else if(aggregate.op == AGGREGATE_MIN) combined = builder.CreateSelect(buildBinaryOperation(BINARY_OP_LT, ep, value, acc), value, acc); 
+            else combined = builder.CreateSelect(buildBinaryOperation(BINARY_OP_GT, ep, value, acc), value, acc); 
+            result = builder.CreateSelect(first, value, combined); 
+        }
+        builder.CreateStore(result, accStore); 
+    }
+    builder.CreateBr(next); 
+    builder.SetInsertPoint(next); 
+    builder.CreateStore(builder.CreateAdd(row, llvm::ConstantInt::get(intType, llvm::APInt(32, 1))), tableGroup->build.rowStore); 
+    builder.CreateBr(condition); 
+    builder.SetInsertPoint(groupEnd); 
+    {
+        llvm::FunctionCallee coreDealloc = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::DEALLOC.create.name, TabiCore::DEALLOC.build.functionType); 
+        std::vector<llvm::Value*> args = { builder.CreateBitCast(groups, SupportedPrimitives::NONE.common.build.llvmType->getPointerTo()) }; 
+        builder.CreateCall(coreDealloc, llvm::ArrayRef(args)); 
+    }
+    if(intoType->table.parse.growable) buildTableKeyIndexReserve(intoType, intoStore, hostSlab, buildTableNumRows(intoType, intoStore)); 
+    buildTableKeyIndexRebuild(intoType, intoStore, hostSlab); 
 }
 
 void tabic::buildLabel(Label* label)
@@ -1901,6 +3232,15 @@ void tabic::buildUnheap(Unheap* unheap)
     }
 }
 
+void tabic::buildUnheapArena(UnheapArena* unheapArena)
+{
+    Slab* hostSlab = unheapArena->common.parse.hostFunction->create.hostSlab; 
+    buildValueRef(unheapArena->parse.arenaRef, nullptr); 
+    llvm::FunctionCallee coreArenaRelease = hostSlab->build.llvmModule->getOrInsertFunction(TabiCore::ARENA_RELEASE.create.name, TabiCore::ARENA_RELEASE.build.functionType); 
+    std::vector<llvm::Value*> args = { unheapArena->parse.arenaRef->common.build.llvmStore }; 
+    builder.CreateCall(coreArenaRelease, llvm::ArrayRef(args)); 
+}
+
 void tabic::deallocType(Type* type, llvm::Value* store, Function* hostFunction, bool deallocBase)
 {
     Slab* hostSlab = hostFunction->tabitha.create.hostSlab;
@@ -1993,23 +3333,21 @@ void tabic::deallocType(Type* type, llvm::Value* store, Function* hostFunction,
                 llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, fieldIndex)),
             };
             llvm::Value* fieldStore = builder.CreateGEP(type->common.build.llvmType, store, llvm::ArrayRef(offsets)); 
-            llvm::Value* arrayStore = builder.CreateLoad(field.type->common.build.llvmType->getPointerTo(), fieldStore); 
+            llvm::Value* arrayStore = builder.CreateLoad(getTableArrayElemType(type, fieldIndex)->getPointerTo(), fieldStore); 
             if(field.type->common.typeClass == TYPE_VECTOR || field.type->common.typeClass == TYPE_COLLECTION)
             {
                 buildExpression(type->table.parse.numRows); 
+                llvm::Value* numRows = buildTableNumRows(type, store); 
                 llvm::Value* indexStore = builder.CreateAlloca(SupportedPrimitives::INT.common.build.llvmType); 
                 builder.CreateStore(llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)), indexStore); 
                 llvm::BasicBlock* vecDeallocCondition = llvm::BasicBlock::Create(llvmContext, "field_dealloc_condition", hostFunction->common.build.llvmFunction); 
                 builder.CreateBr(vecDeallocCondition); 
                 builder.SetInsertPoint(vecDeallocCondition); 
                 llvm::Value* index = builder.CreateLoad(SupportedPrimitives::INT.common.build.llvmType, indexStore); 
-                llvm::Value* condition = builder.CreateICmpSLT(index, type->table.parse.numRows->common.build.llvmValue); 
+                llvm::Value* condition = builder.CreateICmpSLT(index, numRows); 
                 llvm::BasicBlock* vecDeallocBody = llvm::BasicBlock::Create(llvmContext, "field_dealloc_body", hostFunction->common.build.llvmFunction); 
                 builder.SetInsertPoint(vecDeallocBody); 
-                std::vector<llvm::Value*> offsets = {
-                    index
-                };
-                llvm::Value* elementPtr = builder.CreateGEP(field.type->common.build.llvmType, arrayStore, llvm::ArrayRef(offsets)); 
+                llvm::Value* elementPtr = buildTableElementStore(type, store, fieldIndex, index); 
                 if(field.type->common.typeClass == TYPE_VECTOR)
                 {
                     deallocType(field.type, elementPtr, hostFunction, false); 
@@ -2027,9 +3365,31 @@ void tabic::deallocType(Type* type, llvm::Value* store, Function* hostFunction,
                 builder.CreateCondBr(condition, vecDeallocBody, vecDeallocEnd); 
                 builder.SetInsertPoint(vecDeallocEnd); 
             }
+            //The records of a row major table are freed once every field has been through them. 
+            if(type->table.parse.rowMajor && fieldIndex >= TableType::NUM_META_FIELDS) continue; 
             std::vector<llvm::Value*> args = { arrayStore };
             builder.CreateCall(coreDealloc, llvm::ArrayRef(args)); 
         }
+        if(type->table.parse.rowMajor)
+        {
+            std::vector<llvm::Value*> offsets = {
+                llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, 0)),
+                llvm::ConstantInt::get(SupportedPrimitives::INT.common.build.llvmType, llvm::APInt(32, TableType::NUM_META_FIELDS)),
+            };
+            llvm::Value* fieldStore = builder.CreateGEP(type->common.build.llvmType, store, llvm::ArrayRef(offsets)); 
+            std::vector<llvm::Value*> args = { builder.CreateLoad(type->table.build.recordType->getPointerTo(), fieldStore) };
+            builder.CreateCall(coreDealloc, llvm::ArrayRef(args)); 
+        }
+        for(int hashIndex = 0; hashIndex < type->table.parse.indexedFields.size(); hashIndex++)
+        {
+            std::vector<llvm::Value*> args = { builder.CreateLoad(SupportedPrimitives::INT.common.build.llvmType->getPointerTo(), buildTableHashStore(type, store, hashIndex)) };
+            builder.CreateCall(coreDealloc, llvm::ArrayRef(args)); 
+        }
+        for(int treeIndex = 0; treeIndex < type->table.parse.orderedFields.size(); treeIndex++)
+        {
+            std::vector<llvm::Value*> args = { builder.CreateLoad(SupportedPrimitives::CHAR.common.build.llvmType->getPointerTo(), buildTableTreeStore(type, store, treeIndex)) };
+            builder.CreateCall(coreDealloc, llvm::ArrayRef(args)); 
+        }
         std::vector<llvm::Value*> args = { store };
         if(deallocBase) builder.CreateCall(coreDealloc, llvm::ArrayRef(args)); 
     }
@@ -2098,6 +3458,10 @@ void tabic::allocateHeapHandles(Block* block)
         {
             allocateHeapHandles(statement->loop.parse.directions);
         }
+        else if(statementClass == STATEMENT_TABLE_SCAN)
+        {
+            allocateHeapHandles(statement->tableScan.parse.scope);
+        }
     }
 }
 
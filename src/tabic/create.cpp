@@ -26,38 +26,65 @@ limitations under the License.
 #include<cpp-peglib/peglib.h>
 #include<cstdlib>
 
-static tabic::CreateStatus _createStatus = tabic::CREATE_STATUS_NONE; 
+static thread_local tabic::CreateStatus _createStatus = tabic::CREATE_STATUS_NONE; 
 
 #define CREATE_FAIL _createStatus = CREATE_STATUS_FAIL
 
 static std::string TABI_LIB = std::getenv("TABI_LIB"); 
 static std::string TABI_RES = std::getenv("TABI_RES");
-static std::vector<std::string> _libPaths = {}; 
+static thread_local std::vector<std::string> _libPaths = {}; 
 
-tabic::PrimitiveType tabic::SupportedPrimitives::SIZE; 
-tabic::PrimitiveType tabic::SupportedPrimitives::INT;
-tabic::PrimitiveType tabic::SupportedPrimitives::FLOAT;
-tabic::PrimitiveType tabic::SupportedPrimitives::CHAR;
-tabic::PrimitiveType tabic::SupportedPrimitives::TRUTH; 
-tabic::PrimitiveType tabic::SupportedPrimitives::NONE; 
-tabic::PrimitiveType tabic::SupportedPrimitives::LONG; 
-tabic::PrimitiveType tabic::SupportedPrimitives::SHORT; 
-tabic::PrimitiveType tabic::SupportedPrimitives::DOUBLE;
+thread_local tabic::PrimitiveType tabic::SupportedPrimitives::SIZE; 
+thread_local tabic::PrimitiveType tabic::SupportedPrimitives::INT;
+thread_local tabic::PrimitiveType tabic::SupportedPrimitives::FLOAT;
+thread_local tabic::PrimitiveType tabic::SupportedPrimitives::CHAR;
+thread_local tabic::PrimitiveType tabic::SupportedPrimitives::TRUTH; 
+thread_local tabic::PrimitiveType tabic::SupportedPrimitives::NONE; 
+thread_local tabic::PrimitiveType tabic::SupportedPrimitives::LONG; 
+thread_local tabic::PrimitiveType tabic::SupportedPrimitives::SHORT; 
+thread_local tabic::PrimitiveType tabic::SupportedPrimitives::DOUBLE;
+thread_local tabic::PrimitiveType tabic::SupportedPrimitives::ARENA; 
 
-tabic::CoreFunction tabic::TabiCore::TABLE_INIT("core_table_init"); 
-tabic::CoreFunction tabic::TabiCore::TABLE_INSERT("core_table_insertRow"); 
-tabic::CoreFunction tabic::TabiCore::TABLE_GET_BY_ID("core_table_getRowByID"); 
-tabic::CoreFunction tabic::TabiCore::TABLE_DELETE_BY_ID("core_table_deleteRowByID");
-tabic::CoreFunction tabic::TabiCore::TABLE_GET_NUM_USED("core_table_getNumUsed"); 
-tabic::CoreFunction tabic::TabiCore::TABLE_CRUNCH("core_table_crunch"); 
-tabic::CoreFunction tabic::TabiCore::ALLOC("core_alloc");
-tabic::CoreFunction tabic::TabiCore::DEALLOC("core_dealloc"); 
-tabic::CoreFunction tabic::TabiCore::MEMCPY("core_memcpy");
-tabic::CoreFunction tabic::TabiCore::SUBVECTOR_COPY("core_subvector_copy");
+thread_local tabic::CoreFunction tabic::TabiCore::TABLE_INIT("core_table_init"); 
+thread_local tabic::CoreFunction tabic::TabiCore::TABLE_INSERT("core_table_insertRow"); 
+thread_local tabic::CoreFunction tabic::TabiCore::TABLE_GET_BY_ID("core_table_getRowByID"); 
+thread_local tabic::CoreFunction tabic::TabiCore::TABLE_DELETE_BY_ID("core_table_deleteRowByID");
+thread_local tabic::CoreFunction tabic::TabiCore::TABLE_GET_NUM_USED("core_table_getNumUsed"); 
+thread_local tabic::CoreFunction tabic::TabiCore::TABLE_CRUNCH("core_table_crunch"); 
+thread_local tabic::CoreFunction tabic::TabiCore::TABLE_RESERVE("core_table_reserve"); 
+thread_local tabic::CoreFunction tabic::TabiCore::TABLE_FIND_BY_ID("core_table_findRowByID"); 
+thread_local tabic::CoreFunction tabic::TabiCore::HASH_GET_SIZE("core_hash_getSize"); 
+thread_local tabic::CoreFunction tabic::TabiCore::HASH_INIT("core_hash_init"); 
+thread_local tabic::CoreFunction tabic::TabiCore::HASH_INSERT("core_hash_insert"); 
+thread_local tabic::CoreFunction tabic::TabiCore::HASH_REMOVE("core_hash_remove"); 
+thread_local tabic::CoreFunction tabic::TabiCore::HASH_FIND("core_hash_find"); 
+thread_local tabic::CoreFunction tabic::TabiCore::HASH_REBUILD("core_hash_rebuild"); 
+thread_local tabic::CoreFunction tabic::TabiCore::HASH_RESERVE("core_hash_reserve"); 
+thread_local tabic::CoreFunction tabic::TabiCore::BTREE_GET_SIZE("core_btree_getSize"); 
+thread_local tabic::CoreFunction tabic::TabiCore::BTREE_INIT("core_btree_init"); 
+thread_local tabic::CoreFunction tabic::TabiCore::BTREE_INSERT("core_btree_insert"); 
+thread_local tabic::CoreFunction tabic::TabiCore::BTREE_REMOVE("core_btree_remove"); 
+thread_local tabic::CoreFunction tabic::TabiCore::BTREE_REBUILD("core_btree_rebuild"); 
+thread_local tabic::CoreFunction tabic::TabiCore::BTREE_RESERVE("core_btree_reserve"); 
+thread_local tabic::CoreFunction tabic::TabiCore::BTREE_SEEK("core_btree_seek"); 
+thread_local tabic::CoreFunction tabic::TabiCore::BTREE_NEXT("core_btree_next"); 
+thread_local tabic::CoreFunction tabic::TabiCore::JOIN_HASH("core_join_hash"); 
+thread_local tabic::CoreFunction tabic::TabiCore::GROUP_HASH("core_group_hash"); 
+thread_local tabic::CoreFunction tabic::TabiCore::ALLOC("core_alloc");
+thread_local tabic::CoreFunction tabic::TabiCore::ALLOC_ALIGNED("core_alloc_aligned"); 
+thread_local tabic::CoreFunction tabic::TabiCore::DEALLOC("core_dealloc"); 
+thread_local tabic::CoreFunction tabic::TabiCore::ARENA_ALLOC("core_arena_alloc"); 
+thread_local tabic::CoreFunction tabic::TabiCore::ARENA_RELEASE("core_arena_release"); 
+thread_local tabic::CoreFunction tabic::TabiCore::STATS_REPORT("core_stats_report"); 
+thread_local tabic::CoreFunction tabic::TabiCore::STATS_REPORT_TABLE("core_stats_reportTable"); 
+thread_local tabic::CoreFunction tabic::TabiCore::MEMCPY("core_memcpy");
+thread_local tabic::CoreFunction tabic::TabiCore::SUBVECTOR_COPY("core_subvector_copy");
 
-static std::string _cwd; 
+static thread_local std::string _cwd; 
+//The sources of the Bundle being copied, if any. 
+static thread_local const std::map<std::string, std::string>* _sources = nullptr; 
 
-tabic::CreateStatus tabic::createBundle(std::string rootSlabFilename, std::string cwd, Bundle** bundle)
+tabic::CreateStatus tabic::createBundle(std::string rootSlabFilename, std::string cwd, Bundle** bundle, const std::map<std::string, std::string>* sources)
 {
     //get all _libPaths from TABI_LIB
     int k = 0;
@@ -77,6 +104,7 @@ tabic::CreateStatus tabic::createBundle(std::string rootSlabFilename, std::strin
 #endif
     _libPaths.push_back(TABI_LIB.substr(k0, TABI_LIB.length() - k0)); 
     _cwd = cwd; 
+    _sources = sources; 
     *bundle = new Bundle(rootSlabFilename); 
     //Create the PEG parser
     {
@@ -186,15 +214,19 @@ tabic::Slab* tabic::createSlab(std::string id, Bundle* hostBundle)
     try
     {
         //Now read source code into slab->create.source
-        slab->create.source = Util::readFile(slab->create.filepath); 
-        slab->create.source = preprocess(slab->create.source);  
+        if(_sources && _sources->count(slab->create.id)) slab->create.source = _sources->at(slab->create.id); 
+        else
+        {
+            slab->create.source = Util::readFile(slab->create.filepath); 
+            slab->create.source = preprocess(slab->create.source);  
+        }
         //Create PEG AST for the slab
         if(!hostBundle->create.pegParser->parse(slab->create.source, slab->create.ast))
         {
             std::cerr << "Slab: " << slab->create.id << std::endl; 
         } 
         if(_createStatus == CREATE_STATUS_FAIL) return slab;  //return early if there were source parsing errors
-        if(Util::flags["show-ast"])
+        if(!_sources && Util::flags.at("show-ast"))
         {
             std::cout << peg::ast_to_s(slab->create.ast) << std::endl; 
         }
@@ -18,7 +18,7 @@ limitations under the License.
 
 //a flag to indicate whether or not the parsing stage was successful
 //if not successful, the building stage should not be started
-static tabic::ParseStatus _parseStatus = tabic::PARSE_STATUS_NONE; 
+static thread_local tabic::ParseStatus _parseStatus = tabic::PARSE_STATUS_NONE; 
 
 #define PARSE_FAIL _parseStatus = tabic::PARSE_STATUS_FAIL
 
@@ -165,6 +165,10 @@ tabic::Type* tabic::getOrCreateType(ASTNode node, Block* hostBlock, Slab* hostSl
         {
             return (Type*) &SupportedPrimitives::NONE; 
         }
+        NODE_OP(primitiveNode, arenaNode, "ARENA_TYPE")
+        {
+            return (Type*) &SupportedPrimitives::ARENA; 
+        }
     }
     //If we have a NAMED_TYPE, then we have to establish the host slab and the 
     //type alias
@@ -243,27 +247,76 @@ tabic::Type* tabic::getOrCreateType(ASTNode node, Block* hostBlock, Slab* hostSl
     {
         TableType* tableType = new TableType(); 
         tableType->parse.fields.push_back(TableField{(Type*)&SupportedPrimitives::INT, "id"}); 
-        tableType->parse.fields.push_back(TableField{(Type*)&SupportedPrimitives::INT, "use"}); 
-        NODE_LOOP(tableTypeNode, tableSub)
+        //The occupancy bitmap and id index cannot be named in source, since '#' is not valid in a VARIABLE_NAME.
+        tableType->parse.fields.push_back(TableField{(Type*)&SupportedPrimitives::INT, "#use"}); 
+        tableType->parse.fields.push_back(TableField{(Type*)&SupportedPrimitives::INT, "#index"}); 
+        try
         {
-            NODE_CHECK(tableSub, "TABLE_FIELD")
+            NODE_LOOP(tableTypeNode, tableSub)
             {
-                TableField field;
-                NODE_OP(tableSub, typeNode, "TYPE_REF")
+                NODE_CHECK(tableSub, "TABLE_FIELD")
                 {
-                    field.type = getOrCreateType(typeNode, hostBlock, hostSlab);
+                    TableField field;
+                    NODE_OP(tableSub, typeNode, "TYPE_REF")
+                    {
+                        field.type = getOrCreateType(typeNode, hostBlock, hostSlab);
+                    }
+                    NODE_OP(tableSub, nameNode, "VARIABLE_NAME")
+                    {
+                        field.name = nameNode->token_to_string();
+                    }
+                    NODE_OP(tableSub, indexedNode, "INDEXED")
+                    {
+                        if(!isHashable(field.type)) throw IndexedFieldNotHashable(indexedNode->line, indexedNode->column); 
+                        field.indexed = true; 
+                        tableType->parse.indexedFields.push_back(tableType->parse.fields.size()); 
+                    }
+                    NODE_OP(tableSub, orderedNode, "ORDERED")
+                    {
+                        Type* keyType = field.type; 
+                        while(keyType && keyType->common.typeClass == TYPE_ALIAS) keyType = keyType->alias.parse.repType; 
+                        bool orderable = keyType && keyType->common.typeClass == TYPE_PRIMITIVE
+                                && keyType != (Type*) &SupportedPrimitives::NONE; 
+                        if(!orderable) throw OrderedFieldNotOrderable(orderedNode->line, orderedNode->column); 
+                        field.ordered = true; 
+                        tableType->parse.orderedFields.push_back(tableType->parse.fields.size()); 
+                    }
+                    tableType->parse.fields.push_back(field); 
                 }
-                NODE_OP(tableSub, nameNode, "VARIABLE_NAME")
+                NODE_CHECK(tableSub, "GROWABLE")
                 {
-                    field.name = nameNode->token_to_string();
+                    tableType->parse.growable = true; 
+                }
+                NODE_CHECK(tableSub, "ROW_MAJOR")
+                {
+                    tableType->parse.rowMajor = true; 
+                    //The key indexes read their fields from tabi_core as plain arrays. 
+                    if(!tableType->parse.indexedFields.empty() || !tableType->parse.orderedFields.empty()) throw RowMajorUnsupported(tableSub->line, tableSub->column); 
+                }
+                NODE_CHECK(tableSub, "EXPRESSION")
+                {
+                    tableType->parse.numRows = parseExpression(tableSub, hostBlock, hostSlab);
                 }
-                tableType->parse.fields.push_back(field); 
-            }
-            NODE_CHECK(tableSub, "EXPRESSION")
-            {
-                tableType->parse.numRows = parseExpression(tableSub, hostBlock, hostSlab);
-            }
 
+            }
+        }
+        catch(IndexedFieldNotHashable ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+            PARSE_FAIL;
+        }
+        catch(OrderedFieldNotOrderable ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+            PARSE_FAIL;
+        }
+        catch(RowMajorUnsupported ex)
+        {
+            std::cerr << ex.what() << std::endl;
+            std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+            PARSE_FAIL;
         }
         return (Type*) tableType;
     }
@@ -435,6 +488,22 @@ tabic::Block* tabic::parseBlock(ASTNode node, Block* parentBlock, TabithaFunctio
             {
                 statement = (Statement*) parseTableCrunch(crunchNode, block); 
             }
+            NODE_OP(blockSub, scanNode, "TABLE_SCAN")
+            {
+                statement = (Statement*) parseTableScan(scanNode, block); 
+            }
+            NODE_OP(blockSub, selectNode, "TABLE_SELECT")
+            {
+                statement = (Statement*) parseTableSelect(selectNode, block); 
+            }
+            NODE_OP(blockSub, joinNode, "TABLE_JOIN")
+            {
+                statement = (Statement*) parseTableJoin(joinNode, block); 
+            }
+            NODE_OP(blockSub, groupNode, "TABLE_GROUP")
+            {
+                statement = (Statement*) parseTableGroup(groupNode, block); 
+            }
             NODE_OP(blockSub, labelNode, "LABEL")
             {
                 statement = (Statement*) parseLabel(labelNode, block); 
@@ -443,6 +512,10 @@ tabic::Block* tabic::parseBlock(ASTNode node, Block* parentBlock, TabithaFunctio
             {
                 statement = (Statement*) parseUnheap(unheapNode, block); 
             }
+            NODE_OP(blockSub, unheapArenaNode, "UNHEAP_ARENA")
+            {
+                statement = (Statement*) parseUnheapArena(unheapArenaNode, block); 
+            }
             NODE_OP(blockSub, subBlockNode, "BLOCK")
             {
                 statement = (Statement*) parseBlock(subBlockNode, block, hostFunction); 
@@ -624,6 +697,17 @@ tabic::Expression* tabic::parseSingletonExpression(ASTNode node, Block* hostBloc
         }
         return (Expression*) value; 
     }
+    NODE_OP(node, aggregateNode, "AGGREGATE")
+    {
+        //Aggregates refer to tables by name, so need a Block to look them up in. 
+        if(!hostBlock) throw ExpressionNotRecognised(aggregateNode->line, aggregateNode->column); 
+        return (Expression*) parseAggregate(aggregateNode, hostBlock); 
+    }
+    NODE_OP(node, lookupNode, "LOOKUP")
+    {
+        if(!hostBlock) throw ExpressionNotRecognised(lookupNode->line, lookupNode->column); 
+        return (Expression*) parseLookup(lookupNode, hostBlock); 
+    }
     NODE_OP(node, functionNode, "FUNCTION_CALL")
     {
         FunctionCall* call = new FunctionCall(functionNode, hostBlock, hostSlab); 
@@ -829,6 +913,144 @@ tabic::Expression* tabic::parseExpression(ASTNode node, Block* hostBlock, Slab*
     return nullptr;
 }
 
+tabic::Aggregate* tabic::parseAggregate(ASTNode node, Block* hostBlock)
+{
+    Aggregate* aggregate = new Aggregate(node, hostBlock, nullptr); 
+    try
+    {
+        NODE_OP(node, opNode, "AGGREGATE_OP")
+        {
+            NODE_OP(opNode, sumNode, "AGGREGATE_SUM") aggregate->parse.op = AGGREGATE_SUM; 
+            NODE_OP(opNode, minNode, "AGGREGATE_MIN") aggregate->parse.op = AGGREGATE_MIN; 
+            NODE_OP(opNode, maxNode, "AGGREGATE_MAX") aggregate->parse.op = AGGREGATE_MAX; 
+            NODE_OP(opNode, meanNode, "AGGREGATE_MEAN") aggregate->parse.op = AGGREGATE_MEAN; 
+            NODE_OP(opNode, countNode, "AGGREGATE_COUNT") aggregate->parse.op = AGGREGATE_COUNT; 
+        }
+        NODE_OP(node, fieldNode, "VARIABLE_NAME")
+        {
+            aggregate->parse.fieldName = fieldNode->token_to_string(); 
+        }
+        NODE_OP(node, tableRefNode, "TABLE_REF")
+        {
+            aggregate->parse.tableRef = parseValueRef(tableRefNode->nodes[0], hostBlock); 
+            if(!aggregate->parse.tableRef) return nullptr; 
+            if(aggregate->parse.tableRef->common.parse.type->common.typeClass != TYPE_TABLE) throw TableRefNotTable(tableRefNode->line, tableRefNode->column); 
+            if(aggregate->parse.tableRef->common.parse.type->table.parse.rowMajor) throw RowMajorUnsupported(tableRefNode->line, tableRefNode->column); 
+        }
+        Type* tableType = aggregate->parse.tableRef->common.parse.type; 
+        Type* fieldType = nullptr; 
+        for(int i = 0; i < tableType->table.parse.fields.size(); i++)
+        {
+            if(tableType->table.parse.fields[i].name == aggregate->parse.fieldName)
+            {
+                aggregate->parse.fieldIndex = i; 
+                fieldType = tableType->table.parse.fields[i].type; 
+            }
+        }
+        if(!fieldType) throw FieldNotFound(tableType, aggregate->parse.fieldName, node->line, node->column); 
+        std::vector<std::pair<std::string, Type*>> numericTypes = {
+            {"Int", (Type*) &SupportedPrimitives::INT},
+            {"Long", (Type*) &SupportedPrimitives::LONG},
+            {"Short", (Type*) &SupportedPrimitives::SHORT},
+            {"Float", (Type*) &SupportedPrimitives::FLOAT},
+            {"Double", (Type*) &SupportedPrimitives::DOUBLE},
+            {"Size", (Type*) &SupportedPrimitives::SIZE}
+        };
+        for(auto &pair : numericTypes)
+        {
+            if(typesMatch(fieldType, pair.second)) aggregate->parse.elemName = pair.first; 
+        }
+        if(aggregate->parse.elemName == "") throw AggregateFieldNotNumeric(node->line, node->column); 
+        if(aggregate->parse.op == AGGREGATE_MEAN) aggregate->common.parse.type = (Type*) &SupportedPrimitives::DOUBLE; 
+        else if(aggregate->parse.op == AGGREGATE_COUNT) aggregate->common.parse.type = (Type*) &SupportedPrimitives::INT; 
+        else aggregate->common.parse.type = fieldType; 
+        return aggregate; 
+    }
+    catch(TableRefNotTable ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(FieldNotFound ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(AggregateFieldNotNumeric ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(RowMajorUnsupported ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    return nullptr; 
+}
+
+tabic::Lookup* tabic::parseLookup(ASTNode node, Block* hostBlock)
+{
+    Lookup* lookup = new Lookup(node, hostBlock, nullptr); 
+    try
+    {
+        NODE_OP(node, fieldNode, "VARIABLE_NAME")
+        {
+            lookup->parse.fieldName = fieldNode->token_to_string(); 
+        }
+        NODE_OP(node, tableRefNode, "TABLE_REF")
+        {
+            lookup->parse.tableRef = parseValueRef(tableRefNode->nodes[0], hostBlock); 
+            if(!lookup->parse.tableRef) return nullptr; 
+            if(lookup->parse.tableRef->common.parse.type->common.typeClass != TYPE_TABLE) throw TableRefNotTable(tableRefNode->line, tableRefNode->column); 
+        }
+        Type* tableType = lookup->parse.tableRef->common.parse.type; 
+        for(int i = 0; i < tableType->table.parse.fields.size(); i++)
+        {
+            if(tableType->table.parse.fields[i].name == lookup->parse.fieldName) lookup->parse.fieldIndex = i; 
+        }
+        if(lookup->parse.fieldIndex == -1) throw FieldNotFound(tableType, lookup->parse.fieldName, node->line, node->column); 
+        TableField &field = tableType->table.parse.fields[lookup->parse.fieldIndex]; 
+        if(!field.indexed) throw LookupFieldNotIndexed(node->line, node->column); 
+        NODE_OP(node, keyNode, "EXPRESSION")
+        {
+            lookup->parse.key = parseExpression(keyNode, hostBlock, nullptr); 
+            if(!lookup->parse.key) return nullptr; 
+            if(!typesMatch(lookup->parse.key->common.parse.type, field.type)) throw LookupKeyMismatch(keyNode->line, keyNode->column); 
+        }
+        return lookup; 
+    }
+    catch(TableRefNotTable ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(FieldNotFound ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(LookupFieldNotIndexed ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(LookupKeyMismatch ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    return nullptr; 
+}
+
 tabic::StackedDeclaration* tabic::parseStackedDeclaration(ASTNode node, Block* hostBlock)
 {
     StackedDeclaration* declaration = new StackedDeclaration(node, hostBlock); 
@@ -840,6 +1062,8 @@ tabic::StackedDeclaration* tabic::parseStackedDeclaration(ASTNode node, Block* h
         NODE_OP(node, typeNode, "TYPE_REF")
         {
             declaration->parse.variable->common.parse.type = getOrCreateType(typeNode, hostBlock, hostSlab); 
+            //Growing a table frees its old fields, so they must be on the heap, wherever the table sits in the type. 
+            if(hasGrowableTable(declaration->parse.variable->common.parse.type)) throw GrowableTableStacked(typeNode->line, typeNode->column); 
         }
         NODE_OP(node, nameNode, "VARIABLE_NAME")
         {
@@ -864,6 +1088,12 @@ tabic::StackedDeclaration* tabic::parseStackedDeclaration(ASTNode node, Block* h
         std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
         PARSE_FAIL;
     }
+    catch(GrowableTableStacked ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
     return nullptr;
 }
 
@@ -883,6 +1113,13 @@ tabic::HeapedDeclaration* tabic::parseHeapedDeclaration(ASTNode node, Block* hos
         {
             declaration->parse.variable->common.parse.name = nameNode->token_to_string(); 
         }
+        //The arena is looked up before the variable is added, so that it cannot name itself. 
+        NODE_OP(node, arenaNode, "HEAP_ARENA")
+        {
+            declaration->parse.arenaRef = parseArenaRef(arenaNode->nodes[0], hostBlock); 
+            if(!declaration->parse.arenaRef) return nullptr; 
+            if(hasGrowableTable(declaration->parse.variable->common.parse.type)) throw ArenaTableGrowable(arenaNode->line, arenaNode->column); 
+        }
         //Make the variable accessible to subsequent statements in the Block, as well as any subsequent child blocks. 
         hostBlock->parse.variables[declaration->parse.variable->common.parse.name] = (Variable*) declaration->parse.variable; 
         NODE_OP(node, initNode, "EXPRESSION")
@@ -903,6 +1140,18 @@ tabic::HeapedDeclaration* tabic::parseHeapedDeclaration(ASTNode node, Block* hos
         std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
         PARSE_FAIL; 
     }
+    catch(ArenaRefNotArena ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL; 
+    }
+    catch(ArenaTableGrowable ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL; 
+    }
     return declaration;
 }
 
@@ -918,6 +1167,24 @@ tabic::Assignment* tabic::parseAssignment(ASTNode node, Block* hostBlock)
         {
             assignment->parse.ref = parseValueRef(refNode, hostBlock); 
             if(!assignment->parse.ref) return nullptr; 
+            if(assignment->parse.ref->common.valueRefClass == VALUE_REF_VARIABLE 
+                    && getTableScan(hostBlock, assignment->parse.ref->variable.parse.variable))
+            {
+                throw ScanRowAssigned(refNode->line, refNode->column); 
+            }
+            //A row whose ordering key moved forward would be met again by a TableScan in that order, and so could be visited forever. 
+            if(assignment->parse.ref->common.valueRefClass == VALUE_REF_ROW)
+            {
+                for(Block* block = hostBlock; block; block = block->common.parse.hostBlock)
+                {
+                    TableScan* scan = block->parse.scan; 
+                    if(scan && scan->parse.orderFieldIndex == assignment->parse.ref->row.parse.fieldIndex
+                            && refsMatch(scan->parse.tableRef, assignment->parse.ref->common.parse.parent))
+                    {
+                        throw ScanOrderAssigned(refNode->line, refNode->column); 
+                    }
+                }
+            }
         }
         NODE_OP(node, expressionNode, "EXPRESSION")
         {
@@ -936,6 +1203,18 @@ tabic::Assignment* tabic::parseAssignment(ASTNode node, Block* hostBlock)
         std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
         PARSE_FAIL;
     }
+    catch(ScanRowAssigned ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(ScanOrderAssigned ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
     return nullptr; 
 }
 
@@ -1177,6 +1456,16 @@ tabic::ValueRef* tabic::parseValueSubRef(ASTNode node, Block* block, ValueRef* p
         {
             throw IDNotInt(node->line, node->column);
         }
+        //If the ID is the row variable of a TableScan over this table, the row is already known. 
+        Expression* id = rowRef->parse.id; 
+        if(id->common.expressionClass == EXPRESSION_VARIABLE_VALUE 
+                && !id->variableValue.parse.locate
+                && id->variableValue.parse.ref->common.valueRefClass == VALUE_REF_VARIABLE
+                && !id->variableValue.parse.ref->common.parse.query)
+        {
+            TableScan* scan = getTableScan(block, id->variableValue.parse.ref->variable.parse.variable); 
+            if(scan && refsMatch(scan->parse.tableRef, parent)) rowRef->parse.scan = scan; 
+        }
         return (ValueRef*) rowRef; 
     }
     return nullptr; 
@@ -1766,6 +2055,14 @@ tabic::TableCrunch* tabic::parseTableCrunch(ASTNode node, Block* hostBlock)
             tableCrunch->parse.tableRef = parseValueRef(tableRefNode->nodes[0], hostBlock); 
             if(!tableCrunch->parse.tableRef) return nullptr; 
             if(tableCrunch->parse.tableRef->common.parse.type->common.typeClass != TYPE_TABLE) throw TableRefNotTable(tableRefNode->line, tableRefNode->column); 
+            //Crunching moves rows, so it would invalidate the current row of a TableScan over the same table. 
+            for(Block* block = hostBlock; block; block = block->common.parse.hostBlock)
+            {
+                if(block->parse.scan && refsMatch(block->parse.scan->parse.tableRef, tableCrunch->parse.tableRef))
+                {
+                    throw ScanTableCrunched(tableRefNode->line, tableRefNode->column); 
+                }
+            }
         }
         NODE_OP(node, valueRefNode, "VALUE_REF")
         {
@@ -1790,9 +2087,509 @@ tabic::TableCrunch* tabic::parseTableCrunch(ASTNode node, Block* hostBlock)
         std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
         PARSE_FAIL;
     }
+    catch(ScanTableCrunched ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
     return nullptr;
 }
 
+tabic::TableScan* tabic::parseTableScan(ASTNode node, Block* hostBlock)
+{
+    TableScan* tableScan = new TableScan(node, hostBlock); 
+    try
+    {
+        NODE_OP(node, tableRefNode, "TABLE_REF")
+        {
+            tableScan->parse.tableRef = parseValueRef(tableRefNode->nodes[0], hostBlock); 
+            if(!tableScan->parse.tableRef) return nullptr; 
+            if(tableScan->parse.tableRef->common.parse.type->common.typeClass != TYPE_TABLE) throw TableRefNotTable(tableRefNode->line, tableRefNode->column); 
+        }
+        //The bounds are evaluated once, outside of the row variable's Block. 
+        NODE_OP(node, orderNode, "SCAN_ORDER")
+        {
+            Type* tableType = tableScan->parse.tableRef->common.parse.type; 
+            NODE_OP(orderNode, fieldNode, "VARIABLE_NAME")
+            {
+                std::string fieldName = fieldNode->token_to_string(); 
+                for(int i = 0; i < tableType->table.parse.fields.size(); i++)
+                {
+                    if(tableType->table.parse.fields[i].name == fieldName) tableScan->parse.orderFieldIndex = i; 
+                }
+                if(tableScan->parse.orderFieldIndex == -1) throw FieldNotFound(tableType, fieldName, fieldNode->line, fieldNode->column); 
+                if(!tableType->table.parse.fields[tableScan->parse.orderFieldIndex].ordered) throw ScanFieldNotOrdered(fieldNode->line, fieldNode->column); 
+            }
+            Type* fieldType = tableType->table.parse.fields[tableScan->parse.orderFieldIndex].type; 
+            NODE_OP(orderNode, fromNode, "SCAN_FROM")
+            {
+                tableScan->parse.from = parseExpression(fromNode->nodes[0], hostBlock, nullptr); 
+                if(!tableScan->parse.from) return nullptr; 
+                if(!typesMatch(tableScan->parse.from->common.parse.type, fieldType)) throw ScanBoundMismatch(fromNode->line, fromNode->column); 
+            }
+            NODE_OP(orderNode, toNode, "SCAN_TO")
+            {
+                tableScan->parse.to = parseExpression(toNode->nodes[0], hostBlock, nullptr); 
+                if(!tableScan->parse.to) return nullptr; 
+                if(!typesMatch(tableScan->parse.to->common.parse.type, fieldType)) throw ScanBoundMismatch(toNode->line, toNode->column); 
+            }
+        }
+        //The row variable gets a Block of its own, so that it is visible to the directions but not after the TableScan. 
+        tableScan->parse.scope = new Block(node, hostBlock, hostBlock->common.parse.hostFunction); 
+        tableScan->parse.scope->parse.scan = tableScan; 
+        tableScan->parse.rowVariable = new StackedVariable(tableScan->parse.scope); 
+        tableScan->parse.rowVariable->common.parse.type = (Type*) &SupportedPrimitives::INT; 
+        NODE_OP(node, nameNode, "VARIABLE_NAME")
+        {
+            tableScan->parse.rowVariable->common.parse.name = nameNode->token_to_string(); 
+        }
+        tableScan->parse.scope->parse.variables[tableScan->parse.rowVariable->common.parse.name] = (Variable*) tableScan->parse.rowVariable; 
+        NODE_OP(node, directionsNode, "BLOCK")
+        {
+            tableScan->parse.directions = parseBlock(directionsNode, tableScan->parse.scope, nullptr); 
+            if(!tableScan->parse.directions) return nullptr; 
+            tableScan->parse.scope->parse.statements.push_back((Statement*) tableScan->parse.directions); 
+        }
+        return tableScan; 
+    }
+    catch(TableRefNotTable ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(FieldNotFound ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(ScanFieldNotOrdered ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(ScanBoundMismatch ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    return nullptr; 
+}
+
+tabic::TableScan* tabic::getTableScan(Block* block, Variable* variable)
+{
+    for(; block; block = block->common.parse.hostBlock)
+    {
+        if(block->parse.scan && (Variable*) block->parse.scan->parse.rowVariable == variable) return block->parse.scan; 
+    }
+    return nullptr; 
+}
+
+tabic::TableSelect* tabic::parseTableSelect(ASTNode node, Block* hostBlock)
+{
+    TableSelect* tableSelect = new TableSelect(node, hostBlock); 
+    try
+    {
+        NODE_OP(node, tableRefNode, "TABLE_REF")
+        {
+            tableSelect->parse.tableRef = parseValueRef(tableRefNode->nodes[0], hostBlock); 
+            if(!tableSelect->parse.tableRef) return nullptr; 
+            if(tableSelect->parse.tableRef->common.parse.type->common.typeClass != TYPE_TABLE) throw TableRefNotTable(tableRefNode->line, tableRefNode->column); 
+            if(tableSelect->parse.tableRef->common.parse.type->table.parse.rowMajor) throw RowMajorUnsupported(tableRefNode->line, tableRefNode->column); 
+        }
+        //Each primitive field is given a variable of the same name, visible only to the predicate. 
+        Type* tableType = tableSelect->parse.tableRef->common.parse.type; 
+        tableSelect->parse.scope = new Block(node, hostBlock, hostBlock->common.parse.hostFunction); 
+        tableSelect->parse.scope->parse.select = tableSelect; 
+        for(int i = 0; i < tableType->table.parse.fields.size(); i++)
+        {
+            TableField &field = tableType->table.parse.fields[i]; 
+            if(i == 1 || i == 2 || field.type->common.typeClass != TYPE_PRIMITIVE)
+            {
+                tableSelect->parse.fieldVariables.push_back(nullptr); 
+                continue; 
+            }
+            StackedVariable* fieldVariable = new StackedVariable(tableSelect->parse.scope); 
+            fieldVariable->common.parse.name = field.name; 
+            fieldVariable->common.parse.type = field.type; 
+            tableSelect->parse.scope->parse.variables[field.name] = (Variable*) fieldVariable; 
+            tableSelect->parse.fieldVariables.push_back(fieldVariable); 
+        }
+        NODE_OP(node, predicateNode, "EXPRESSION")
+        {
+            tableSelect->parse.predicate = parseExpression(predicateNode, tableSelect->parse.scope, nullptr); 
+            if(!tableSelect->parse.predicate) return nullptr; 
+            if(!typesMatch(tableSelect->parse.predicate->common.parse.type, (Type*) &SupportedPrimitives::TRUTH)) throw SelectPredicateNotTruth(predicateNode->line, predicateNode->column); 
+            checkSelectPredicate(tableSelect->parse.predicate, tableSelect); 
+        }
+        NODE_OP(node, intoNode, "SELECT_INTO")
+        {
+            tableSelect->parse.intoRef = parseValueRef(intoNode->nodes[0], hostBlock); 
+            if(!tableSelect->parse.intoRef) return nullptr; 
+            Type* intoType = tableSelect->parse.intoRef->common.parse.type; 
+            if(intoType->common.typeClass != TYPE_VECTOR || !typesMatch(intoType->vector.parse.elemType, (Type*) &SupportedPrimitives::INT)) 
+            {
+                throw SelectIntoNotIdVector(intoNode->line, intoNode->column); 
+            }
+            //Where both lengths are literal, a vector which could not hold every row of a fixed-size table is caught now. 
+            Expression* numElem = intoType->vector.parse.numElem; 
+            Expression* numRows = tableType->table.parse.numRows; 
+            if(!tableType->table.parse.growable && numElem && numRows 
+                    && numElem->common.expressionClass == EXPRESSION_INT_LITERAL && numRows->common.expressionClass == EXPRESSION_INT_LITERAL
+                    && numElem->intLiteral.parse.value < numRows->intLiteral.parse.value)
+            {
+                throw SelectIntoTooShort(intoNode->line, intoNode->column); 
+            }
+        }
+        NODE_OP(node, countNode, "SELECT_COUNT")
+        {
+            tableSelect->parse.countRef = parseValueRef(countNode->nodes[0], hostBlock); 
+            if(!tableSelect->parse.countRef) return nullptr; 
+            if(!typesMatch(tableSelect->parse.countRef->common.parse.type, (Type*) &SupportedPrimitives::INT)) throw MeasureNotInteger(countNode->line, countNode->column); 
+        }
+        return tableSelect; 
+    }
+    catch(TableRefNotTable ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(SelectPredicateNotTruth ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(SelectPredicateNotColumnar ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(SelectIntoNotIdVector ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(SelectIntoTooShort ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(RowMajorUnsupported ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(MeasureNotInteger ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    return nullptr; 
+}
+
+void tabic::checkSelectPredicate(Expression* expression, TableSelect* select)
+{
+    ASTNode node = expression->common.parse.node; 
+    ExpressionClass expressionClass = expression->common.expressionClass; 
+    if(expressionClass == EXPRESSION_FUNCTION_CALL)
+    {
+        //A function would be called for one row at a time, and might change the table. 
+        throw SelectPredicateNotColumnar(node->line, node->column); 
+    }
+    else if(expressionClass == EXPRESSION_VARIABLE_VALUE)
+    {
+        //The field variables only exist as columns, so have no address. 
+        ValueRef* ref = expression->variableValue.parse.ref; 
+        if(expression->variableValue.parse.locate 
+                && ref->common.valueRefClass == VALUE_REF_VARIABLE
+                && ref->variable.parse.variable->common.variableClass == VARIABLE_STACKED
+                && ref->variable.parse.variable->stacked.parse.hostBlock == select->parse.scope)
+        {
+            throw SelectPredicateNotColumnar(node->line, node->column); 
+        }
+    }
+    else if(expressionClass == EXPRESSION_BRACKETED)
+    {
+        checkSelectPredicate(expression->bracketed.parse.contents, select); 
+    }
+    else if(expressionClass == EXPRESSION_BINARY)
+    {
+        checkSelectPredicate(expression->binary.parse.lhs, select); 
+        checkSelectPredicate(expression->binary.parse.rhs, select); 
+    }
+}
+
+tabic::TableJoin* tabic::parseTableJoin(ASTNode node, Block* hostBlock)
+{
+    TableJoin* tableJoin = new TableJoin(node, hostBlock); 
+    try
+    {
+        NODE_OP(node, leftNode, "JOIN_LEFT")
+        {
+            if(!parseJoinSide(leftNode, hostBlock, tableJoin->parse.leftRef, tableJoin->parse.leftFieldIndex)) return nullptr; 
+        }
+        NODE_OP(node, rightNode, "JOIN_RIGHT")
+        {
+            if(!parseJoinSide(rightNode, hostBlock, tableJoin->parse.rightRef, tableJoin->parse.rightFieldIndex)) return nullptr; 
+        }
+        Type* leftKeyType = tableJoin->parse.leftRef->common.parse.type->table.parse.fields[tableJoin->parse.leftFieldIndex].type; 
+        Type* rightKeyType = tableJoin->parse.rightRef->common.parse.type->table.parse.fields[tableJoin->parse.rightFieldIndex].type; 
+        if(!typesMatch(leftKeyType, rightKeyType) || !isHashable(leftKeyType)) throw JoinKeyMismatch(node->line, node->column); 
+        NODE_OP(node, intoNode, "JOIN_INTO")
+        {
+            NODE_OP(intoNode, tableRefNode, "TABLE_REF")
+            {
+                tableJoin->parse.intoRef = parseValueRef(tableRefNode->nodes[0], hostBlock); 
+                if(!tableJoin->parse.intoRef) return nullptr; 
+                Type* intoType = tableJoin->parse.intoRef->common.parse.type; 
+                if(intoType->common.typeClass != TYPE_TABLE) throw TableRefNotTable(tableRefNode->line, tableRefNode->column); 
+                if(intoType->table.parse.rowMajor) throw RowMajorUnsupported(tableRefNode->line, tableRefNode->column); 
+                std::vector<TableField> &fields = intoType->table.parse.fields; 
+                if(fields.size() < TableType::NUM_META_FIELDS + 2
+                        || !typesMatch(fields[TableType::NUM_META_FIELDS].type, (Type*) &SupportedPrimitives::INT)
+                        || !typesMatch(fields[TableType::NUM_META_FIELDS + 1].type, (Type*) &SupportedPrimitives::INT))
+                {
+                    throw JoinIntoNotPairTable(intoNode->line, intoNode->column); 
+                }
+                //Writing into an input would change the rows being read, or free them if the table grows. 
+                if(refsMatch(tableJoin->parse.intoRef, tableJoin->parse.leftRef) || refsMatch(tableJoin->parse.intoRef, tableJoin->parse.rightRef))
+                {
+                    throw JoinIntoInput(intoNode->line, intoNode->column); 
+                }
+            }
+        }
+        NODE_OP(node, countNode, "JOIN_COUNT")
+        {
+            tableJoin->parse.countRef = parseValueRef(countNode->nodes[0], hostBlock); 
+            if(!tableJoin->parse.countRef) return nullptr; 
+            if(!typesMatch(tableJoin->parse.countRef->common.parse.type, (Type*) &SupportedPrimitives::INT)) throw MeasureNotInteger(countNode->line, countNode->column); 
+        }
+        return tableJoin; 
+    }
+    catch(TableRefNotTable ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(FieldNotFound ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(JoinKeyMismatch ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(JoinIntoNotPairTable ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(JoinIntoInput ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(RowMajorUnsupported ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(MeasureNotInteger ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    return nullptr; 
+}
+
+tabic::TableGroup* tabic::parseTableGroup(ASTNode node, Block* hostBlock)
+{
+    TableGroup* tableGroup = new TableGroup(node, hostBlock); 
+    try
+    {
+        NODE_OP(node, tableRefNode, "TABLE_REF")
+        {
+            tableGroup->parse.tableRef = parseValueRef(tableRefNode->nodes[0], hostBlock); 
+            if(!tableGroup->parse.tableRef) return nullptr; 
+            if(tableGroup->parse.tableRef->common.parse.type->common.typeClass != TYPE_TABLE) throw TableRefNotTable(tableRefNode->line, tableRefNode->column); 
+            if(tableGroup->parse.tableRef->common.parse.type->table.parse.rowMajor) throw RowMajorUnsupported(tableRefNode->line, tableRefNode->column); 
+        }
+        std::vector<TableField> &fields = tableGroup->parse.tableRef->common.parse.type->table.parse.fields; 
+        NODE_OP(node, keyNode, "VARIABLE_NAME")
+        {
+            std::string keyName = keyNode->token_to_string(); 
+            for(int i = 0; i < fields.size(); i++)
+            {
+                if(fields[i].name == keyName) tableGroup->parse.keyFieldIndex = i; 
+            }
+            if(tableGroup->parse.keyFieldIndex == -1) throw FieldNotFound(tableGroup->parse.tableRef->common.parse.type, keyName, keyNode->line, keyNode->column); 
+            if(!isHashable(fields[tableGroup->parse.keyFieldIndex].type)) throw GroupKeyNotHashable(keyNode->line, keyNode->column); 
+        }
+        //The Type of each field of the output, for checking against the output table. 
+        std::vector<Type*> intoTypes = { fields[tableGroup->parse.keyFieldIndex].type }; 
+        NODE_OP(node, aggregateNode, "GROUP_AGGREGATE")
+        {
+            GroupAggregate aggregate; 
+            NODE_OP(aggregateNode, sumNode, "AGGREGATE_SUM") aggregate.op = AGGREGATE_SUM; 
+            NODE_OP(aggregateNode, minNode, "AGGREGATE_MIN") aggregate.op = AGGREGATE_MIN; 
+            NODE_OP(aggregateNode, maxNode, "AGGREGATE_MAX") aggregate.op = AGGREGATE_MAX; 
+            NODE_OP(aggregateNode, countNode, "AGGREGATE_COUNT") aggregate.op = AGGREGATE_COUNT; 
+            NODE_OP(aggregateNode, fieldNode, "VARIABLE_NAME")
+            {
+                std::string fieldName = fieldNode->token_to_string(); 
+                for(int i = 0; i < fields.size(); i++)
+                {
+                    if(fields[i].name == fieldName) aggregate.fieldIndex = i; 
+                }
+                if(aggregate.fieldIndex == -1) throw FieldNotFound(tableGroup->parse.tableRef->common.parse.type, fieldName, fieldNode->line, fieldNode->column); 
+                Type* fieldType = fields[aggregate.fieldIndex].type; 
+                std::vector<Type*> numericTypes = {
+                    (Type*) &SupportedPrimitives::INT,
+                    (Type*) &SupportedPrimitives::LONG,
+                    (Type*) &SupportedPrimitives::SHORT,
+                    (Type*) &SupportedPrimitives::FLOAT,
+                    (Type*) &SupportedPrimitives::DOUBLE,
+                    (Type*) &SupportedPrimitives::SIZE
+                };
+                bool numeric = false; 
+                for(Type* numericType : numericTypes) numeric = numeric || typesMatch(fieldType, numericType); 
+                if(!numeric) throw AggregateFieldNotNumeric(fieldNode->line, fieldNode->column); 
+            }
+            intoTypes.push_back(aggregate.op == AGGREGATE_COUNT ? (Type*) &SupportedPrimitives::INT : fields[aggregate.fieldIndex].type); 
+            tableGroup->parse.aggregates.push_back(aggregate); 
+        }
+        NODE_OP(node, intoNode, "GROUP_INTO")
+        {
+            NODE_OP(intoNode, tableRefNode, "TABLE_REF")
+            {
+                tableGroup->parse.intoRef = parseValueRef(tableRefNode->nodes[0], hostBlock); 
+                if(!tableGroup->parse.intoRef) return nullptr; 
+                Type* intoType = tableGroup->parse.intoRef->common.parse.type; 
+                if(intoType->common.typeClass != TYPE_TABLE) throw TableRefNotTable(tableRefNode->line, tableRefNode->column); 
+                if(intoType->table.parse.rowMajor) throw RowMajorUnsupported(tableRefNode->line, tableRefNode->column); 
+                std::vector<TableField> &intoFields = intoType->table.parse.fields; 
+                if(intoFields.size() != TableType::NUM_META_FIELDS + intoTypes.size()) throw GroupIntoMismatch(intoNode->line, intoNode->column); 
+                for(int i = 0; i < intoTypes.size(); i++)
+                {
+                    if(!typesMatch(intoFields[TableType::NUM_META_FIELDS + i].type, intoTypes[i])) throw GroupIntoMismatch(intoNode->line, intoNode->column); 
+                }
+                //Writing into the input would change the rows being read, or free them if the table grows. 
+                if(refsMatch(tableGroup->parse.intoRef, tableGroup->parse.tableRef)) throw GroupIntoInput(intoNode->line, intoNode->column); 
+            }
+        }
+        NODE_OP(node, countNode, "GROUP_COUNT")
+        {
+            tableGroup->parse.countRef = parseValueRef(countNode->nodes[0], hostBlock); 
+            if(!tableGroup->parse.countRef) return nullptr; 
+            if(!typesMatch(tableGroup->parse.countRef->common.parse.type, (Type*) &SupportedPrimitives::INT)) throw MeasureNotInteger(countNode->line, countNode->column); 
+        }
+        return tableGroup; 
+    }
+    catch(TableRefNotTable ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(FieldNotFound ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(GroupKeyNotHashable ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(AggregateFieldNotNumeric ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(GroupIntoMismatch ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(GroupIntoInput ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(RowMajorUnsupported ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    catch(MeasureNotInteger ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    return nullptr; 
+}
+
+bool tabic::parseJoinSide(ASTNode node, Block* hostBlock, ValueRef* &tableRef, int &fieldIndex)
+{
+    NODE_OP(node, tableRefNode, "TABLE_REF")
+    {
+        tableRef = parseValueRef(tableRefNode->nodes[0], hostBlock); 
+        if(!tableRef) return false; 
+        if(tableRef->common.parse.type->common.typeClass != TYPE_TABLE) throw TableRefNotTable(tableRefNode->line, tableRefNode->column); 
+    }
+    NODE_OP(node, fieldNode, "VARIABLE_NAME")
+    {
+        Type* tableType = tableRef->common.parse.type; 
+        std::string fieldName = fieldNode->token_to_string(); 
+        for(int i = 0; i < tableType->table.parse.fields.size(); i++)
+        {
+            if(tableType->table.parse.fields[i].name == fieldName) fieldIndex = i; 
+        }
+        if(fieldIndex == -1) throw FieldNotFound(tableType, fieldName, fieldNode->line, fieldNode->column); 
+        if(tableType->table.parse.rowMajor && fieldIndex >= TableType::NUM_META_FIELDS) throw RowMajorUnsupported(fieldNode->line, fieldNode->column); 
+    }
+    return true; 
+}
+
+bool tabic::isHashable(Type* type)
+{
+    while(type && type->common.typeClass == TYPE_ALIAS) type = type->alias.parse.repType; 
+    return type && (type->common.typeClass == TYPE_ADDRESS
+            || type == (Type*) &SupportedPrimitives::INT
+            || type == (Type*) &SupportedPrimitives::LONG
+            || type == (Type*) &SupportedPrimitives::SHORT
+            || type == (Type*) &SupportedPrimitives::SIZE
+            || type == (Type*) &SupportedPrimitives::CHAR
+            || type == (Type*) &SupportedPrimitives::TRUTH); 
+}
+
 tabic::Unheap* tabic::parseUnheap(ASTNode node, Block* hostBlock)
 {
     try
@@ -1822,6 +2619,51 @@ tabic::Unheap* tabic::parseUnheap(ASTNode node, Block* hostBlock)
     return nullptr; 
 }
 
+tabic::UnheapArena* tabic::parseUnheapArena(ASTNode node, Block* hostBlock)
+{
+    try
+    {
+        UnheapArena* unheapArena = new UnheapArena(node, hostBlock); 
+        NODE_OP(node, arenaNode, "VALUE_REF")
+        {
+            unheapArena->parse.arenaRef = parseArenaRef(arenaNode, hostBlock); 
+            if(!unheapArena->parse.arenaRef) return nullptr; 
+        }
+        return unheapArena; 
+    }
+    catch (ArenaRefNotArena ex)
+    {
+        std::cerr << ex.what() << std::endl;
+        std::cerr << "Line: " << ex.lineNum << "; Col: " << ex.colNum << std::endl;
+        PARSE_FAIL;
+    }
+    return nullptr; 
+}
+
+tabic::ValueRef* tabic::parseArenaRef(ASTNode node, Block* hostBlock)
+{
+    ValueRef* arenaRef = parseValueRef(node, hostBlock); 
+    if(!arenaRef) return nullptr; 
+    if(!typesMatch(arenaRef->common.parse.type, (Type*) &SupportedPrimitives::ARENA)) throw ArenaRefNotArena(node->line, node->column); 
+    return arenaRef; 
+}
+
+bool tabic::hasGrowableTable(Type* type)
+{
+    while(type && type->common.typeClass == TYPE_ALIAS) type = type->alias.parse.repType; 
+    if(!type) return false; 
+    if(type->common.typeClass == TYPE_TABLE) return type->table.parse.growable; 
+    if(type->common.typeClass == TYPE_VECTOR) return hasGrowableTable(type->vector.parse.elemType); 
+    if(type->common.typeClass == TYPE_COLLECTION)
+    {
+        for(auto &pair : type->collection.parse.members)
+        {
+            if(hasGrowableTable(pair.second.type)) return true; 
+        }
+    }
+    return false; 
+}
+
 bool tabic::typesMatch(Type* a, Type* b)
 {
     while(a->common.typeClass == TYPE_ALIAS) a = a->alias.parse.repType;
@@ -1844,3 +2686,20 @@ bool tabic::typesMatch(Type* a, Type* b)
     return true; 
 }
 
+bool tabic::refsMatch(ValueRef* a, ValueRef* b)
+{
+    if(!a || !b) return a == b; 
+    if(a->common.valueRefClass != b->common.valueRefClass) return false; 
+    //A queried address may have changed between the two references. 
+    if(a->common.parse.query || b->common.parse.query) return false; 
+    if(a->common.valueRefClass == VALUE_REF_VARIABLE)
+    {
+        return a->variable.parse.variable == b->variable.parse.variable; 
+    }
+    if(a->common.valueRefClass == VALUE_REF_MEMBER)
+    {
+        return a->member.parse.memberIndex == b->member.parse.memberIndex 
+            && refsMatch(a->common.parse.parent, b->common.parse.parent); 
+    }
+    return false; 
+}
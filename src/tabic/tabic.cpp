@@ -20,6 +20,7 @@ limitations under the License.
 #include"tabic/write.hpp"
 
 #include<iostream>
+#include<map>
 #include<vector>
 
 #ifdef WINDOWS
@@ -47,11 +48,18 @@ root slab filename:  the name of the slab containing the `main` function\n\
 flags:\n\
 -show-peg-ast: show the initial AST as produced by cpp-peglib\n\
 -show-ir: show the LLVM IR produced for each slab\n\
+--profile-tables: count the operations on each context table, and report them when the program ends\n\
+--lto: link all slabs into one module before optimising, so that functions may be inlined across slabs\n\
+-O0, -O1, -O2, -O3, -Os: the level of optimisation (-O0 by default)\n\
 \n\
 options:\n\
 -o: directory in which to place the output\n\
 -l: libraries to link with the executable\n\
 -L: extra directories in which to search for libraries\n\
+-mcpu=<cpu>: the CPU to generate code for, e.g. skylake, or native for that of the host (generic by default)\n\
+-march=<cpu>: the same as -mcpu; either is checked against the CPUs the target knows\n\
+-mattr=<features>: target features to enable or disable, e.g. +avx2,-avx512f\n\
+-j: the number of threads with which to build, optimise and emit the slabs (1 by default)\n\
 ";
 
 /** @brief Entry point for the Tabitha compiler.
@@ -100,6 +108,12 @@ int main(int argc, const char** argv)
     bool showHelp   = false; 
     bool rawBuild   = false; 
     bool cStart = false;
+    bool profileTables = false; 
+    bool lto = false; 
+    std::string optLevel = "0"; 
+    std::string targetCPU = "generic"; 
+    std::string targetFeatures = ""; 
+    int numJobs = 1; 
     {
         int cursor = 1;
         while(cursor < argc)
@@ -125,6 +139,11 @@ int main(int argc, const char** argv)
                 cursor++;
                 linkDirectories.push_back(argv[cursor]);
             }
+            else if(arg == "-j")
+            {
+                cursor++;
+                numJobs = std::atoi(argv[cursor]); 
+            }
             else if(arg == "-h" || arg == "--help")
             {
                 showHelp = true; 
@@ -145,6 +164,26 @@ int main(int argc, const char** argv)
             {
                 cStart = true; 
             }
+            else if(arg == "--profile-tables")
+            {
+                profileTables = true; 
+            }
+            else if(arg == "--lto")
+            {
+                lto = true; 
+            }
+            else if(arg == "-O0" || arg == "-O1" || arg == "-O2" || arg == "-O3" || arg == "-Os")
+            {
+                optLevel = arg.substr(2); 
+            }
+            else if(arg.rfind("-mcpu=", 0) == 0 || arg.rfind("-march=", 0) == 0)
+            {
+                targetCPU = arg.substr(arg.find("=") + 1); 
+            }
+            else if(arg.rfind("-mattr=", 0) == 0)
+            {
+                targetFeatures = arg.substr(7); 
+            }
             else
             {
                 rootSlabFilename = arg;
@@ -160,7 +199,14 @@ int main(int argc, const char** argv)
     tabic::Util::flags["show-ast"]  = showAST; 
     tabic::Util::flags["show-ir"]   = showIR; 
     tabic::Util::flags["c-start"] = cStart;
+    tabic::Util::flags["profile-tables"] = profileTables; 
+    tabic::Util::flags["raw"] = rawBuild; 
+    tabic::Util::flags["lto"] = lto; 
     tabic::Util::options["o"]       = new std::string(outputDirectory); 
+    tabic::Util::options["O"]       = new std::string(optLevel); 
+    tabic::Util::options["mcpu"]    = new std::string(targetCPU); 
+    tabic::Util::options["mattr"]   = new std::string(targetFeatures); 
+    tabic::Util::options["j"]       = new int(numJobs); 
     tabic::Util::args["rootSlabFilename"] = new std::string(rootSlabFilename); 
 
     tabic::Bundle* bundle;
@@ -168,8 +214,23 @@ int main(int argc, const char** argv)
     if(createStatus == tabic::CREATE_STATUS_FAIL) return 1;
     tabic::ParseStatus parseStatus = tabic::parseBundle(bundle); 
     if(parseStatus == tabic::PARSE_STATUS_FAIL) return 2; 
-    tabic::buildBundle(bundle);
-    tabic::writeBundle(bundle);
+    //Each slab is written as soon as it is built, by the thread which built it. 
+    if(!tabic::beginWrite()) return 3; 
+    if(numJobs > 1)
+    {
+        //Each other thread creates and parses its own copy of the bundle, from the sources already read and preprocessed. 
+        std::map<std::string, std::string> sources; 
+        for(auto pair : bundle->create.slabs) sources[pair.first] = pair.second->create.source; 
+        tabic::buildBundleInParallel(bundle, numJobs, [&]() -> tabic::Bundle*
+        {
+            tabic::Bundle* copy; 
+            if(tabic::createBundle(rootSlabFilename, CWD, &copy, &sources) == tabic::CREATE_STATUS_FAIL) return nullptr; 
+            if(tabic::parseBundle(copy) == tabic::PARSE_STATUS_FAIL) return nullptr; 
+            return copy; 
+        }, tabic::writeSlab); 
+    }
+    else tabic::buildBundle(bundle, tabic::writeSlab);
+    tabic::endWrite(); 
     
     //Now link everything
     std::string linkCommand; 
@@ -27,6 +27,14 @@ limitations under the License.
 #include"llvm/IR/PassManager.h"
 #include"llvm/IR/LegacyPassManager.h"
 #include"llvm/MC/TargetRegistry.h"
+#include"llvm/MC/MCSubtargetInfo.h"
+#include"llvm/Passes/PassBuilder.h"
+#include"llvm/Passes/OptimizationLevel.h"
+#include"llvm/Analysis/TargetLibraryInfo.h"
+#include"llvm/Linker/Linker.h"
+#include"llvm/IRReader/IRReader.h"
+#include"llvm/Support/SourceMgr.h"
+#include"llvm/Transforms/IPO/Internalize.h"
 
 #include"llvm/IR/Verifier.h"
 #include"llvm/Support/ToolOutputFile.h"
@@ -35,85 +43,270 @@ limitations under the License.
 #include<sys/types.h>
 #include<sys/stat.h>
 
+#include<algorithm>
+#include<mutex>
+
 #ifdef WINDOWS
 #include<windows.h> 
 #else
 #include<unistd.h>
 #endif
 
+static const llvm::Target* target = nullptr; 
+
+//Given -j N, the slabs are written from several threads, which share the list of bitcode files for --lto and standard output. 
+static std::mutex writeMutex; 
+
+/** @brief Creates a TargetMachine for the host triple, with the CPU, features and level given to tabic. 
+ *
+ * Each module gets its own, as a TargetMachine is not to be shared between threads. 
+ */
+static std::unique_ptr<llvm::TargetMachine> createTargetMachine()
+{
+    auto target_triple = llvm::sys::getDefaultTargetTriple();
+    llvm::TargetOptions opt; 
+    auto RM = llvm::Optional<llvm::Reloc::Model>();
+    RM = llvm::Reloc::Model::PIC_;
+    return std::unique_ptr<llvm::TargetMachine>(target->createTargetMachine(
+                target_triple, tabic::getTargetCPU(), tabic::getTargetFeatures(), opt, RM, llvm::None, tabic::getCodeGenOptLevel()));
+}
+
+static void emitObject(llvm::Module* module, llvm::TargetMachine* targetMachine, std::string path)
+{
+    std::error_code EC;
+    llvm::raw_fd_ostream objOut(path, EC, llvm::sys::fs::OF_Text);
+    llvm::legacy::PassManager pass;
+    auto FileType = llvm::CGFT_ObjectFile;
+    targetMachine->addPassesToEmitFile(pass, objOut, nullptr, FileType); 
+    pass.run(*module);
+    objOut.flush();
+}
+
+//Given --lto, the bitcode files written for the slabs, which endWrite links. 
+static std::vector<std::string> ltoBitcodeFiles; 
+static const char* LTO_OBJECT = "lto.o"; 
+
+/** @brief Links the bitcode of every slab into one module, and optimises and emits it as a whole, as LTO_OBJECT. 
+ *
+ * Everything but the entry points the runtime calls is made internal to the program, 
+ * so that it may be inlined across slabs, or dropped if unused. 
+ */
+static void writeLinked()
+{
+    std::string outputDirectory = *(std::string*)tabic::Util::options.at("o");  
+    llvm::LLVMContext context; 
+    std::unique_ptr<llvm::Module> linked = std::make_unique<llvm::Module>("lto", context); 
+    llvm::Linker linker(*linked); 
+    //The slabs are written in any order, so they are linked in a fixed one. 
+    std::sort(ltoBitcodeFiles.begin(), ltoBitcodeFiles.end()); 
+    for(std::string &bcPath : ltoBitcodeFiles)
+    {
+        llvm::SMDiagnostic diagnostic; 
+        std::unique_ptr<llvm::Module> module = llvm::parseIRFile(bcPath, diagnostic, context); 
+        if(!module) diagnostic.print("tabic", llvm::errs()); 
+        else if(linker.linkInModule(std::move(module))) std::cerr << "Failed to link " << bcPath << std::endl; 
+    }
+    ltoBitcodeFiles.clear(); 
+    llvm::internalizeModule(*linked, [](const llvm::GlobalValue &value)
+    {
+        return value.getName() == "_tabi_main" || value.getName() == "_tabi_init" || value.getName() == "_tabi_destroy"; 
+    }); 
+    std::unique_ptr<llvm::TargetMachine> targetMachine = createTargetMachine(); 
+    linked->setDataLayout(targetMachine->createDataLayout());
+    linked->setTargetTriple(llvm::sys::getDefaultTargetTriple());
+    tabic::optimiseModule(linked.get(), targetMachine.get(), true); 
+    emitObject(linked.get(), targetMachine.get(), outputDirectory + "/" + LTO_OBJECT); 
+}
+
+bool tabic::beginWrite()
+{
+    //The targets are set up once, for all slabs, whichever thread writes them. 
+    llvm::InitializeAllTargetInfos();
+    llvm::InitializeAllTargets();
+    llvm::InitializeAllTargetMCs();
+    llvm::InitializeAllAsmParsers();
+    llvm::InitializeAllAsmPrinters();
+    std::string err;
+    target = llvm::TargetRegistry::lookupTarget(llvm::sys::getDefaultTargetTriple(), err);
+    //LLVM would quietly generate code for a generic CPU in place of one it does not know. 
+    std::string cpu = getTargetCPU(); 
+    std::unique_ptr<llvm::MCSubtargetInfo> subtargetInfo(target->createMCSubtargetInfo(llvm::sys::getDefaultTargetTriple(), "", "")); 
+    if(!subtargetInfo->isCPUStringValid(cpu))
+    {
+        std::cerr << "Unknown CPU for -mcpu/-march: " << cpu << std::endl; 
+        return false; 
+    }
+
+    //The output directory is also created once, rather than by each thread writing a slab. 
+    std::string outputDirectory = *(std::string*)Util::options.at("o");  
+#ifdef WINDOWS
+    CreateDirectory((LPCSTR)outputDirectory.c_str(), NULL);
+#else
+    struct stat st = {0};
+    if(stat(outputDirectory.c_str(), &st) == -1)
+    {
+        mkdir(outputDirectory.c_str(), 0700); 
+    }
+#endif
+    return true; 
+}
+
+void tabic::endWrite()
+{
+    if(Util::flags.at("lto")) writeLinked(); 
+    else llvm::sys::fs::remove(*(std::string*)Util::options.at("o") + "/" + LTO_OBJECT); 
+}
+
 void tabic::writeBundle(Bundle* bundle)
 {
+    if(!beginWrite()) return; 
     for(auto pair : bundle->create.slabs)
     {
         Slab* slab = pair.second;
         writeSlab(slab);
     }
+    endWrite(); 
 }
 
 void tabic::writeSlab(Slab* slab)
 {
-    if(Util::flags["show-ir"])
+    prepareSlab(slab); 
+    writeModule(slab->build.llvmModule, getSlabFilename(slab)); 
+}
+
+void tabic::prepareSlab(Slab* slab)
+{
+    if(Util::flags.at("show-ir"))
     {
         std::string ir; 
         llvm::raw_string_ostream OS(ir); 
         slab->build.llvmModule->print(OS, new llvm::AssemblyAnnotationWriter);
+        std::lock_guard<std::mutex> lock(writeMutex); 
         std::cout << ir << std::endl; 
     } 
     
     //verify IR
     llvm::verifyModule(*slab->build.llvmModule);
+}
 
-    std::string bcFilename  = slab->create.id + ".bc";
-    std::string objFilename = slab->create.id + ".o";
-    for(int i = 0; i < bcFilename.length(); i++)
+std::string tabic::getSlabFilename(Slab* slab)
+{
+    std::string filename = slab->create.id; 
+    for(int i = 0; i < filename.length(); i++)
     {
-        if(bcFilename[i] == '/') 
-        {
-            bcFilename[i] = '_';
-            objFilename[i] = '_'; 
-        }
+        if(filename[i] == '/') filename[i] = '_';
     }
+    return filename; 
+}
 
-    std::string outputDirectory = *(std::string*)Util::options["o"];  
+void tabic::writeModule(llvm::Module* module, std::string filename)
+{
+    std::string bcFilename  = filename + ".bc";
+    std::string objFilename = filename + ".o";
+    std::string outputDirectory = *(std::string*)Util::options.at("o");  
 
-#ifdef WINDOWS
-    CreateDirectory((LPCSTR)outputDirectory.c_str(), NULL);
-#else
-    struct stat st = {0};
-    if(stat(outputDirectory.c_str(), &st) == -1)
+    std::unique_ptr<llvm::TargetMachine> target_machine = createTargetMachine(); 
+    module->setDataLayout(target_machine->createDataLayout());
+    module->setTargetTriple(llvm::sys::getDefaultTargetTriple());
+    //The optimiser (e.g. the loop vectoriser) reads the target of each function from its attributes. 
+    for(llvm::Function &function : *module)
     {
-        mkdir(outputDirectory.c_str(), 0700); 
+        if(function.isDeclaration()) continue; 
+        function.addFnAttr("target-cpu", target_machine->getTargetCPU()); 
+        if(!target_machine->getTargetFeatureString().empty()) function.addFnAttr("target-features", target_machine->getTargetFeatureString()); 
     }
-#endif
+    optimiseModule(module, target_machine.get()); 
 
+    //The bitcode is written once optimised, as the object file is. 
     std::error_code EC;
     llvm::raw_fd_ostream OS(outputDirectory + "/" + bcFilename, EC, llvm::sys::fs::OpenFlags::OF_None);
-    llvm::WriteBitcodeToFile(*slab->build.llvmModule, OS);
+    llvm::WriteBitcodeToFile(*module, OS);
     OS.flush(); 
 
+    //Given --lto, the object file is emitted once all slabs are linked. 
+    //Any left from an earlier build would be linked into the executable as well, so is removed. 
+    if(Util::flags.at("lto"))
+    {
+        llvm::sys::fs::remove(outputDirectory + "/" + objFilename); 
+        std::lock_guard<std::mutex> lock(writeMutex); 
+        ltoBitcodeFiles.push_back(outputDirectory + "/" + bcFilename); 
+        return; 
+    }
+    emitObject(module, target_machine.get(), outputDirectory + "/" + objFilename); 
+}
 
-    //emitting object code
-    auto target_triple = llvm::sys::getDefaultTargetTriple();
-    llvm::InitializeAllTargetInfos();
-    llvm::InitializeAllTargets();
-    llvm::InitializeAllTargetMCs();
-    llvm::InitializeAllAsmParsers();
-    llvm::InitializeAllAsmPrinters();
-    std::string err;
-    auto target = llvm::TargetRegistry::lookupTarget(target_triple, err);
-    auto CPU = "generic";
-    auto Features = "";
-    llvm::TargetOptions opt; 
-    auto RM = llvm::Optional<llvm::Reloc::Model>();
-    RM = llvm::Reloc::Model::PIC_;
-    auto target_machine = target->createTargetMachine(target_triple, CPU, Features, opt, RM);
-    slab->build.llvmModule->setDataLayout(target_machine->createDataLayout());
-    slab->build.llvmModule->setTargetTriple(target_triple);
-    llvm::raw_fd_ostream objOut(outputDirectory + "/" + objFilename, EC, llvm::sys::fs::OF_Text);
-    llvm::legacy::PassManager pass;
-    auto FileType = llvm::CGFT_ObjectFile;
-    target_machine->addPassesToEmitFile(pass, objOut, nullptr, FileType); 
-    pass.run(*slab->build.llvmModule);
-    objOut.flush();
+std::string tabic::getTargetCPU()
+{
+    std::string cpu = *(std::string*)Util::options.at("mcpu"); 
+    if(cpu == "native") return llvm::sys::getHostCPUName().str(); 
+    return cpu; 
 }
 
+std::string tabic::getTargetFeatures()
+{
+    std::string features = ""; 
+    if(*(std::string*)Util::options.at("mcpu") == "native")
+    {
+        llvm::StringMap<bool> hostFeatures; 
+        if(llvm::sys::getHostCPUFeatures(hostFeatures))
+        {
+            for(auto &feature : hostFeatures)
+            {
+                if(!features.empty()) features += ","; 
+                features += (feature.second ? "+" : "-") + feature.first().str(); 
+            }
+        }
+    }
+    //Those given with -mattr come last, so that they override the host's. 
+    std::string extra = *(std::string*)Util::options.at("mattr"); 
+    if(!extra.empty())
+    {
+        if(!features.empty()) features += ","; 
+        features += extra; 
+    }
+    return features; 
+}
+
+llvm::CodeGenOpt::Level tabic::getCodeGenOptLevel()
+{
+    std::string level = *(std::string*)Util::options.at("O"); 
+    if(level == "0") return llvm::CodeGenOpt::None; 
+    if(level == "1") return llvm::CodeGenOpt::Less; 
+    if(level == "3") return llvm::CodeGenOpt::Aggressive; 
+    return llvm::CodeGenOpt::Default; 
+}
+
+void tabic::optimiseModule(llvm::Module* module, llvm::TargetMachine* targetMachine, bool linked)
+{
+    std::string level = *(std::string*)Util::options.at("O"); 
+    if(level == "0") return; 
+    llvm::OptimizationLevel optLevel = llvm::OptimizationLevel::O2; 
+    if(level == "1") optLevel = llvm::OptimizationLevel::O1; 
+    else if(level == "3") optLevel = llvm::OptimizationLevel::O3; 
+    else if(level == "s") optLevel = llvm::OptimizationLevel::Os; 
+
+    llvm::LoopAnalysisManager LAM; 
+    llvm::FunctionAnalysisManager FAM; 
+    llvm::CGSCCAnalysisManager CGAM; 
+    llvm::ModuleAnalysisManager MAM; 
+    llvm::PassBuilder passBuilder(targetMachine); 
+    //A raw build has no libc to link against, so the optimiser must not turn loops into calls to e.g. memset. 
+    //This is registered ahead of the default analyses, which then leave it be. 
+    llvm::TargetLibraryInfoImpl libraryInfo(llvm::Triple(module->getTargetTriple())); 
+    if(Util::flags.at("raw"))
+    {
+        libraryInfo.disableAllFunctions(); 
+        FAM.registerPass([&] { return llvm::TargetLibraryAnalysis(libraryInfo); }); 
+    }
+    passBuilder.registerModuleAnalyses(MAM); 
+    passBuilder.registerCGSCCAnalyses(CGAM); 
+    passBuilder.registerFunctionAnalyses(FAM); 
+    passBuilder.registerLoopAnalyses(LAM); 
+    passBuilder.crossRegisterProxies(LAM, FAM, CGAM, MAM); 
+    //Given --lto, each slab is only readied for linking, and the linked module optimised as a whole. 
+    llvm::ModulePassManager passManager; 
+    if(linked) passManager = passBuilder.buildLTODefaultPipeline(optLevel, nullptr); 
+    else if(Util::flags.at("lto")) passManager = passBuilder.buildLTOPreLinkDefaultPipeline(optLevel); 
+    else passManager = passBuilder.buildPerModuleDefaultPipeline(optLevel); 
+    passManager.run(*module, MAM); 
+}